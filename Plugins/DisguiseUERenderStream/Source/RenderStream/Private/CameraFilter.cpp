@@ -0,0 +1,108 @@
+#include "CameraFilter.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+
+    // Speed of each component in the units beta is given in.
+    const double SpeedScale[CameraFilter::ComponentCount] = { 10., 10., 10., 0.1, 0.1, 0.1, 0.1 };
+
+    bool isRotation(size_t component)
+    {
+        return component >= 3 && component < 6;
+    }
+
+    // Smoothing factor of an exponential low-pass filter with the given cutoff, sampled dt apart.
+    double smoothing(double cutoff, double dt)
+    {
+        const double tau = 1. / (2. * Pi * cutoff);
+        return 1. / (1. + tau / dt);
+    }
+
+    float* component(RenderStreamLink::CameraData& camera, size_t c)
+    {
+        float* const components[CameraFilter::ComponentCount] = { &camera.x, &camera.y, &camera.z, &camera.rx, &camera.ry, &camera.rz, &camera.focalLength };
+        return components[c];
+    }
+}
+
+void CameraFilter::configure(const Settings& settings)
+{
+    m_settings = settings;
+    reset();
+}
+
+void CameraFilter::reset()
+{
+    m_primed = false;
+    m_stats = Stats();
+}
+
+bool CameraFilter::samePose(const RenderStreamLink::CameraData& a, const RenderStreamLink::CameraData& b)
+{
+    // Bitwise, as a repeated sample is an exact copy.
+    return a.cameraHandle == b.cameraHandle &&
+        std::memcmp(&a.x, &b.x, sizeof(float) * 13) == 0;
+}
+
+CameraFilter::Result CameraFilter::filter(double tTracked, double frameDelta, RenderStreamLink::CameraData& camera)
+{
+    if (!m_settings.rejectStale && !m_settings.smooth)
+        return Result::Accepted;
+
+    const double dt = tTracked - m_t;
+    if (m_primed && m_settings.rejectStale && dt <= 0. && dt > -MaxGap)
+    {
+        const bool duplicate = samePose(camera, m_lastInput);
+        if (duplicate || dt < 0.)
+        {
+            camera = m_lastOutput;
+            if (duplicate)
+                ++m_stats.duplicates;
+            else
+                ++m_stats.outOfOrder;
+            return duplicate ? Result::Duplicate : Result::OutOfOrder;
+        }
+    }
+
+    // Tracking that stopped for a while or started a new timeline is taken as it is.
+    const double step = dt > 0. ? dt : frameDelta;
+    if (std::fabs(dt) > MaxGap || step <= 0.)
+        m_primed = false;
+
+    ++m_stats.accepted;
+    m_lastInput = camera;
+    m_t = tTracked;
+
+    for (size_t c = 0; c < ComponentCount; ++c)
+    {
+        Component& state = m_components[c];
+        float& value = *component(camera, c);
+        double x = value;
+        if (m_primed && isRotation(c))
+            x = state.raw + std::remainder(x - state.raw, 360.);
+
+        if (!m_primed || !m_settings.smooth)
+        {
+            state.raw = x;
+            state.value = x;
+            state.speed = 0.;
+            continue;
+        }
+
+        const double speed = (x - state.raw) / step;
+        state.speed += smoothing(m_settings.derivativeCutoff, step) * (speed - state.speed);
+        const double cutoff = m_settings.minCutoff + m_settings.beta * std::fabs(state.speed) * SpeedScale[c];
+        state.value += smoothing(cutoff, step) * (x - state.value);
+        state.raw = x;
+
+        value = float(isRotation(c) ? std::remainder(state.value, 360.) : state.value);
+    }
+
+    m_primed = true;
+    m_lastOutput = camera;
+    return Result::Accepted;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Cleans up tracked cameras from d3 before they are applied. Samples are ordered by tTracked: one that repeats the
+// last pose, or that is older than the last accepted one, is rejected and the last output is kept. Accepted samples
+// can then be smoothed with a One Euro filter per component (Casiez et al. 2012), a low-pass filter whose cutoff rises
+// with speed, so that a still camera is steady and a moving one barely lags.
+class CameraFilter
+{
+public:
+    struct Settings
+    {
+        bool rejectStale = true;
+        bool smooth = false;
+        double minCutoff = 1.;          // Hz, of a still camera
+        // Hz added to the cutoff per unit of speed, a unit being 10 cm/s, 10 degrees/s or 10 mm/s of focal length.
+        double beta = 1.;
+        double derivativeCutoff = 1.;   // Hz, of the speed estimate
+    };
+
+    enum class Result { Accepted, Duplicate, OutOfOrder };
+
+    struct Stats
+    {
+        uint64_t accepted = 0;
+        uint64_t duplicates = 0;
+        uint64_t outOfOrder = 0;
+    };
+
+    static constexpr size_t ComponentCount = 7;     // x, y, z, rx, ry, rz, focalLength
+    static constexpr double MaxGap = 1.;            // Seconds tTracked may move either way before filtering starts again
+
+    void configure(const Settings& settings);
+    void reset();
+
+    // Filters camera, tracked at tTracked, in place. When tTracked does not advance but the pose does, as when the
+    // tracking source has no timestamps, frameDelta stands in for the time between samples.
+    Result filter(double tTracked, double frameDelta, RenderStreamLink::CameraData& camera);
+
+    const Settings& settings() const { return m_settings; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Component
+    {
+        double raw = 0.;        // Last accepted input, rotations unwrapped
+        double value = 0.;      // Filtered
+        double speed = 0.;      // Filtered derivative
+    };
+
+    static bool samePose(const RenderStreamLink::CameraData& a, const RenderStreamLink::CameraData& b);
+
+    Settings m_settings;
+    Stats m_stats;
+    bool m_primed = false;
+    double m_t = 0.;
+    RenderStreamLink::CameraData m_lastInput;
+    RenderStreamLink::CameraData m_lastOutput;
+    Component m_components[ComponentCount];
+};
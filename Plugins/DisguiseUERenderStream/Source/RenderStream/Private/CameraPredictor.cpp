@@ -0,0 +1,168 @@
+#include "CameraPredictor.hpp"
+
+#include <cmath>
+
+namespace
+{
+    bool isRotation(size_t component)
+    {
+        return component >= 3 && component < 6;
+    }
+
+    // Kalman noise per component: the spread of tracked values around the truth, and how hard the camera may
+    // accelerate, as white noise acceleration. Metres, degrees and millimetres.
+    const double MeasurementSigma[CameraPredictor::ComponentCount] = { 0.0005, 0.0005, 0.0005, 0.02, 0.02, 0.02, 0.05 };
+    const double ProcessDensity[CameraPredictor::ComponentCount] = { 4., 4., 4., 4e4, 4e4, 4e4, 100. };
+}
+
+void CameraPredictor::configure(Model model, double horizon)
+{
+    m_model = model;
+    m_horizon = horizon > 0. ? horizon : 0.;
+    reset();
+}
+
+void CameraPredictor::reset()
+{
+    m_count = 0;
+}
+
+void CameraPredictor::read(const RenderStreamLink::CameraData& camera, double* values)
+{
+    values[0] = camera.x;
+    values[1] = camera.y;
+    values[2] = camera.z;
+    values[3] = camera.rx;
+    values[4] = camera.ry;
+    values[5] = camera.rz;
+    values[6] = camera.focalLength;
+}
+
+void CameraPredictor::write(const double* values, RenderStreamLink::CameraData& camera)
+{
+    camera.x = float(values[0]);
+    camera.y = float(values[1]);
+    camera.z = float(values[2]);
+    camera.rx = float(values[3]);
+    camera.ry = float(values[4]);
+    camera.rz = float(values[5]);
+    camera.focalLength = float(values[6]);
+}
+
+void CameraPredictor::add(double t, const double* values)
+{
+    if (m_count > 0 && t - m_history[2].t > MaxGap)
+        m_count = 0;
+
+    Sample sample;
+    sample.t = t;
+    for (size_t c = 0; c < ComponentCount; ++c)
+    {
+        sample.values[c] = values[c];
+        if (m_count > 0 && isRotation(c))
+        {
+            // Continue from the previous angle, whichever way round is shorter.
+            const double previous = m_history[2].values[c];
+            sample.values[c] = previous + std::remainder(values[c] - previous, 360.);
+        }
+    }
+
+    if (m_model == Model::Kalman)
+    {
+        const double dt = m_count > 0 ? t - m_history[2].t : 0.;
+        for (size_t c = 0; c < ComponentCount; ++c)
+        {
+            Filter& f = m_filters[c];
+            const double r = MeasurementSigma[c] * MeasurementSigma[c];
+            if (m_count == 0)
+            {
+                f.x = sample.values[c];
+                f.v = 0.;
+                f.p00 = r;
+                f.p01 = 0.;
+                f.p11 = ProcessDensity[c] * MaxGap;
+                continue;
+            }
+
+            // Predict.
+            const double q = ProcessDensity[c];
+            f.x += f.v * dt;
+            f.p00 += dt * (2. * f.p01 + dt * f.p11) + q * dt * dt * dt / 3.;
+            f.p01 += dt * f.p11 + q * dt * dt / 2.;
+            f.p11 += q * dt;
+
+            // Update with the tracked value.
+            const double s = f.p00 + r;
+            const double k0 = f.p00 / s;
+            const double k1 = f.p01 / s;
+            const double y = sample.values[c] - f.x;
+            f.x += k0 * y;
+            f.v += k1 * y;
+            f.p11 -= k1 * f.p01;
+            f.p01 -= k0 * f.p01;
+            f.p00 -= k0 * f.p00;
+        }
+    }
+
+    m_history[0] = m_history[1];
+    m_history[1] = m_history[2];
+    m_history[2] = sample;
+    if (m_count < 3)
+        ++m_count;
+}
+
+double CameraPredictor::extrapolate(size_t c, double t) const
+{
+    const Sample& s2 = m_history[2];
+    const double h = t - s2.t;
+    switch (m_model)
+    {
+    case Model::ConstantVelocity:
+    case Model::ConstantAcceleration:
+    {
+        if (m_count < 2)
+            return s2.values[c];
+        const Sample& s1 = m_history[1];
+        const double v1 = (s2.values[c] - s1.values[c]) / (s2.t - s1.t);
+        if (m_model == Model::ConstantVelocity || m_count < 3)
+            return s2.values[c] + v1 * h;
+        // Newton form of the quadratic through the three poses.
+        const Sample& s0 = m_history[0];
+        const double v0 = (s1.values[c] - s0.values[c]) / (s1.t - s0.t);
+        const double a = (v1 - v0) / (s2.t - s0.t);
+        return s2.values[c] + v1 * h + a * h * (t - s1.t);
+    }
+    case Model::Kalman:
+        return m_filters[c].x + m_filters[c].v * h;
+    default:
+        return s2.values[c];
+    }
+}
+
+RenderStreamLink::CameraData CameraPredictor::predict(double tTracked, const RenderStreamLink::CameraData& camera)
+{
+    if (m_model == Model::None)
+        return camera;
+
+    double values[ComponentCount];
+    read(camera, values);
+    if (m_count == 0 || tTracked > m_history[2].t)
+        add(tTracked, values);
+    else if (m_history[2].t - tTracked > MaxGap)
+    {
+        // The clock went back, as when d3 restarts its timeline.
+        reset();
+        add(tTracked, values);
+    }
+
+    RenderStreamLink::CameraData predicted = camera;
+    for (size_t c = 0; c < ComponentCount; ++c)
+    {
+        values[c] = extrapolate(c, tTracked + m_horizon);
+        // Back into the range d3 sent, for the response.
+        if (isRotation(c))
+            values[c] = std::remainder(values[c], 360.);
+    }
+    write(values, predicted);
+    return predicted;
+}
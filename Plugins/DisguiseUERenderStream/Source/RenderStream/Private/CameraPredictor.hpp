@@ -0,0 +1,61 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Extrapolates the camera d3 tracked at tTracked to the time the frame is expected on screen, horizon seconds later.
+// Position, rotation and focal length are each extrapolated on their own from a short history of tracked poses, the
+// rotations unwrapped so that crossing +-180 degrees does not read as a spin. The other fields pass through.
+class CameraPredictor
+{
+public:
+    enum class Model : uint8_t
+    {
+        None,                   // The tracked pose as it is
+        ConstantVelocity,       // From the last two poses
+        ConstantAcceleration,   // Quadratic through the last three poses
+        Kalman,                 // Constant velocity Kalman filter per component, smooths as well as extrapolating
+    };
+
+    static constexpr size_t ComponentCount = 7;     // x, y, z, rx, ry, rz, focalLength
+    static constexpr double MaxGap = 0.25;          // Seconds between poses after which the history starts again
+
+    void configure(Model model, double horizon);
+    void reset();
+
+    Model model() const { return m_model; }
+    double horizon() const { return m_horizon; }
+
+    // Adds the pose tracked at tTracked and returns the one predicted for tTracked + horizon. A pose that is not newer
+    // than the last is not added, but is still predicted from the history.
+    RenderStreamLink::CameraData predict(double tTracked, const RenderStreamLink::CameraData& camera);
+
+private:
+    struct Sample
+    {
+        double t = 0.;
+        double values[ComponentCount] = {};    // Rotations unwrapped
+    };
+
+    // Constant velocity state with its covariance, per component.
+    struct Filter
+    {
+        double x = 0.;
+        double v = 0.;
+        double p00 = 0., p01 = 0., p11 = 0.;
+    };
+
+    static void read(const RenderStreamLink::CameraData& camera, double* values);
+    static void write(const double* values, RenderStreamLink::CameraData& camera);
+    void add(double t, const double* values);
+    double extrapolate(size_t component, double t) const;
+
+    Model m_model = Model::None;
+    double m_horizon = 0.;
+
+    Sample m_history[3];    // Oldest first, the last m_count in use
+    size_t m_count = 0;
+    Filter m_filters[ComponentCount];
+};
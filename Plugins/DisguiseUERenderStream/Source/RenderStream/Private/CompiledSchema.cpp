@@ -0,0 +1,202 @@
+#include "CompiledSchema.hpp"
+#include "SchemaJson.hpp"
+#include "fnv.hpp"
+
+#include <cstring>
+
+// Layout, little-endian:
+//   magic[8] | sourceSize u64 | sourceHash u64 | sceneCount u32 | scene... | checksum u64
+//   scene:  name | nPersistentParameters u32 | nLevelParameters u32 | hash u64 | keyData | keyCount u32 | keyEnd u32...
+//   string: length u32 | bytes
+// The checksum is fnvHash of everything before it.
+
+namespace
+{
+    const char Magic[8] = { 'R', 'S', 'S', 'C', 'H', 'M', '0', '2' };
+
+    class Writer
+    {
+    public:
+        explicit Writer(std::vector<uint8_t>& out) : m_out(out) {}
+
+        void bytes(const void* data, size_t size)
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            m_out.insert(m_out.end(), p, p + size);
+        }
+        void u32(uint32_t value) { bytes(&value, sizeof(value)); }
+        void u64(uint64_t value) { bytes(&value, sizeof(value)); }
+        void string(const std::string& value)
+        {
+            u32(uint32_t(value.size()));
+            bytes(value.data(), value.size());
+        }
+
+    private:
+        std::vector<uint8_t>& m_out;
+    };
+
+    // Every read is bounds checked, a short or damaged file fails instead of reading past the end.
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+        bool bytes(void* out, size_t size)
+        {
+            if (size > m_size - m_offset)
+                return false;
+            std::memcpy(out, m_data + m_offset, size);
+            m_offset += size;
+            return true;
+        }
+        bool u32(uint32_t& value) { return bytes(&value, sizeof(value)); }
+        bool u64(uint64_t& value) { return bytes(&value, sizeof(value)); }
+        bool string(std::string& value)
+        {
+            uint32_t length;
+            if (!u32(length) || length > m_size - m_offset)
+                return false;
+            value.assign(reinterpret_cast<const char*>(m_data + m_offset), length);
+            m_offset += length;
+            return true;
+        }
+        // Counts are checked against what is left before anything is reserved for them.
+        bool count(uint32_t& value, size_t minimumBytes)
+        {
+            return u32(value) && value <= (m_size - m_offset) / minimumBytes;
+        }
+        size_t offset() const { return m_offset; }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_offset = 0;
+    };
+
+    class Compiler : public SchemaReader::Handler
+    {
+    public:
+        explicit Compiler(std::vector<CompiledSchema::Scene>& scenes) : m_scenes(scenes) {}
+
+        void beginScene() override
+        {
+            m_scenes.emplace_back();
+        }
+        void key(const char* key, size_t size) override
+        {
+            m_scenes.back().addKey(key, size);
+        }
+        void endScene(const char* name, size_t nameSize, uint32_t nPersistentParameters, uint32_t nLevelParameters, uint64_t hash) override
+        {
+            CompiledSchema::Scene& scene = m_scenes.back();
+            scene.name.assign(name, nameSize);
+            scene.nPersistentParameters = nPersistentParameters;
+            scene.nLevelParameters = nLevelParameters;
+            scene.hash = hash;
+        }
+
+    private:
+        std::vector<CompiledSchema::Scene>& m_scenes;
+    };
+}
+
+bool CompiledSchema::Scene::keyEquals(size_t i, const std::string& key) const
+{
+    const size_t begin = keyBegin(i);
+    return keyEnds[i] - begin == key.size() && std::memcmp(keyData.data() + begin, key.data(), key.size()) == 0;
+}
+
+void CompiledSchema::Scene::addKey(const char* key, size_t size)
+{
+    keyData.append(key, size);
+    keyEnds.push_back(uint32_t(keyData.size()));
+}
+
+uint64_t CompiledSchema::Scene::keysHash(size_t count) const
+{
+    if (count >= keyCount())
+        return hash;
+    // Keys hash as if they were one buffer, however they are split.
+    StreamFNV fnv;
+    fnv.addData(reinterpret_cast<const unsigned char*>(keyData.data()), count ? keyEnds[count - 1] : 0);
+    return fnv.getHash();
+}
+
+bool CompiledSchema::parse(const char* text, size_t size, std::string& error)
+{
+    std::vector<Scene> parsed;
+    Compiler compiler(parsed);
+    SchemaReader reader;
+    if (!reader.read(text, size, compiler))
+    {
+        error = std::string(reader.error()) + " at offset " + std::to_string(reader.errorOffset());
+        return false;
+    }
+    scenes = std::move(parsed);
+    return true;
+}
+
+std::vector<uint8_t> CompiledSchema::serialise() const
+{
+    std::vector<uint8_t> out;
+    Writer writer(out);
+    writer.bytes(Magic, sizeof(Magic));
+    writer.u64(sourceSize);
+    writer.u64(sourceHash);
+    writer.u32(uint32_t(scenes.size()));
+    for (const Scene& scene : scenes)
+    {
+        writer.string(scene.name);
+        writer.u32(scene.nPersistentParameters);
+        writer.u32(scene.nLevelParameters);
+        writer.u64(scene.hash);
+        writer.string(scene.keyData);
+        writer.u32(uint32_t(scene.keyEnds.size()));
+        for (uint32_t end : scene.keyEnds)
+            writer.u32(end);
+    }
+    writer.u64(fnvHash(out.data(), out.size()));
+    return out;
+}
+
+bool CompiledSchema::deserialise(const uint8_t* data, size_t size)
+{
+    if (size < sizeof(Magic) + sizeof(uint64_t) || std::memcmp(data, Magic, sizeof(Magic)) != 0)
+        return false;
+
+    const size_t payload = size - sizeof(uint64_t);
+    uint64_t checksum;
+    std::memcpy(&checksum, data + payload, sizeof(checksum));
+    if (checksum != fnvHash(data, payload))
+        return false;
+
+    Reader reader(data + sizeof(Magic), payload - sizeof(Magic));
+    CompiledSchema schema;
+    uint32_t sceneCount;
+    if (!reader.u64(schema.sourceSize) || !reader.u64(schema.sourceHash) || !reader.count(sceneCount, 28))
+        return false;
+    schema.scenes.resize(sceneCount);
+    for (Scene& scene : schema.scenes)
+    {
+        uint32_t keyCount;
+        if (!reader.string(scene.name) || !reader.u32(scene.nPersistentParameters) || !reader.u32(scene.nLevelParameters) ||
+            !reader.u64(scene.hash) || !reader.string(scene.keyData) || !reader.count(keyCount, 4))
+        {
+            return false;
+        }
+        scene.keyEnds.resize(keyCount);
+        uint32_t previous = 0;
+        for (uint32_t& end : scene.keyEnds)
+        {
+            if (!reader.u32(end) || end < previous || end > scene.keyData.size())
+                return false;
+            previous = end;
+        }
+    }
+    if (reader.offset() != payload - sizeof(Magic))
+        return false;
+
+    *this = std::move(schema);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The part of schema.json that scenes are validated with: their names, parameter keys and how the keys split between
+// the persistent level and the scene's own level. Saved next to the JSON as a compact binary file tagged with the
+// size and hash of the JSON it was compiled from, so that while the JSON is unchanged loading it skips the parse.
+struct CompiledSchema
+{
+    struct Scene
+    {
+        std::string name;                       // UTF-8, as are the keys
+        uint32_t nPersistentParameters = 0;
+        uint32_t nLevelParameters = 0;
+        uint64_t hash = 0;                      // StreamFNV of every key
+        std::string keyData;                    // Keys back to back, one allocation for the scene
+        std::vector<uint32_t> keyEnds;          // End of each key in keyData
+
+        size_t keyCount() const { return keyEnds.size(); }
+        size_t keyBegin(size_t i) const { return i ? keyEnds[i - 1] : 0; }
+        bool keyEquals(size_t i, const std::string& key) const;
+        void addKey(const char* key, size_t size);
+        // The schema hash when only the first count keys are in use.
+        uint64_t keysHash(size_t count) const;
+    };
+
+    uint64_t sourceSize = 0;
+    uint64_t sourceHash = 0;    // fnvHash of the JSON file
+    std::vector<Scene> scenes;
+
+    // Parses schema.json text in one pass. False, with error set, when it is not a schema.
+    bool parse(const char* text, size_t size, std::string& error);
+
+    std::vector<uint8_t> serialise() const;
+    // False, leaving the schema unchanged, when data is not a compiled schema of this version or is damaged.
+    bool deserialise(const uint8_t* data, size_t size);
+};
@@ -0,0 +1,196 @@
+#include "ConvertScheduler.hpp"
+
+#include "NativePlatform.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // Logical processor of the n-th set bit in mask, wrapping around when there are more workers than bits.
+    int affinityProcessor(uint64_t mask, size_t n)
+    {
+        size_t bits = 0;
+        for (uint64_t m = mask; m; m &= m - 1)
+            ++bits;
+        n %= bits;
+        for (int cpu = 0; cpu < 64; ++cpu)
+        {
+            if (mask & (uint64_t(1) << cpu))
+            {
+                if (n == 0)
+                    return cpu;
+                --n;
+            }
+        }
+        return 0;
+    }
+
+    void pinThread(std::thread& thread, int cpu)
+    {
+#if defined(_WIN32)
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+}
+
+ConvertScheduler::ConvertScheduler(size_t threads, uint64_t affinityMask)
+    : m_requestedThreads(threads)
+    , m_affinityMask(affinityMask)
+{
+    if (threads == 0)
+        threads = std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency() / 2, 1), AutoThreadLimit);
+    threads = std::min(threads, MaxThreads);
+
+    m_ranges.reset(new Range[threads]);
+    for (size_t i = 0; i < threads; ++i)
+        m_ranges[i].stripes.store(0, std::memory_order_relaxed);
+
+    m_workers.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+    {
+        m_workers.emplace_back(&ConvertScheduler::workerMain, this, i);
+        if (affinityMask)
+            pinThread(m_workers.back(), affinityProcessor(affinityMask, i - 1));
+    }
+}
+
+ConvertScheduler::~ConvertScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+int ConvertScheduler::stripeRows(const PixelConvert::Image& image, size_t threads)
+{
+    const size_t rowBytes = size_t(image.width) * PixelConvert::sourceBytesPerPixel(image.srcFormat) + PixelConvert::rowBytes(image.dstFormat, image.width);
+    int rows = int(std::max<size_t>(StripeBytes / std::max<size_t>(rowBytes, 1), 1));
+
+    // Keep a few stripes per thread so that stealing has something to balance.
+    const int balanced = int(size_t(image.height) / (threads * 4));
+    if (balanced >= 1 && balanced < rows)
+        rows = balanced;
+    return std::min(rows, std::max(image.height, 1));
+}
+
+void ConvertScheduler::convert(const PixelConvert::Image& image)
+{
+    std::lock_guard<std::mutex> serial(m_convertMutex);
+
+    const size_t threads = threadCount();
+    const int rows = stripeRows(image, threads);
+    const uint32_t stripes = uint32_t((image.height + rows - 1) / rows);
+    if (threads == 1 || stripes <= 1)
+    {
+        PixelConvert::convertRows(image, 0, image.height);
+        return;
+    }
+
+    m_image = &image;
+    m_stripeRows = rows;
+    for (size_t i = 0; i < threads; ++i)
+        m_ranges[i].stripes.store(pack(uint32_t(stripes * i / threads), uint32_t(stripes * (i + 1) / threads)), std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = m_workers.size();
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    work(0);
+
+    // Workers still finishing a stolen stripe hold on to m_image, so wait for all of them rather than a stripe count.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_image = nullptr;
+}
+
+void ConvertScheduler::workerMain(size_t index)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+            seen = m_generation;
+        }
+
+        work(index);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy == 0)
+            m_done.notify_one();
+    }
+}
+
+void ConvertScheduler::work(size_t self)
+{
+    const PixelConvert::Image& image = *m_image;
+    uint32_t stripe;
+    while (pop(self, stripe) || steal(self, stripe))
+    {
+        const int first = int(stripe) * m_stripeRows;
+        PixelConvert::convertRows(image, first, std::min(first + m_stripeRows, image.height));
+    }
+}
+
+bool ConvertScheduler::pop(size_t self, uint32_t& stripe)
+{
+    std::atomic<uint64_t>& range = m_ranges[self].stripes;
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const uint32_t next = uint32_t(current);
+        const uint32_t end = uint32_t(current >> 32);
+        if (next >= end)
+            return false;
+        if (range.compare_exchange_weak(current, pack(next + 1, end), std::memory_order_acq_rel))
+        {
+            stripe = next;
+            return true;
+        }
+    }
+}
+
+bool ConvertScheduler::steal(size_t self, uint32_t& stripe)
+{
+    // A range value always describes exactly the stripes its thread still owns, so a CAS that succeeds on a value
+    // seen earlier is still correct.
+    const size_t threads = threadCount();
+    for (size_t offset = 1; offset < threads; ++offset)
+    {
+        std::atomic<uint64_t>& victim = m_ranges[(self + offset) % threads].stripes;
+        uint64_t current = victim.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const uint32_t next = uint32_t(current);
+            const uint32_t end = uint32_t(current >> 32);
+            if (next >= end)
+                break;
+            const uint32_t split = end - (end - next + 1) / 2;
+            if (victim.compare_exchange_weak(current, pack(next, split), std::memory_order_acq_rel))
+            {
+                stripe = split;
+                m_ranges[self].stripes.store(pack(split + 1, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "PixelConvert.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs CPU pixel conversion on a fixed pool of threads. A frame is cut into horizontal stripes sized so that one
+// stripe's source and destination rows stay in a core's L2, every thread starts on its own contiguous share of
+// stripes and steals half of another thread's remainder once it runs out. The calling thread takes part.
+class ConvertScheduler
+{
+public:
+    static constexpr size_t MaxThreads = 64;
+    static constexpr size_t AutoThreadLimit = 16;   // Conversion stops scaling well before this on memory bandwidth
+    static constexpr size_t StripeBytes = 256 * 1024;
+
+    // threads counts the calling thread, 0 takes half the hardware threads up to AutoThreadLimit. Workers are pinned
+    // in turn to the logical processors set in affinityMask, 0 leaves them to the OS.
+    ConvertScheduler(size_t threads, uint64_t affinityMask);
+    ~ConvertScheduler();
+
+    ConvertScheduler(const ConvertScheduler&) = delete;
+    ConvertScheduler& operator=(const ConvertScheduler&) = delete;
+
+    // Converts the whole image, returns once every stripe is written. Calls are serialised.
+    void convert(const PixelConvert::Image& image);
+
+    size_t threadCount() const { return m_workers.size() + 1; }
+    size_t requestedThreads() const { return m_requestedThreads; }
+    uint64_t affinityMask() const { return m_affinityMask; }
+
+    // Rows per stripe for image across threads participants.
+    static int stripeRows(const PixelConvert::Image& image, size_t threads);
+
+private:
+    // Unclaimed stripes of one thread as [next, end), packed so that taking from either end is a single CAS. Padded
+    // to two cache lines so neighbours never share one, whatever alignment new gives the array.
+    struct Range
+    {
+        std::atomic<uint64_t> stripes;
+        char padding[128 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    static uint64_t pack(uint32_t next, uint32_t end) { return uint64_t(end) << 32 | next; }
+
+    void workerMain(size_t index);
+    void work(size_t self);
+    bool pop(size_t self, uint32_t& stripe);
+    bool steal(size_t self, uint32_t& stripe);
+
+    size_t m_requestedThreads;
+    uint64_t m_affinityMask;
+
+    std::unique_ptr<Range[]> m_ranges;  // One per thread, the calling thread is 0
+    std::vector<std::thread> m_workers;
+
+    // The job currently being converted, only written while no worker is busy.
+    const PixelConvert::Image* m_image = nullptr;
+    int m_stripeRows = 1;
+
+    std::mutex m_convertMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    size_t m_busy = 0;
+    bool m_stopping = false;
+};
@@ -0,0 +1,209 @@
+#include "FrameBufferPool.hpp"
+
+#include "NativePlatform.hpp"
+
+namespace
+{
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return multiple ? (value + multiple - 1) / multiple * multiple : value;
+    }
+
+    size_t pageSize()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return size_t(info.dwPageSize);
+#else
+        const long size = sysconf(_SC_PAGESIZE);
+        return size > 0 ? size_t(size) : 4096;
+#endif
+    }
+
+    size_t largePageSize()
+    {
+#if defined(_WIN32)
+        return size_t(GetLargePageMinimum());
+#else
+        return size_t(2) << 20;
+#endif
+    }
+}
+
+FrameBufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : m_pool(std::move(other.m_pool))
+    , m_data(other.m_data)
+    , m_size(other.m_size)
+    , m_index(other.m_index)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+FrameBufferPool::Buffer& FrameBufferPool::Buffer::operator=(Buffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_pool = std::move(other.m_pool);
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_index = other.m_index;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+FrameBufferPool::Buffer::~Buffer()
+{
+    reset();
+}
+
+void FrameBufferPool::Buffer::reset()
+{
+    if (m_pool)
+        m_pool->release(m_index);
+    m_pool.reset();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+/* static */ std::shared_ptr<FrameBufferPool> FrameBufferPool::create(size_t bufferCount, size_t bufferBytes, uint32_t flags)
+{
+    return std::shared_ptr<FrameBufferPool>(new FrameBufferPool(bufferCount, bufferBytes, flags));
+}
+
+FrameBufferPool::FrameBufferPool(size_t bufferCount, size_t bufferBytes, uint32_t flags)
+    : m_free(bufferCount)
+    , m_bufferBytes(bufferBytes)
+    , m_flags(flags)
+    , m_exhausted(0)
+{
+    m_allocations.reserve(bufferCount);
+    for (size_t i = 0; i < bufferCount; ++i)
+    {
+        Allocation allocation = allocate(bufferBytes, flags);
+        if (!allocation.data)
+            break;
+        if (!allocation.largePages)
+            m_flags &= ~FLAG_LARGE_PAGES;
+        if (!allocation.locked)
+            m_flags &= ~FLAG_LOCKED;
+        m_allocations.push_back(allocation);
+
+        uint32_t index = uint32_t(i);
+        m_free.tryPush(index);
+    }
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    for (Allocation& allocation : m_allocations)
+        freeAllocation(allocation);
+}
+
+FrameBufferPool::Buffer FrameBufferPool::acquire()
+{
+    Buffer buffer;
+    uint32_t index = 0;
+    if (!m_free.tryPop(index))
+    {
+        m_exhausted.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    buffer.m_pool = shared_from_this();
+    buffer.m_data = m_allocations[index].data;
+    buffer.m_size = m_bufferBytes;
+    buffer.m_index = index;
+    return buffer;
+}
+
+void FrameBufferPool::release(uint32_t index)
+{
+    // Cannot fail, the queue has a slot for every buffer.
+    m_free.tryPush(index);
+}
+
+/* static */ FrameBufferPool::Allocation FrameBufferPool::allocate(size_t bytes, uint32_t flags)
+{
+    Allocation allocation;
+    if (bytes == 0)
+        return allocation;
+
+#if defined(_WIN32)
+    if (flags & FLAG_LARGE_PAGES)
+    {
+        // Needs SeLockMemoryPrivilege, falls back to normal pages without it.
+        const size_t large = largePageSize();
+        if (large)
+        {
+            allocation.reserved = roundUp(bytes, large);
+            allocation.data = static_cast<uint8_t*>(VirtualAlloc(nullptr, allocation.reserved, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+            // Large pages are never paged out, so they are locked by definition.
+            allocation.largePages = allocation.locked = allocation.data != nullptr;
+        }
+    }
+    if (!allocation.data)
+    {
+        allocation.reserved = roundUp(bytes, pageSize());
+        allocation.data = static_cast<uint8_t*>(VirtualAlloc(nullptr, allocation.reserved, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        if (allocation.data && (flags & FLAG_LOCKED))
+            allocation.locked = VirtualLock(allocation.data, allocation.reserved) != 0;
+    }
+#else
+    if (flags & FLAG_LARGE_PAGES)
+    {
+#ifdef MAP_HUGETLB
+        allocation.reserved = roundUp(bytes, largePageSize());
+        void* data = mmap(nullptr, allocation.reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED)
+        {
+            allocation.data = static_cast<uint8_t*>(data);
+            allocation.largePages = true;
+        }
+#endif
+    }
+    if (!allocation.data)
+    {
+        allocation.reserved = roundUp(bytes, (flags & FLAG_LARGE_PAGES) ? largePageSize() : pageSize());
+        void* data = mmap(nullptr, allocation.reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            return Allocation();
+        allocation.data = static_cast<uint8_t*>(data);
+#ifdef MADV_HUGEPAGE
+        // No reserved huge pages, ask for transparent ones instead.
+        if (flags & FLAG_LARGE_PAGES)
+            allocation.largePages = madvise(data, allocation.reserved, MADV_HUGEPAGE) == 0;
+#endif
+    }
+    if (flags & FLAG_LOCKED)
+        allocation.locked = mlock(allocation.data, allocation.reserved) == 0;
+#endif
+
+    // Touch every page up front so the first frames do not pay for page faults.
+    const size_t stride = pageSize();
+    for (size_t offset = 0; allocation.data && offset < allocation.reserved; offset += stride)
+        allocation.data[offset] = 0;
+
+    return allocation;
+}
+
+/* static */ void FrameBufferPool::freeAllocation(Allocation& allocation)
+{
+    if (!allocation.data)
+        return;
+
+#if defined(_WIN32)
+    if (allocation.locked && !allocation.largePages)
+        VirtualUnlock(allocation.data, allocation.reserved);
+    VirtualFree(allocation.data, 0, MEM_RELEASE);
+#else
+    if (allocation.locked)
+        munlock(allocation.data, allocation.reserved);
+    munmap(allocation.data, allocation.reserved);
+#endif
+    allocation = Allocation();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "RingQueue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Fixed set of page-aligned host buffers allocated straight from the OS. A buffer returns itself to the pool when
+// its handle is destroyed, so ownership can be passed from the capturing thread to the sender without copying.
+class FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool>
+{
+public:
+    enum Flags : uint32_t
+    {
+        FLAG_NONE = 0,
+        FLAG_LARGE_PAGES = 1,   // Back buffers with huge/large pages where the OS allows it
+        FLAG_LOCKED = 2,        // Pin buffers in physical memory (mlock/VirtualLock)
+    };
+
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        ~Buffer();
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+        explicit operator bool() const { return m_data != nullptr; }
+
+        void reset();   // Return the buffer to its pool early
+
+    private:
+        friend class FrameBufferPool;
+
+        std::shared_ptr<FrameBufferPool> m_pool;
+        uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        uint32_t m_index = 0;
+    };
+
+    // Flags that could not be honoured are dropped, see flags().
+    static std::shared_ptr<FrameBufferPool> create(size_t bufferCount, size_t bufferBytes, uint32_t flags);
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    Buffer acquire();   // Empty buffer when every buffer is in flight
+
+    size_t bufferBytes() const { return m_bufferBytes; }
+    size_t bufferCount() const { return m_allocations.size(); }
+    uint32_t flags() const { return m_flags; }
+    uint64_t exhausted() const { return m_exhausted.load(std::memory_order_relaxed); }
+
+private:
+    struct Allocation
+    {
+        uint8_t* data = nullptr;
+        size_t reserved = 0;
+        bool largePages = false;
+        bool locked = false;
+    };
+
+    FrameBufferPool(size_t bufferCount, size_t bufferBytes, uint32_t flags);
+    void release(uint32_t index);
+
+    static Allocation allocate(size_t bytes, uint32_t flags);
+    static void freeAllocation(Allocation& allocation);
+
+    std::vector<Allocation> m_allocations;
+    RingQueue<uint32_t> m_free;
+    size_t m_bufferBytes = 0;
+    uint32_t m_flags = FLAG_NONE;
+    std::atomic<uint64_t> m_exhausted;
+};
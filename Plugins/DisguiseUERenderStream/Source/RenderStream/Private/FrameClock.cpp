@@ -0,0 +1,99 @@
+#include "FrameClock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Weight of each new interval in the period and jitter averages.
+    const double Smoothing = 1. / 16.;
+
+    // A localTime step this far from the time between arrivals is d3 jumping or pausing its timeline, not drift.
+    const double MaxDriftStep = 0.5;
+}
+
+void FrameClock::reset()
+{
+    *this = FrameClock();
+}
+
+void FrameClock::arrived(int64_t receivedAt, const RenderStreamLink::FrameData& frameData)
+{
+    ++m_stats.arrived;
+    m_missed = 0;
+    m_onTime = std::min(m_onTime + 1, LockFrames);
+
+    m_nominal = frameData.frameRateNumerator > 0 && frameData.frameRateDenominator > 0 ?
+        double(frameData.frameRateDenominator) / double(frameData.frameRateNumerator) : 0.;
+    if (m_period <= 0. && m_nominal > 0.)
+        m_period = m_nominal * 1e9;
+
+    if (m_lastArrival != 0 && receivedAt > m_lastArrival)
+    {
+        // Frames the engine was too busy to wait for show up as an interval of several periods.
+        const double interval = double(receivedAt - m_lastArrival);
+        const double periods = m_period > 0. ? std::max(1., std::round(interval / m_period)) : 1.;
+        m_stats.skipped += uint64_t(periods) - 1;
+
+        const double sample = interval / periods;
+        if (m_period <= 0.)
+            m_period = sample;
+        const double deviation = sample - m_period;
+        m_period += deviation * Smoothing;
+        m_jitter += (std::fabs(deviation) - m_jitter) * Smoothing;
+
+        const double step = frameData.localTime - m_lastLocalTime;
+        if (std::fabs(step - interval * 1e-9) > MaxDriftStep)
+        {
+            m_anchorArrival = 0;
+            m_driftPpm = 0.;
+        }
+    }
+
+    if (m_anchorArrival == 0)
+    {
+        m_anchorArrival = receivedAt;
+        m_anchorLocalTime = frameData.localTime;
+    }
+    else
+    {
+        const double elapsed = double(receivedAt - m_anchorArrival) * 1e-9;
+        if (elapsed >= 1.)
+            m_driftPpm = ((frameData.localTime - m_anchorLocalTime) / elapsed - 1.) * 1e6;
+    }
+
+    m_lastArrival = receivedAt;
+    m_lastLocalTime = frameData.localTime;
+    m_lastDelta = frameData.localTimeDelta > 0. ? frameData.localTimeDelta : (m_period > 0. ? m_period * 1e-9 : m_nominal);
+}
+
+void FrameClock::missed()
+{
+    ++m_stats.missed;
+    ++m_missed;
+    m_onTime = 0;
+}
+
+int64_t FrameClock::deadline(int64_t now, int64_t maxWait) const
+{
+    const int64_t latest = now + maxWait;
+    if (m_lastArrival == 0 || m_period <= 0.)
+        return latest;
+
+    // A frame a little late is still waited for, rather than the one after it.
+    const double tolerance = std::max(double(MinTolerance), std::min(4. * m_jitter, m_period / 2.));
+    const double periods = std::max(1., std::ceil((double(now - m_lastArrival) - tolerance) / m_period));
+    const int64_t due = m_lastArrival + int64_t(periods * m_period);
+    return std::min(due + int64_t(tolerance), latest);
+}
+
+FrameClock::State FrameClock::state() const
+{
+    if (m_stats.arrived == 0)
+        return State::Closed;
+    if (m_missed >= ErrorFrames)
+        return State::Error;
+    if (m_onTime >= LockFrames)
+        return State::Synchronized;
+    return State::Synchronizing;
+}
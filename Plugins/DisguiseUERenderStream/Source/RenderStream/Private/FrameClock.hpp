@@ -0,0 +1,62 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+
+#include <cstdint>
+
+// Follows the cadence of frames arriving from d3 for the custom time step. It works out when the next frame is due
+// and how long to wait for it, how far d3's clock runs from ours, and whether the engine is locked to d3. Times are
+// LatencyTracer::now() nanoseconds.
+class FrameClock
+{
+public:
+    enum class State { Closed, Synchronizing, Synchronized, Error };
+
+    static constexpr int LockFrames = 8;                    // On time in a row before the engine counts as locked
+    static constexpr int ErrorFrames = 3;                   // Missed in a row before the lock counts as lost
+    static constexpr int64_t MinTolerance = 1000000;        // Least time past the due time a frame is waited for
+
+    struct Stats
+    {
+        uint64_t arrived = 0;
+        uint64_t missed = 0;
+        uint64_t skipped = 0;       // d3 frames that arrived while the engine was busy, and were never waited for
+    };
+
+    void reset();
+
+    // A frame taken from d3, received at receivedAt.
+    void arrived(int64_t receivedAt, const RenderStreamLink::FrameData& frameData);
+    // No frame arrived by the deadline.
+    void missed();
+
+    // When to stop waiting for the next frame, when waiting from now, at most maxWait later.
+    int64_t deadline(int64_t now, int64_t maxWait) const;
+
+    State state() const;
+    const Stats& stats() const { return m_stats; }
+
+    // Seconds.
+    double nominalPeriod() const { return m_nominal; }                  // From d3's frame rate, 0 before the first frame
+    double period() const { return m_period * 1e-9; }                   // Observed between arrivals
+    double jitter() const { return m_jitter * 1e-9; }                   // Mean deviation of arrivals from the period
+    double lastDelta() const { return m_lastDelta; }                    // localTimeDelta of the last frame, else the period
+    // How much faster d3's localTime runs than our clock, in parts per million, 0 until a second has been measured.
+    double driftPpm() const { return m_driftPpm; }
+
+private:
+    double m_nominal = 0.;
+    double m_period = 0.;           // ns
+    double m_jitter = 0.;           // ns
+    double m_lastDelta = 0.;
+    double m_driftPpm = 0.;
+
+    int64_t m_lastArrival = 0;
+    double m_lastLocalTime = 0.;
+    int64_t m_anchorArrival = 0;    // Start of the drift measurement
+    double m_anchorLocalTime = 0.;
+
+    int m_onTime = 0;
+    int m_missed = 0;
+    Stats m_stats;
+};
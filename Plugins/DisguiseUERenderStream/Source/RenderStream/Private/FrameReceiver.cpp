@@ -0,0 +1,220 @@
+#include "FrameReceiver.hpp"
+
+#include "LatencyTracer.hpp"
+
+FrameReceiver::FrameReceiver(RenderStreamLink::AssetHandle asset)
+    : m_asset(asset)
+    , m_configVersion(0)
+    , m_stopping(false)
+    , m_received(0)
+    , m_failed(0)
+    , m_overwritten(0)
+{
+    m_thread = std::thread(&FrameReceiver::run, this);
+}
+
+FrameReceiver::~FrameReceiver()
+{
+    stop();
+}
+
+void FrameReceiver::setSchemas(const std::vector<Schema>& schemas)
+{
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_schemas = schemas;
+    m_configVersion.fetch_add(1, std::memory_order_release);
+}
+
+void FrameReceiver::setStreams(const std::vector<RenderStreamLink::StreamHandle>& streams)
+{
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_streams = streams;
+    m_configVersion.fetch_add(1, std::memory_order_release);
+}
+
+bool FrameReceiver::consume()
+{
+    return m_buffer.consume();
+}
+
+bool FrameReceiver::consumeBy(std::chrono::steady_clock::time_point deadline)
+{
+    if (!m_buffer.fresh())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_published.wait_until(lock, deadline, [this] { return m_buffer.fresh() || m_stopping.load(std::memory_order_relaxed); });
+    }
+    return m_buffer.consume();
+}
+
+void FrameReceiver::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping.store(true, std::memory_order_relaxed);
+    }
+    m_wake.notify_all();
+    m_published.notify_all();
+    m_thread.join();
+}
+
+std::unique_ptr<SessionWriter> FrameReceiver::startRecording(std::unique_ptr<SessionWriter> recorder)
+{
+    std::lock_guard<std::mutex> lock(m_recorderMutex);
+    std::swap(recorder, m_recorder);
+    return recorder;
+}
+
+std::unique_ptr<SessionWriter> FrameReceiver::stopRecording()
+{
+    return startRecording(nullptr);
+}
+
+bool FrameReceiver::latestCamera(RenderStreamLink::StreamHandle stream, LatestCamera& out) const
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    for (const Camera& camera : m_cameras)
+    {
+        if (camera.stream == stream && camera.valid)
+        {
+            out.sequence = m_camerasSequence;
+            out.receivedAt = m_camerasReceivedAt;
+            out.frameData = m_camerasFrameData;
+            out.data = camera.data;
+            return true;
+        }
+    }
+    return false;
+}
+
+FrameReceiver::Stats FrameReceiver::stats() const
+{
+    Stats stats;
+    stats.received = m_received.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.overwritten = m_overwritten.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FrameReceiver::run()
+{
+    while (!m_stopping.load(std::memory_order_relaxed))
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Snapshot& snapshot = m_buffer.back();
+        const bool awaited = receive(snapshot);
+        if (m_stopping.load(std::memory_order_relaxed))
+            break;
+
+        snapshot.sequence = ++m_sequence;
+        if (snapshot.valid)
+            publishCameras(snapshot);
+        if (!m_buffer.publish())
+            m_overwritten.fetch_add(1, std::memory_order_relaxed);
+
+        // Taking the lock orders the publish before a waiting consumer's check, so the wakeup cannot be lost.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_published.notify_all();
+
+        // A library that fails straight away, before initialisation for instance, must not spin this thread.
+        if (!awaited)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_until(lock, start + std::chrono::milliseconds(AwaitTimeoutMs), [this] { return m_stopping.load(std::memory_order_relaxed); });
+        }
+    }
+}
+
+bool FrameReceiver::receive(Snapshot& snapshot)
+{
+    RenderStreamLink& link = RenderStreamLink::instance();
+
+    snapshot.valid = false;
+    snapshot.parametersValid = false;
+    snapshot.cameras.clear();
+
+    RenderStreamLink::AssetHandle updateAsset = 0;
+    const RenderStreamLink::RS_ERROR ret = link.rs_awaitFrameData(&updateAsset, AwaitTimeoutMs, &snapshot.frameData);
+    snapshot.receivedAt = LatencyTracer::now();
+    if (ret != RenderStreamLink::RS_ERROR_SUCCESS)
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Parameters and cameras belong to the frame just awaited, so they are read before anything else can happen.
+    if (m_configVersion.load(std::memory_order_acquire) != m_threadConfigVersion)
+    {
+        std::lock_guard<std::mutex> lock(m_configMutex);
+        m_threadSchemas = m_schemas;
+        m_threadStreams = m_streams;
+        m_threadConfigVersion = m_configVersion.load(std::memory_order_relaxed);
+    }
+
+    if (updateAsset != m_asset || snapshot.frameData.scene >= m_threadSchemas.size())
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    snapshot.valid = true;
+    m_received.fetch_add(1, std::memory_order_relaxed);
+
+    const Schema& schema = m_threadSchemas[snapshot.frameData.scene];
+    snapshot.parameters.resize(schema.nParameters);
+    snapshot.parametersValid = snapshot.parameters.empty() ||
+        link.rs_getFrameParameters(m_asset, schema.hash, snapshot.parameters.data(), snapshot.parameters.size() * sizeof(float)) == RenderStreamLink::RS_ERROR_SUCCESS;
+
+    snapshot.cameras.resize(m_threadStreams.size());
+    for (size_t i = 0; i < m_threadStreams.size(); ++i)
+    {
+        Camera& camera = snapshot.cameras[i];
+        camera.stream = m_threadStreams[i];
+        camera.valid = link.rs_getFrameCamera(m_asset, camera.stream, &camera.data) == RenderStreamLink::RS_ERROR_SUCCESS;
+    }
+
+    record(snapshot, schema.hash);
+    return true;
+}
+
+void FrameReceiver::publishCameras(const Snapshot& snapshot)
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    m_camerasSequence = snapshot.sequence;
+    m_camerasReceivedAt = snapshot.receivedAt;
+    m_camerasFrameData = snapshot.frameData;
+    m_cameras = snapshot.cameras;
+}
+
+void FrameReceiver::record(const Snapshot& snapshot, uint64_t schemaHash)
+{
+    std::lock_guard<std::mutex> lock(m_recorderMutex);
+    if (!m_recorder)
+        return;
+
+    m_recordCameras.resize(snapshot.cameras.size());
+    for (size_t i = 0; i < snapshot.cameras.size(); ++i)
+    {
+        m_recordCameras[i].stream = snapshot.cameras[i].stream;
+        m_recordCameras[i].valid = snapshot.cameras[i].valid ? 1 : 0;
+        m_recordCameras[i].data = snapshot.cameras[i].data;
+    }
+
+    SessionFrame frame;
+    frame.time = snapshot.receivedAt;
+    frame.schemaHash = schemaHash;
+    frame.frameData = snapshot.frameData;
+    frame.parametersValid = snapshot.parametersValid;
+    frame.parameters = snapshot.parameters.data();
+    frame.nParameters = snapshot.parameters.size();
+    frame.cameras = m_recordCameras.data();
+    frame.nCameras = m_recordCameras.size();
+
+    // A full disk ends the recording, the log up to that point stays readable.
+    if (!m_recorder->append(frame))
+        m_recorder.reset();
+}
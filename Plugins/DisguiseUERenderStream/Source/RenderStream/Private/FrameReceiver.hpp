@@ -0,0 +1,129 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+#include "TripleBuffer.hpp"
+#include "SessionLog.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Waits in rs_awaitFrameData on a dedicated thread. Each frame is published together with its parameters and the
+// camera of every registered stream, all read before the next wait, so the game thread picks up a consistent frame
+// without blocking on a late d3.
+class FrameReceiver
+{
+public:
+    static constexpr int AwaitTimeoutMs = 100;  // Also bounds how long stopping takes
+
+    struct Schema
+    {
+        uint64_t hash = 0;
+        size_t nParameters = 0;
+    };
+
+    struct Camera
+    {
+        RenderStreamLink::StreamHandle stream = 0;
+        bool valid = false;
+        RenderStreamLink::CameraData data;
+    };
+
+    struct Snapshot
+    {
+        bool valid = false;             // Frame received for our asset, with a scene that has a schema
+        uint64_t sequence = 0;          // Counts published snapshots, valid or not
+        int64_t receivedAt = 0;         // LatencyTracer::now() as rs_awaitFrameData returned
+        RenderStreamLink::FrameData frameData;
+        bool parametersValid = false;
+        std::vector<float> parameters;  // Sized to the scene's schema
+        std::vector<Camera> cameras;    // One per registered stream
+    };
+
+    // A stream's camera from the newest valid frame, whether or not the game thread has taken that frame yet.
+    struct LatestCamera
+    {
+        uint64_t sequence = 0;          // Of the snapshot the camera arrived with
+        int64_t receivedAt = 0;
+        RenderStreamLink::FrameData frameData;
+        RenderStreamLink::CameraData data;
+    };
+
+    struct Stats
+    {
+        uint64_t received = 0;
+        uint64_t failed = 0;
+        uint64_t overwritten = 0;       // Published but replaced before the game thread took them
+    };
+
+    explicit FrameReceiver(RenderStreamLink::AssetHandle asset);
+    ~FrameReceiver();
+
+    FrameReceiver(const FrameReceiver&) = delete;
+    FrameReceiver& operator=(const FrameReceiver&) = delete;
+
+    // Indexed by FrameData::scene. Frames for a scene without a schema are published as invalid.
+    void setSchemas(const std::vector<Schema>& schemas);
+    void setStreams(const std::vector<RenderStreamLink::StreamHandle>& streams);
+
+    // Game thread. Takes the newest snapshot published since the last call, false when there is none.
+    bool consume();
+    // As consume, but waits up to deadline for a snapshot to be published.
+    bool consumeBy(std::chrono::steady_clock::time_point deadline);
+    const Snapshot& latest() const { return m_buffer.front(); }
+    // Any thread. False when the newest valid frame has no camera for stream.
+    bool latestCamera(RenderStreamLink::StreamHandle stream, LatestCamera& out) const;
+
+    void stop();
+    Stats stats() const;
+
+    // Appends every valid frame to recorder from the receive thread. Each returns the recorder it replaces, for the
+    // caller to close.
+    std::unique_ptr<SessionWriter> startRecording(std::unique_ptr<SessionWriter> recorder);
+    std::unique_ptr<SessionWriter> stopRecording();
+
+private:
+    void run();
+    bool receive(Snapshot& snapshot);   // False when rs_awaitFrameData itself failed
+    void record(const Snapshot& snapshot, uint64_t schemaHash);
+    void publishCameras(const Snapshot& snapshot);
+
+    RenderStreamLink::AssetHandle m_asset;
+    TripleBuffer<Snapshot> m_buffer;
+
+    // Written by the game thread, copied by the receive thread when m_configVersion moves on.
+    std::mutex m_configMutex;
+    std::vector<Schema> m_schemas;
+    std::vector<RenderStreamLink::StreamHandle> m_streams;
+    std::atomic<uint64_t> m_configVersion;
+    std::vector<Schema> m_threadSchemas;
+    std::vector<RenderStreamLink::StreamHandle> m_threadStreams;
+    uint64_t m_threadConfigVersion = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_published;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_stopping;
+    std::thread m_thread;
+
+    // Cameras of the newest valid snapshot, kept apart from m_buffer as its front belongs to the game thread.
+    mutable std::mutex m_camerasMutex;
+    uint64_t m_camerasSequence = 0;
+    int64_t m_camerasReceivedAt = 0;
+    RenderStreamLink::FrameData m_camerasFrameData;
+    std::vector<Camera> m_cameras;
+
+    std::mutex m_recorderMutex;
+    std::unique_ptr<SessionWriter> m_recorder;
+    std::vector<SessionCamera> m_recordCameras;
+
+    uint64_t m_sequence = 0;
+    std::atomic<uint64_t> m_received;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_overwritten;
+};
@@ -0,0 +1,134 @@
+#include "FrameSender.hpp"
+
+#include <chrono>
+
+FrameSender::FrameSender(SendFn send, size_t queueDepth, Policy policy)
+    : m_send(std::move(send))
+    , m_policy(policy)
+    , m_queue(queueDepth < 1 ? 1 : queueDepth)
+    , m_stopping(false)
+    , m_sendPending(true)
+    , m_enqueued(0)
+    , m_sent(0)
+    , m_failed(0)
+    , m_dropped(0)
+    , m_maxDepth(0)
+{
+    m_thread = std::thread(&FrameSender::run, this);
+}
+
+FrameSender::~FrameSender()
+{
+    stop(false);
+}
+
+void FrameSender::enqueue(Frame&& frame)
+{
+    if (m_stopping.load(std::memory_order_relaxed))
+    {
+        drop(frame);
+        return;
+    }
+
+    if (m_policy == Policy::LatestWins)
+    {
+        Frame stale;
+        while (m_queue.tryPop(stale))
+            drop(stale);
+    }
+
+    while (!m_queue.tryPush(frame))
+    {
+        if (m_policy == Policy::Block)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_spaceAvailable.wait_for(lock, std::chrono::milliseconds(1));
+            if (m_stopping.load(std::memory_order_relaxed))
+            {
+                drop(frame);
+                return;
+            }
+        }
+        else
+        {
+            Frame oldest;
+            if (m_queue.tryPop(oldest))
+                drop(oldest);
+        }
+    }
+
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    const size_t depth = m_queue.size();
+    size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {}
+
+    // Taking the lock orders the push before the consumer's emptiness check, so the wakeup cannot be lost.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_frameAvailable.notify_one();
+}
+
+void FrameSender::stop(bool sendPending)
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_sendPending.store(sendPending, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping.store(true, std::memory_order_relaxed);
+    }
+    m_frameAvailable.notify_all();
+    m_spaceAvailable.notify_all();
+    m_thread.join();
+
+    Frame frame;
+    while (m_queue.tryPop(frame))
+        drop(frame);
+}
+
+FrameSender::Stats FrameSender::stats() const
+{
+    Stats s;
+    s.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    s.sent = m_sent.load(std::memory_order_relaxed);
+    s.failed = m_failed.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.depth = m_queue.size();
+    s.maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+    return s;
+}
+
+void FrameSender::run()
+{
+    Frame frame;
+    for (;;)
+    {
+        if (m_stopping.load(std::memory_order_relaxed) && !m_sendPending.load(std::memory_order_relaxed))
+            return;
+
+        if (!m_queue.tryPop(frame))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameAvailable.wait(lock, [this] { return m_queue.size() > 0 || m_stopping.load(std::memory_order_relaxed); });
+            if (m_stopping.load(std::memory_order_relaxed) && m_queue.size() == 0)
+                return;
+            continue;
+        }
+
+        m_spaceAvailable.notify_one();
+
+        if (m_send(frame) == RenderStreamLink::RS_ERROR_SUCCESS)
+            m_sent.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+        frame = Frame();
+    }
+}
+
+void FrameSender::drop(Frame& frame)
+{
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    frame = Frame();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+#include "FrameBufferPool.hpp"
+#include "RingQueue.hpp"
+#include "LatencyTracer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Hands frames to rs_sendFrame on a dedicated thread so that a stall inside the d3 library does not cost
+// rendering thread time.
+class FrameSender
+{
+public:
+    enum class Policy : uint32_t
+    {
+        Block,          // Producer waits for a free slot
+        DropOldest,     // Producer evicts the oldest queued frame
+        LatestWins,     // Producer discards everything queued, only the newest frame is ever waiting
+    };
+
+    struct Frame
+    {
+        RenderStreamLink::SenderFrameType frameType = RenderStreamLink::RS_FRAMETYPE_HOST_MEMORY;
+        void* data = nullptr;
+        int width = 0;
+        int height = 0;
+        RenderStreamLink::SenderPixelFormat format = RenderStreamLink::FMT_BGRA;
+        RenderStreamLink::CameraResponseData response;
+        LatencyTracer::Trace trace;
+        FrameBufferPool::Buffer buffer; // Host memory frames, returned to its pool once sent or dropped
+    };
+
+    struct Stats
+    {
+        uint64_t enqueued = 0;
+        uint64_t sent = 0;
+        uint64_t failed = 0;
+        uint64_t dropped = 0;
+        size_t depth = 0;
+        size_t maxDepth = 0;
+    };
+
+    typedef std::function<RenderStreamLink::RS_ERROR(Frame&)> SendFn;
+
+    FrameSender(SendFn send, size_t queueDepth, Policy policy);
+    ~FrameSender();
+
+    FrameSender(const FrameSender&) = delete;
+    FrameSender& operator=(const FrameSender&) = delete;
+
+    void enqueue(Frame&& frame);                // Called from the capturing thread
+    void stop(bool sendPending);                // Joins the sender thread, optionally sending what is still queued
+    Stats stats() const;
+    size_t capacity() const { return m_queue.capacity(); }
+
+private:
+    void run();
+    void drop(Frame& frame);
+
+    SendFn m_send;
+    Policy m_policy;
+    RingQueue<Frame> m_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_frameAvailable;
+    std::condition_variable m_spaceAvailable;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_sendPending;
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_enqueued;
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<size_t> m_maxDepth;
+};
@@ -0,0 +1,179 @@
+#include "LatencyTracer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+LatencyHistogram::LatencyHistogram()
+    : m_count(0)
+    , m_sum(0)
+    , m_max(0)
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    // Values below 2 * SubBuckets get a bucket each. Above that the top SubBucketBits + 1 bits select the bucket
+    // within the power of two given by the shift.
+    if (value < 2 * SubBuckets)
+        return size_t(value);
+    int msb = 63;
+    while (!(value >> msb))
+        --msb;
+    const int shift = std::min(msb - SubBucketBits, MaxShift);
+    const uint64_t sub = std::min<uint64_t>(value >> shift, 2 * SubBuckets - 1);
+    return size_t(uint64_t(shift) * SubBuckets + sub);
+}
+
+uint64_t LatencyHistogram::bucketHighest(size_t index)
+{
+    if (index < 2 * SubBuckets)
+        return uint64_t(index);
+    const int shift = int(index / SubBuckets) - 1;
+    const uint64_t sub = uint64_t(index) - uint64_t(shift) * SubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    const uint64_t count = m_count.load(std::memory_order_relaxed);
+    return count ? double(m_sum.load(std::memory_order_relaxed)) / double(count) : 0.;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    // Counts are read one by one while other threads may record, so the total is taken from the buckets themselves.
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t>& bucket : m_buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    if (total == 0)
+        return 0;
+
+    const uint64_t rank = std::max<uint64_t>(uint64_t(p / 100. * double(total) + 0.5), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(bucketHighest(i), max());
+    }
+    return max();
+}
+
+int64_t LatencyTracer::now()
+{
+    return int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* LatencyTracer::stageName(size_t index)
+{
+    static const char* const names[StageCount + 1] = { "received", "applied", "user_data", "captured", "sent", "total" };
+    return index <= StageCount ? names[index] : "unknown";
+}
+
+bool LatencyTracer::durations(const Trace& trace, int64_t (&out)[StageCount + 1])
+{
+    std::fill(out, out + StageCount + 1, int64_t(-1));
+
+    // Frames captured before any frame data arrived have nothing to measure from.
+    if (trace.frameId == 0)
+        return false;
+
+    int64_t first = 0;
+    int64_t previous = 0;
+    for (size_t i = 0; i < StageCount; ++i)
+    {
+        const int64_t stamp = trace.stamps[i];
+        if (stamp == 0)
+            continue;
+        if (previous != 0)
+            out[i] = std::max<int64_t>(stamp - previous, 0);
+        if (first == 0)
+            first = stamp;
+        previous = stamp;
+    }
+    if (first != 0 && previous != first)
+        out[TotalIndex] = std::max<int64_t>(previous - first, 0);
+    return true;
+}
+
+void LatencyTracer::record(const Trace& trace)
+{
+    int64_t values[StageCount + 1];
+    if (!durations(trace, values))
+        return;
+
+    for (size_t i = 0; i <= TotalIndex; ++i)
+    {
+        if (values[i] < 0)
+            continue;
+        m_histograms[i].record(uint64_t(values[i]));
+        m_last[i].store(uint64_t(values[i]), std::memory_order_relaxed);
+    }
+}
+
+void LatencyTracer::reset()
+{
+    for (LatencyHistogram& histogram : m_histograms)
+        histogram.reset();
+    for (std::atomic<uint64_t>& last : m_last)
+        last.store(0, std::memory_order_relaxed);
+}
+
+LatencyTracer::Summary LatencyTracer::summary(size_t index) const
+{
+    Summary s;
+    if (index > TotalIndex)
+        return s;
+    const LatencyHistogram& histogram = m_histograms[index];
+    s.count = histogram.count();
+    s.p50 = histogram.percentile(50.);
+    s.p99 = histogram.percentile(99.);
+    s.max = histogram.max();
+    s.mean = histogram.mean();
+    return s;
+}
+
+std::string LatencyTracer::csv() const
+{
+    std::string out = "stage,count,p50_us,p99_us,max_us,mean_us\n";
+    char row[160];
+    for (size_t i = 1; i <= TotalIndex; ++i)
+    {
+        const Summary s = summary(i);
+        std::snprintf(row, sizeof(row), "%s,%llu,%.1f,%.1f,%.1f,%.1f\n", stageName(i), (unsigned long long)s.count,
+            double(s.p50) / 1000., double(s.p99) / 1000., double(s.max) / 1000., s.mean / 1000.);
+        out += row;
+    }
+    return out;
+}
+
+bool LatencyTracer::writeCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    file << csv();
+    return bool(file);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Log-linear histogram after HdrHistogram: 32 linear buckets per power of two, so any recorded value is known to
+// about 3%. Recording is a couple of relaxed atomic adds and may happen on any thread at the same time as reads.
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+    static constexpr int MaxShift = 40 - SubBucketBits;                 // Values clamp at about 18 minutes in ns
+    static constexpr size_t BucketCount = size_t(MaxShift + 2) * SubBuckets;
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // Highest value equivalent to the bucket holding the given percentile, 0 when empty.
+    uint64_t percentile(double p) const;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketHighest(size_t index);
+
+private:
+    std::atomic<uint64_t> m_buckets[BucketCount];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+// Follows a frame from the moment d3's frame data arrives until it has been handed to rs_sendFrame. Each stage is
+// stamped with a monotonic clock into a Trace that travels with the frame, and the time since the previous stamped
+// stage goes into that stage's histogram once the frame is sent.
+class LatencyTracer
+{
+public:
+    enum class Stage : uint32_t
+    {
+        Received,   // rs_awaitFrameData returned on the receive thread
+        Applied,    // Camera data applied to the capture on the game thread
+        UserData,   // Frame handed to MediaCapture with its user data
+        Captured,   // Capture callback on the rendering thread
+        Sent,       // rs_sendFrame returned
+        Count
+    };
+
+    static constexpr size_t StageCount = size_t(Stage::Count);
+    static constexpr size_t TotalIndex = StageCount;    // Histogram index of Received to Sent
+
+    struct Trace
+    {
+        uint64_t frameId = 0;                 // Receive sequence of the frame data, 0 when untraced
+        int64_t stamps[StageCount] = {};      // now() per stage, 0 when not reached
+
+        void stamp(Stage stage) { stamps[size_t(stage)] = LatencyTracer::now(); }
+    };
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        uint64_t p50 = 0;
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+        double mean = 0.;
+    };
+
+    // Monotonic nanoseconds.
+    static int64_t now();
+
+    static const char* stageName(size_t index);   // Accepts TotalIndex
+
+    // Time since the previous stamped stage per stage, then Received to Sent at TotalIndex, -1 for stages not reached.
+    // False for untraced frames.
+    static bool durations(const Trace& trace, int64_t (&out)[StageCount + 1]);
+
+    void record(const Trace& trace);
+    void reset();
+
+    uint64_t frames() const { return m_histograms[TotalIndex].count(); }
+    Summary summary(size_t index) const;
+    // Of the last frame recorded that reached the stage, 0 before any has.
+    uint64_t last(size_t index) const { return index <= TotalIndex ? m_last[index].load(std::memory_order_relaxed) : 0; }
+
+    // One row per stage and one for the total, values in microseconds.
+    std::string csv() const;
+    bool writeCsv(const std::string& path) const;
+
+private:
+    LatencyHistogram m_histograms[StageCount + 1];
+    std::atomic<uint64_t> m_last[StageCount + 1] = {};
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+// Operating system headers for the engine-independent parts of the plugin. Inside an Unreal build the Windows
+// headers have to come through the engine's wrapper so that its own macros and types are not clobbered.
+#if defined(_WIN32)
+#if defined(WITH_ENGINE)
+#include "Windows/WindowsHWrapper.h"
+#else
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
@@ -0,0 +1,124 @@
+#include "ParameterDiff.hpp"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#define PARAMETERDIFF_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define PARAMETERDIFF_NEON 1
+#endif
+
+namespace
+{
+    // Blocks of 16 parameters are checked as a whole first, almost every block is unchanged from frame to frame.
+    constexpr size_t BlockSize = 16;
+
+    inline size_t popcount16(uint32_t bits)
+    {
+        bits = bits - ((bits >> 1) & 0x5555);
+        bits = (bits & 0x3333) + ((bits >> 2) & 0x3333);
+        bits = (bits + (bits >> 4)) & 0x0f0f;
+        return size_t((bits + (bits >> 8)) & 0x1f);
+    }
+
+    inline uint32_t diffBlockScalar(const float* previous, const float* current)
+    {
+        uint32_t a[BlockSize];
+        uint32_t b[BlockSize];
+        std::memcpy(a, previous, sizeof(a));
+        std::memcpy(b, current, sizeof(b));
+        uint32_t bits = 0;
+        for (size_t i = 0; i < BlockSize; ++i)
+            bits |= uint32_t(a[i] != b[i]) << i;
+        return bits;
+    }
+
+#if PARAMETERDIFF_SSE2
+    // Bit per lane set when the lane is non-zero.
+    inline uint32_t nonZero(__m128i v)
+    {
+        return uint32_t(~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm_setzero_si128())))) & 0xf;
+    }
+
+    inline uint32_t diffBlock(const float* previous, const float* current)
+    {
+        const __m128i* a = reinterpret_cast<const __m128i*>(previous);
+        const __m128i* b = reinterpret_cast<const __m128i*>(current);
+        const __m128i x0 = _mm_xor_si128(_mm_loadu_si128(a + 0), _mm_loadu_si128(b + 0));
+        const __m128i x1 = _mm_xor_si128(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+        const __m128i x2 = _mm_xor_si128(_mm_loadu_si128(a + 2), _mm_loadu_si128(b + 2));
+        const __m128i x3 = _mm_xor_si128(_mm_loadu_si128(a + 3), _mm_loadu_si128(b + 3));
+        const __m128i any = _mm_or_si128(_mm_or_si128(x0, x1), _mm_or_si128(x2, x3));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) == 0xffff)
+            return 0;
+        return nonZero(x0) | (nonZero(x1) << 4) | (nonZero(x2) << 8) | (nonZero(x3) << 12);
+    }
+#elif PARAMETERDIFF_NEON
+    inline uint32_t nonZero(uint32x4_t v)
+    {
+        static const uint32_t lanes[4] = { 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(vtstq_u32(v, v), vld1q_u32(lanes)));
+    }
+
+    inline uint32_t diffBlock(const float* previous, const float* current)
+    {
+        const uint32_t* a = reinterpret_cast<const uint32_t*>(previous);
+        const uint32_t* b = reinterpret_cast<const uint32_t*>(current);
+        const uint32x4_t x0 = veorq_u32(vld1q_u32(a + 0), vld1q_u32(b + 0));
+        const uint32x4_t x1 = veorq_u32(vld1q_u32(a + 4), vld1q_u32(b + 4));
+        const uint32x4_t x2 = veorq_u32(vld1q_u32(a + 8), vld1q_u32(b + 8));
+        const uint32x4_t x3 = veorq_u32(vld1q_u32(a + 12), vld1q_u32(b + 12));
+        if (vmaxvq_u32(vorrq_u32(vorrq_u32(x0, x1), vorrq_u32(x2, x3))) == 0)
+            return 0;
+        return nonZero(x0) | (nonZero(x1) << 4) | (nonZero(x2) << 8) | (nonZero(x3) << 12);
+    }
+#else
+    inline uint32_t diffBlock(const float* previous, const float* current)
+    {
+        return diffBlockScalar(previous, current);
+    }
+#endif
+
+    template <uint32_t (*DiffBlock)(const float*, const float*)>
+    size_t compareBlocks(const float* previous, const float* current, size_t n, std::vector<uint64_t>& changed)
+    {
+        changed.assign((n + 63) / 64, 0);
+
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + BlockSize <= n; i += BlockSize)
+        {
+            // Blocks start on a multiple of 16, so never straddle two words.
+            const uint32_t bits = DiffBlock(previous + i, current + i);
+            if (bits)
+            {
+                changed[i >> 6] |= uint64_t(bits) << (i & 63);
+                count += popcount16(bits);
+            }
+        }
+        for (; i < n; ++i)
+        {
+            uint32_t a, b;
+            std::memcpy(&a, previous + i, sizeof(a));
+            std::memcpy(&b, current + i, sizeof(b));
+            if (a != b)
+            {
+                changed[i >> 6] |= uint64_t(1) << (i & 63);
+                ++count;
+            }
+        }
+        return count;
+    }
+}
+
+size_t ParameterDiff::compare(const float* previous, const float* current, size_t n, std::vector<uint64_t>& changed)
+{
+    return compareBlocks<diffBlock>(previous, current, n, changed);
+}
+
+size_t ParameterDiff::compareScalar(const float* previous, const float* current, size_t n, std::vector<uint64_t>& changed)
+{
+    return compareBlocks<diffBlockScalar>(previous, current, n, changed);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Finds the parameters d3 changed between two frames. Values are compared bitwise, so a NaN that stays NaN is
+// unchanged while 0 and -0 differ, and the result is a bitmask with one bit per parameter.
+namespace ParameterDiff
+{
+    // Sets bit i of changed when previous[i] and current[i] differ, resizing changed to hold n bits. Returns the number
+    // of parameters that changed.
+    size_t compare(const float* previous, const float* current, size_t n, std::vector<uint64_t>& changed);
+    // compare without SSE2 or NEON, the reference the vector code is tested against.
+    size_t compareScalar(const float* previous, const float* current, size_t n, std::vector<uint64_t>& changed);
+
+    // True when any of the count parameters from first changed.
+    inline bool any(const uint64_t* changed, size_t first, size_t count)
+    {
+        for (size_t i = first; i < first + count; ++i)
+        {
+            if ((changed[i >> 6] >> (i & 63)) & 1)
+                return true;
+        }
+        return false;
+    }
+}
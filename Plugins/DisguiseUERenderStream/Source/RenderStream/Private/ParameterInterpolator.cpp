@@ -0,0 +1,102 @@
+#include "ParameterInterpolator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+void ParameterInterpolator::configure(Mode mode)
+{
+    m_mode = mode;
+    reset();
+}
+
+void ParameterInterpolator::reset()
+{
+    m_count = 0;
+    m_moving = false;
+}
+
+void ParameterInterpolator::setContinuous(const std::vector<uint8_t>& continuous)
+{
+    m_continuous = continuous;
+    m_indices.clear();
+    for (size_t i = 0; i < m_continuous.size(); ++i)
+    {
+        if (m_continuous[i])
+            m_indices.push_back(i);
+    }
+    reset();
+}
+
+void ParameterInterpolator::push(double localTime, double localTimeDelta, const float* values)
+{
+    // A timeline that stood still, went back or skipped ahead starts again from this sample.
+    if (m_count > 0)
+    {
+        const double step = localTime - m_samples[2].t;
+        if (step <= 0. || step > MaxGapFrames * std::max(localTimeDelta, 1e-3))
+            m_count = 0;
+    }
+
+    // Rotated rather than copied, so the sample vectors keep their allocations.
+    std::swap(m_samples[0], m_samples[1]);
+    std::swap(m_samples[1], m_samples[2]);
+    Sample& sample = m_samples[2];
+    sample.t = localTime;
+    sample.values.assign(values, values + m_continuous.size());
+    if (m_count < 3)
+        ++m_count;
+
+    m_moving = false;
+    if (m_mode != Mode::Step && m_count >= 2)
+    {
+        const std::vector<float>& previous = m_samples[1].values;
+        for (size_t i : m_indices)
+        {
+            if (std::memcmp(&previous[i], &sample.values[i], sizeof(float)) != 0)
+            {
+                m_moving = true;
+                break;
+            }
+        }
+    }
+}
+
+const std::vector<float>& ParameterInterpolator::evaluate(double fraction)
+{
+    m_values = m_samples[2].values;
+    if (!m_moving)
+        return m_values;
+
+    const double f = std::min(std::max(fraction, 0.), 1.);
+    const Sample& s0 = m_samples[1];
+    const Sample& s1 = m_samples[2];
+    if (m_mode == Mode::Linear || m_count < 3)
+    {
+        for (size_t i : m_indices)
+            m_values[i] = float(s0.values[i] + (s1.values[i] - s0.values[i]) * f);
+        return m_values;
+    }
+
+    // Cubic Hermite over the last interval. The slope at its start runs from the sample before, the slope at its end
+    // along the interval. Held within the samples' range, so colours stay valid.
+    const Sample& sm = m_samples[0];
+    const double h = s1.t - s0.t;
+    const double f2 = f * f;
+    const double f3 = f2 * f;
+    const double h00 = 2. * f3 - 3. * f2 + 1.;
+    const double h10 = f3 - 2. * f2 + f;
+    const double h01 = -2. * f3 + 3. * f2;
+    const double h11 = f3 - f2;
+    for (size_t i : m_indices)
+    {
+        const double p0 = s0.values[i];
+        const double p1 = s1.values[i];
+        const double m0 = (p1 - sm.values[i]) / (s1.t - sm.t) * h;
+        const double m1 = p1 - p0;
+        const double lo = std::min({ sm.values[i], s0.values[i], s1.values[i] });
+        const double hi = std::max({ sm.values[i], s0.values[i], s1.values[i] });
+        m_values[i] = float(std::min(std::max(h00 * p0 + h10 * m0 + h01 * p1 + h11 * m1, lo), hi));
+    }
+    return m_values;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Eases continuous parameters between the last two samples d3 sent, for an engine that ticks more often than d3 sends.
+// Each engine frame is evaluated some fraction of the way from the previous sample to the newest, so continuous
+// parameters run one d3 frame behind. Discrete parameters take the newest sample as it arrives, as does everything
+// after a jump in d3's timeline.
+class ParameterInterpolator
+{
+public:
+    enum class Mode : uint8_t
+    {
+        Step,       // The newest sample, as without interpolation
+        Linear,
+        Cubic,      // Hermite, sloped through the sample before the previous one
+    };
+
+    // Samples further apart than this many frames of d3 are a seek or restart rather than motion.
+    static constexpr double MaxGapFrames = 4.;
+
+    void configure(Mode mode);
+    void reset();
+    Mode mode() const { return m_mode; }
+
+    // One flag per parameter, set for those that interpolate. Resets the history.
+    void setContinuous(const std::vector<uint8_t>& continuous);
+    size_t size() const { return m_continuous.size(); }
+
+    // The parameters d3 sent for localTime, size() of them. localTimeDelta is d3's frame time.
+    void push(double localTime, double localTimeDelta, const float* values);
+    // The parameters fraction of the way, from 0 to 1, from the previous sample to the newest.
+    const std::vector<float>& evaluate(double fraction);
+    // False when evaluating anywhere short of the newest sample gives the newest sample.
+    bool moving() const { return m_moving; }
+
+private:
+    struct Sample
+    {
+        double t = 0.;
+        std::vector<float> values;
+    };
+
+    Mode m_mode = Mode::Step;
+    std::vector<uint8_t> m_continuous;
+    std::vector<size_t> m_indices;      // Of the continuous parameters
+    Sample m_samples[3];                // Oldest first, the last m_count in use
+    size_t m_count = 0;
+    bool m_moving = false;
+    std::vector<float> m_values;
+};
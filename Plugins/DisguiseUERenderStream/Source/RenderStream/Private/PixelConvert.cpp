@@ -0,0 +1,719 @@
+#include "PixelConvertInternal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if PIXELCONVERT_X64
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace PixelConvert
+{
+namespace Detail
+{
+    namespace
+    {
+        typedef RenderStreamLink RSL;
+
+        YuvCoefficients makeCoefficients(int depth)
+        {
+            const double k = double(1 << (depth - 8));
+            const double scale = double(1 << YuvShift) / 65535.0;
+            auto luma = [&](double c) { return int32_t(std::lround(219.0 * k * c * scale)); };
+            auto chroma = [&](double c) { return int32_t(std::lround(224.0 * k * c * scale)); };
+
+            const double kr = 0.2126, kg = 0.7152, kb = 0.0722;
+            YuvCoefficients c;
+            c.yr = luma(kr);
+            c.yg = luma(kg);
+            c.yb = luma(kb);
+            c.ur = chroma(-kr / (2.0 * (1.0 - kb)));
+            c.ug = chroma(-kg / (2.0 * (1.0 - kb)));
+            c.ub = chroma(0.5);
+            c.vr = chroma(0.5);
+            c.vg = chroma(-kg / (2.0 * (1.0 - kr)));
+            c.vb = chroma(-kb / (2.0 * (1.0 - kr)));
+            c.yOffset = int32_t(16.0 * k);
+            c.cOffset = int32_t(128.0 * k);
+            c.maxValue = (1 << depth) - 1;
+            return c;
+        }
+
+        uint32_t toFixed(float value)
+        {
+            // Written so that NaN becomes 0, matching max(value, 0) in the vector kernels.
+            value = value > 0.f ? value : 0.f;
+            value = value < 1.f ? value : 1.f;
+            return uint32_t(std::lrintf(value * 65535.f));
+        }
+
+        // Alpha operations on 16-bit fixed point, mirrored by Alpha<Op> in the vector kernels.
+        template <AlphaOp Op>
+        struct ScalarAlpha
+        {
+            static void apply(uint32_t&, uint32_t&, uint32_t&, uint32_t&) {}
+        };
+
+        template <>
+        struct ScalarAlpha<AlphaOp::SetOne>
+        {
+            static void apply(uint32_t&, uint32_t&, uint32_t&, uint32_t& a) { a = 0xffff; }
+        };
+
+        template <>
+        struct ScalarAlpha<AlphaOp::Invert>
+        {
+            static void apply(uint32_t&, uint32_t&, uint32_t&, uint32_t& a) { a = 0xffff - a; }
+        };
+
+        template <>
+        struct ScalarAlpha<AlphaOp::Premultiply>
+        {
+            static void apply(uint32_t& r, uint32_t& g, uint32_t& b, uint32_t& a)
+            {
+                r = premultiply(r, a);
+                g = premultiply(g, a);
+                b = premultiply(b, a);
+            }
+        };
+
+        template <>
+        struct ScalarAlpha<AlphaOp::Unpremultiply>
+        {
+            static uint32_t scale(uint32_t c, float s)
+            {
+                const float v = float(c) * s;
+                return uint32_t(std::lrintf(v < 65535.f ? v : 65535.f));
+            }
+
+            static void apply(uint32_t& r, uint32_t& g, uint32_t& b, uint32_t& a)
+            {
+                if (a == 0)
+                {
+                    r = g = b = 0;
+                    return;
+                }
+                // One division per pixel, then a product per component, exactly as the vector kernels do it.
+                const float s = 65535.f / float(a);
+                r = scale(r, s);
+                g = scale(g, s);
+                b = scale(b, s);
+            }
+        };
+
+        int32_t clampComponent(int32_t value, int32_t maxValue)
+        {
+            return value < 0 ? 0 : (value > maxValue ? maxValue : value);
+        }
+
+        void storeBigEndian(uint8_t* dst, uint64_t value, int bytes)
+        {
+            for (int i = bytes - 1; i >= 0; --i)
+            {
+                dst[i] = uint8_t(value);
+                value >>= 8;
+            }
+        }
+
+        // Scalar reference kernels, every other instruction set must match these bit for bit.
+
+        template <AlphaOp Op>
+        void loadScalar(SourceFormat format, const uint8_t* src, int count, Chunk& chunk)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                uint32_t r, g, b, a;
+                switch (format)
+                {
+                case SourceFormat::BGRA8:
+                case SourceFormat::RGBA8:
+                {
+                    const uint8_t* p = src + i * 4;
+                    const bool rgba = format == SourceFormat::RGBA8;
+                    r = p[rgba ? 0 : 2] * 257u;
+                    g = p[1] * 257u;
+                    b = p[rgba ? 2 : 0] * 257u;
+                    a = p[3] * 257u;
+                    break;
+                }
+                case SourceFormat::RGBA16F:
+                {
+                    uint16_t h[4];
+                    std::memcpy(h, src + i * 8, sizeof(h));
+                    r = toFixed(halfToFloat(h[0]));
+                    g = toFixed(halfToFloat(h[1]));
+                    b = toFixed(halfToFloat(h[2]));
+                    a = toFixed(halfToFloat(h[3]));
+                    break;
+                }
+                case SourceFormat::RGBA32F:
+                default:
+                {
+                    float f[4];
+                    std::memcpy(f, src + i * 16, sizeof(f));
+                    r = toFixed(f[0]);
+                    g = toFixed(f[1]);
+                    b = toFixed(f[2]);
+                    a = toFixed(f[3]);
+                    break;
+                }
+                }
+                ScalarAlpha<Op>::apply(r, g, b, a);
+                chunk.r[i] = r;
+                chunk.g[i] = g;
+                chunk.b[i] = b;
+                chunk.a[i] = a;
+            }
+        }
+
+        void quantizeScalar(Chunk& chunk, int count, int depth)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                chunk.r[i] = quantize(chunk.r[i], depth);
+                chunk.g[i] = quantize(chunk.g[i], depth);
+                chunk.b[i] = quantize(chunk.b[i], depth);
+                chunk.a[i] = quantize(chunk.a[i], depth);
+            }
+        }
+
+        void yuvScalar(Chunk& chunk, int count, int depth)
+        {
+            const YuvCoefficients& c = yuvCoefficients(depth);
+            for (int j = 0; j < count / 2; ++j)
+            {
+                const int32_t r0 = int32_t(chunk.r[2 * j]), r1 = int32_t(chunk.r[2 * j + 1]);
+                const int32_t g0 = int32_t(chunk.g[2 * j]), g1 = int32_t(chunk.g[2 * j + 1]);
+                const int32_t b0 = int32_t(chunk.b[2 * j]), b1 = int32_t(chunk.b[2 * j + 1]);
+                chunk.y0[j] = uint32_t(c.yOffset + ((c.yr * r0 + c.yg * g0 + c.yb * b0 + YuvRound) >> YuvShift));
+                chunk.y1[j] = uint32_t(c.yOffset + ((c.yr * r1 + c.yg * g1 + c.yb * b1 + YuvRound) >> YuvShift));
+
+                const int32_t r = (r0 + r1 + 1) >> 1;
+                const int32_t g = (g0 + g1 + 1) >> 1;
+                const int32_t b = (b0 + b1 + 1) >> 1;
+                chunk.cb[j] = uint32_t(clampComponent(c.cOffset + ((c.ur * r + c.ug * g + c.ub * b + YuvRound) >> YuvShift), c.maxValue));
+                chunk.cr[j] = uint32_t(clampComponent(c.cOffset + ((c.vr * r + c.vg * g + c.vb * b + YuvRound) >> YuvShift), c.maxValue));
+            }
+            for (int i = 0; i < count; ++i)
+                chunk.a[i] = quantize(chunk.a[i], 8);
+        }
+
+        void interleave8Scalar(uint8_t* dst, const uint32_t* c0, const uint32_t* c1, const uint32_t* c2, const uint32_t* c3, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                dst[i * 4 + 0] = uint8_t(c0[i]);
+                dst[i * 4 + 1] = uint8_t(c1[i]);
+                dst[i * 4 + 2] = uint8_t(c2[i]);
+                dst[i * 4 + 3] = uint8_t(c3[i]);
+            }
+        }
+
+        void narrow8Scalar(uint8_t* dst, const uint32_t* c, int count)
+        {
+            for (int i = 0; i < count; ++i)
+                dst[i] = uint8_t(c[i]);
+        }
+
+        template <AlphaOp Op>
+        void swizzle8Scalar(const uint8_t* src, bool rgbaSource, uint8_t* dst, int count, RSL::SenderPixelFormat format)
+        {
+            int order[4];
+            bool opaque;
+            swizzleOrder(format, rgbaSource, order, opaque);
+            const uint8_t fill = opaque || Op == AlphaOp::SetOne ? 255 : 0;
+            const uint8_t flip = Op == AlphaOp::Invert ? 255 : 0;
+            for (int i = 0; i < count; ++i)
+            {
+                const uint8_t* p = src + i * 4;
+                uint8_t* q = dst + i * 4;
+                q[0] = p[order[0]];
+                q[1] = p[order[1]];
+                q[2] = p[order[2]];
+                q[3] = uint8_t((p[order[3]] ^ flip) | fill);
+            }
+        }
+
+        template <AlphaOp Op>
+        void uyvy8Scalar(const uint8_t* src, bool rgbaSource, int count, uint8_t* dst, uint8_t* alpha)
+        {
+            const YuvCoefficients& c = yuvCoefficients(8);
+            const int ri = rgbaSource ? 0 : 2;
+            const int bi = rgbaSource ? 2 : 0;
+            for (int i = 0; i < count; i += 2)
+            {
+                const uint8_t* p0 = src + i * 4;
+                const uint8_t* p1 = p0 + 4;
+                uint32_t ur0 = p0[ri] * 257u, ug0 = p0[1] * 257u, ub0 = p0[bi] * 257u, ua0 = p0[3] * 257u;
+                uint32_t ur1 = p1[ri] * 257u, ug1 = p1[1] * 257u, ub1 = p1[bi] * 257u, ua1 = p1[3] * 257u;
+                ScalarAlpha<Op>::apply(ur0, ug0, ub0, ua0);
+                ScalarAlpha<Op>::apply(ur1, ug1, ub1, ua1);
+
+                const int32_t r0 = int32_t(ur0), g0 = int32_t(ug0), b0 = int32_t(ub0);
+                const int32_t r1 = int32_t(ur1), g1 = int32_t(ug1), b1 = int32_t(ub1);
+                const int32_t r = (r0 + r1 + 1) >> 1;
+                const int32_t g = (g0 + g1 + 1) >> 1;
+                const int32_t b = (b0 + b1 + 1) >> 1;
+
+                uint8_t* q = dst + i * 2;
+                q[0] = uint8_t(clampComponent(c.cOffset + ((c.ur * r + c.ug * g + c.ub * b + YuvRound) >> YuvShift), c.maxValue));
+                q[1] = uint8_t(c.yOffset + ((c.yr * r0 + c.yg * g0 + c.yb * b0 + YuvRound) >> YuvShift));
+                q[2] = uint8_t(clampComponent(c.cOffset + ((c.vr * r + c.vg * g + c.vb * b + YuvRound) >> YuvShift), c.maxValue));
+                q[3] = uint8_t(c.yOffset + ((c.yr * r1 + c.yg * g1 + c.yb * b1 + YuvRound) >> YuvShift));
+                if (alpha)
+                {
+                    // Alpha stays a multiple of 257 here, so dropping the low byte is the exact 8-bit quantisation.
+                    alpha[i] = uint8_t(ua0 >> 8);
+                    alpha[i + 1] = uint8_t(ua1 >> 8);
+                }
+            }
+        }
+
+        // Bit packing is shared by every instruction set, only the component values above are vectorised.
+
+        void packYuv(uint8_t* dst, const Chunk& chunk, int pairs, int depth)
+        {
+            const int bytes = depth == 10 ? 5 : 6;
+            for (int j = 0; j < pairs; ++j)
+            {
+                const uint64_t v = (uint64_t(chunk.cb[j]) << (3 * depth)) | (uint64_t(chunk.y0[j]) << (2 * depth))
+                    | (uint64_t(chunk.cr[j]) << depth) | uint64_t(chunk.y1[j]);
+                storeBigEndian(dst + j * bytes, v, bytes);
+            }
+        }
+
+        uint64_t packRgb(const Chunk& chunk, int i, int depth)
+        {
+            return (uint64_t(chunk.r[i]) << (2 * depth)) | (uint64_t(chunk.g[i]) << depth) | uint64_t(chunk.b[i]);
+        }
+
+        void packRgb10(uint8_t* dst, const Chunk& chunk, int pixels)
+        {
+            // 4 pixels = 120 bits, written as two 60-bit halves sharing byte 7.
+            for (int i = 0; i < pixels; i += 4, dst += 15)
+            {
+                const uint64_t hi = (packRgb(chunk, i, 10) << 30) | packRgb(chunk, i + 1, 10);
+                const uint64_t lo = (packRgb(chunk, i + 2, 10) << 30) | packRgb(chunk, i + 3, 10);
+                storeBigEndian(dst, hi >> 4, 7);
+                dst[7] = uint8_t(((hi & 0xf) << 4) | (lo >> 56));
+                storeBigEndian(dst + 8, lo, 7);
+            }
+        }
+
+        void packRgb12(uint8_t* dst, const Chunk& chunk, int pixels)
+        {
+            // 2 pixels = 72 bits, two 36-bit halves sharing byte 4.
+            for (int i = 0; i < pixels; i += 2, dst += 9)
+            {
+                const uint64_t hi = packRgb(chunk, i, 12);
+                const uint64_t lo = packRgb(chunk, i + 1, 12);
+                storeBigEndian(dst, hi >> 4, 4);
+                dst[4] = uint8_t(((hi & 0xf) << 4) | (lo >> 32));
+                storeBigEndian(dst + 5, lo, 4);
+            }
+        }
+
+        void packRgba(uint8_t* dst, const Chunk& chunk, int pixels, int depth)
+        {
+            const int bytes = depth == 10 ? 5 : 6;
+            for (int i = 0; i < pixels; ++i)
+                storeBigEndian(dst + i * bytes, (packRgb(chunk, i, depth) << depth) | uint64_t(chunk.a[i]), bytes);
+        }
+
+#if PIXELCONVERT_X64
+        struct CpuFeatures
+        {
+            bool sse4 = false;
+            bool avx2 = false;
+            bool avx512 = false;
+        };
+
+        void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+        {
+#if defined(_MSC_VER)
+            int r[4];
+            __cpuidex(r, int(leaf), int(subleaf));
+            for (int i = 0; i < 4; ++i)
+                regs[i] = uint32_t(r[i]);
+#else
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        }
+
+        uint64_t xgetbv0()
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            uint32_t eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (uint64_t(edx) << 32) | eax;
+#endif
+        }
+
+        CpuFeatures readCpuFeatures()
+        {
+            CpuFeatures features;
+            uint32_t regs[4];
+            cpuid(0, 0, regs);
+            const uint32_t maxLeaf = regs[0];
+            if (maxLeaf < 1)
+                return features;
+
+            cpuid(1, 0, regs);
+            const uint32_t ecx1 = regs[2];
+            features.sse4 = (ecx1 & (1u << 9)) && (ecx1 & (1u << 19)); // SSSE3, SSE4.1
+
+            const bool osxsave = (ecx1 & (1u << 27)) != 0;
+            const bool avx = (ecx1 & (1u << 28)) != 0;
+            const bool f16c = (ecx1 & (1u << 29)) != 0;
+            if (!osxsave || !avx || maxLeaf < 7)
+                return features;
+
+            // The OS has to save the wider registers on context switches.
+            const uint64_t xcr0 = xgetbv0();
+            const bool ymmState = (xcr0 & 0x6) == 0x6;
+            const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+            cpuid(7, 0, regs);
+            const uint32_t ebx7 = regs[1];
+            features.avx2 = ymmState && f16c && (ebx7 & (1u << 5));
+            features.avx512 = features.avx2 && zmmState && (ebx7 & (1u << 16)) && (ebx7 & (1u << 30)); // F, BW
+            return features;
+        }
+
+        const CpuFeatures& cpuFeatures()
+        {
+            static const CpuFeatures features = readCpuFeatures();
+            return features;
+        }
+#endif
+
+        const KernelTable* kernelsFor(Isa isa)
+        {
+            switch (isa)
+            {
+#if PIXELCONVERT_X64
+            case Isa::SSE4: return &SSE4Kernels;
+            case Isa::AVX2: return &AVX2Kernels;
+            case Isa::AVX512: return &AVX512Kernels;
+#endif
+#if PIXELCONVERT_ARM64
+            case Isa::NEON: return &NEONKernels;
+#endif
+            default: return &ScalarKernels;
+            }
+        }
+
+        std::atomic<uint32_t>& activeIsaStorage()
+        {
+            static std::atomic<uint32_t> isa(static_cast<uint32_t>(detectIsa()));
+            return isa;
+        }
+    }
+
+    const KernelTable ScalarKernels = {
+        PIXELCONVERT_ALPHA_OPS(loadScalar), &quantizeScalar, &yuvScalar, &interleave8Scalar, &narrow8Scalar,
+        PIXELCONVERT_BYTE_ALPHA_OPS(swizzle8Scalar), PIXELCONVERT_ALPHA_OPS(uyvy8Scalar)
+    };
+
+    const FormatInfo& formatInfo(RenderStreamLink::SenderPixelFormat format)
+    {
+        static const FormatInfo bytes4 = { Layout::Bytes4, 8, 1, 4, false };
+        static const FormatInfo uyvy = { Layout::Uyvy, 8, 2, 4, false };
+        static const FormatInfo uyvyAlpha = { Layout::Uyvy, 8, 2, 4, true };
+        static const FormatInfo yuv10 = { Layout::Yuv10, 10, 2, 5, false };
+        static const FormatInfo yuv12 = { Layout::Yuv12, 12, 2, 6, false };
+        static const FormatInfo rgb10 = { Layout::Rgb10, 10, 4, 15, false };
+        static const FormatInfo rgb12 = { Layout::Rgb12, 12, 2, 9, false };
+        static const FormatInfo rgba10 = { Layout::Rgba10, 10, 1, 5, false };
+        static const FormatInfo rgba12 = { Layout::Rgba12, 12, 1, 6, false };
+
+        switch (format)
+        {
+        case RSL::FMT_UYVY_422: return uyvy;
+        case RSL::FMT_NDI_UYVY_422_A: return uyvyAlpha;
+        case RSL::FMT_UC_YUV422_10BIT: return yuv10;
+        case RSL::FMT_UC_YUV422_12BIT: return yuv12;
+        case RSL::FMT_UC_RGB_10BIT: return rgb10;
+        case RSL::FMT_UC_RGB_12BIT: return rgb12;
+        case RSL::FMT_UC_RGBA_10BIT: return rgba10;
+        case RSL::FMT_UC_RGBA_12BIT: return rgba12;
+        default: return bytes4;
+        }
+    }
+
+    const YuvCoefficients& yuvCoefficients(int depth)
+    {
+        static const YuvCoefficients depth8 = makeCoefficients(8);
+        static const YuvCoefficients depth10 = makeCoefficients(10);
+        static const YuvCoefficients depth12 = makeCoefficients(12);
+        return depth == 12 ? depth12 : (depth == 10 ? depth10 : depth8);
+    }
+
+    void convertRow(const KernelTable& kernels, const Image& image, int row)
+    {
+        const FormatInfo& info = formatInfo(image.dstFormat);
+        const size_t srcBpp = sourceBytesPerPixel(image.srcFormat);
+        const uint8_t* src = static_cast<const uint8_t*>(image.src) + image.srcPitch * size_t(row);
+        uint8_t* dst = static_cast<uint8_t*>(image.dst) + image.dstPitch * size_t(row);
+
+        uint8_t* alpha = nullptr;
+        if (info.alphaPlane)
+            alpha = static_cast<uint8_t*>(image.dst) + image.dstPitch * size_t(image.height) + size_t(image.width) * size_t(row);
+
+        const size_t op = size_t(image.alphaOp);
+        const bool rgbaSource = image.srcFormat == SourceFormat::RGBA8;
+        if (info.layout == Layout::Bytes4 && isByteSource(image.srcFormat) && op < ByteAlphaOpCount)
+        {
+            const bool rgbaDest = image.dstFormat == RSL::FMT_RGBA;
+            if (image.alphaOp == AlphaOp::None && (image.dstFormat == RSL::FMT_BGRA || rgbaDest) && rgbaDest == rgbaSource)
+                std::memcpy(dst, src, size_t(image.width) * 4);
+            else
+                kernels.swizzle8[op](src, rgbaSource, dst, image.width, image.dstFormat);
+            return;
+        }
+
+        if (info.layout == Layout::Uyvy && isByteSource(image.srcFormat))
+        {
+            const int body = image.width / MaxVectorPixels * MaxVectorPixels;
+            kernels.uyvy8[op](src, rgbaSource, body, dst, alpha);
+            const int count = image.width - body;
+            if (count > 0)
+            {
+                // Convert the padded remainder on the side and copy out what belongs to the row.
+                alignas(64) uint8_t pixels[MaxVectorPixels * 4];
+                alignas(64) uint8_t packed[MaxVectorPixels * 2];
+                alignas(64) uint8_t alphas[MaxVectorPixels];
+                std::memcpy(pixels, src + size_t(body) * 4, size_t(count) * 4);
+                for (int i = count; i < MaxVectorPixels; ++i)
+                    std::memcpy(pixels + i * 4, pixels + (count - 1) * 4, 4);
+                kernels.uyvy8[op](pixels, rgbaSource, MaxVectorPixels, packed, alpha ? alphas : nullptr);
+                std::memcpy(dst + size_t(body) * 2, packed, size_t((count + 1) / 2) * 4);
+                if (alpha)
+                    std::memcpy(alpha + body, alphas, size_t(count));
+            }
+            return;
+        }
+
+        alignas(64) uint8_t tail[ChunkPixels * 16];
+        Chunk chunk;
+        for (int x = 0; x < image.width; x += ChunkPixels)
+        {
+            const int count = std::min(ChunkPixels, image.width - x);
+            const int padded = (count + MaxVectorPixels - 1) / MaxVectorPixels * MaxVectorPixels;
+            const int groups = (count + info.groupPixels - 1) / info.groupPixels;
+            const uint8_t* pixels = src + size_t(x) * srcBpp;
+            if (padded != count)
+            {
+                std::memcpy(tail, pixels, size_t(count) * srcBpp);
+                for (int i = count; i < padded; ++i)
+                    std::memcpy(tail + size_t(i) * srcBpp, tail + size_t(count - 1) * srcBpp, srcBpp);
+                pixels = tail;
+            }
+            kernels.load[op](image.srcFormat, pixels, padded, chunk);
+
+            uint8_t* out = dst + size_t(x / info.groupPixels) * size_t(info.groupBytes);
+            switch (info.layout)
+            {
+            case Layout::Bytes4:
+                kernels.quantize(chunk, padded, 8);
+                if (image.dstFormat == RSL::FMT_BGRX || image.dstFormat == RSL::FMT_RGBX)
+                    std::fill(chunk.a, chunk.a + count, 255u);
+                if (image.dstFormat == RSL::FMT_BGRA || image.dstFormat == RSL::FMT_BGRX)
+                    kernels.interleave8(out, chunk.b, chunk.g, chunk.r, chunk.a, count);
+                else
+                    kernels.interleave8(out, chunk.r, chunk.g, chunk.b, chunk.a, count);
+                break;
+            case Layout::Uyvy:
+                kernels.yuv(chunk, padded, 8);
+                kernels.interleave8(out, chunk.cb, chunk.y0, chunk.cr, chunk.y1, groups);
+                if (alpha)
+                    kernels.narrow8(alpha + x, chunk.a, count);
+                break;
+            case Layout::Yuv10:
+            case Layout::Yuv12:
+                kernels.yuv(chunk, padded, info.depth);
+                packYuv(out, chunk, groups, info.depth);
+                break;
+            case Layout::Rgb10:
+                kernels.quantize(chunk, padded, 10);
+                packRgb10(out, chunk, groups * 4);
+                break;
+            case Layout::Rgb12:
+                kernels.quantize(chunk, padded, 12);
+                packRgb12(out, chunk, groups * 2);
+                break;
+            case Layout::Rgba10:
+            case Layout::Rgba12:
+                kernels.quantize(chunk, padded, info.depth);
+                packRgba(out, chunk, count, info.depth);
+                break;
+            }
+        }
+    }
+}
+
+size_t sourceBytesPerPixel(SourceFormat format)
+{
+    switch (format)
+    {
+    case SourceFormat::RGBA16F: return 8;
+    case SourceFormat::RGBA32F: return 16;
+    default: return 4;
+    }
+}
+
+size_t rowBytes(RenderStreamLink::SenderPixelFormat format, int width)
+{
+    const Detail::FormatInfo& info = Detail::formatInfo(format);
+    const size_t groups = (size_t(width) + info.groupPixels - 1) / info.groupPixels;
+    return groups * size_t(info.groupBytes);
+}
+
+int frameRows(RenderStreamLink::SenderPixelFormat format, int width, int height)
+{
+    const size_t row = rowBytes(format, width);
+    if (!Detail::formatInfo(format).alphaPlane || row == 0)
+        return height;
+    return height + int((size_t(width) * size_t(height) + row - 1) / row);
+}
+
+size_t frameBytes(RenderStreamLink::SenderPixelFormat format, int width, int height)
+{
+    return rowBytes(format, width) * size_t(frameRows(format, width, height));
+}
+
+Isa detectIsa()
+{
+#if PIXELCONVERT_X64
+    const Detail::CpuFeatures& features = Detail::cpuFeatures();
+    if (features.avx512)
+        return Isa::AVX512;
+    if (features.avx2)
+        return Isa::AVX2;
+    if (features.sse4)
+        return Isa::SSE4;
+    return Isa::Scalar;
+#elif PIXELCONVERT_ARM64
+    return Isa::NEON;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+Isa activeIsa()
+{
+    return Isa(Detail::activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void setActiveIsa(Isa isa)
+{
+    Detail::activeIsaStorage().store(uint32_t(isSupported(isa) ? isa : detectIsa()), std::memory_order_relaxed);
+}
+
+bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar: return true;
+#if PIXELCONVERT_X64
+    case Isa::SSE4: return Detail::cpuFeatures().sse4;
+    case Isa::AVX2: return Detail::cpuFeatures().avx2;
+    case Isa::AVX512: return Detail::cpuFeatures().avx512;
+#endif
+#if PIXELCONVERT_ARM64
+    case Isa::NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar: return "scalar";
+    case Isa::SSE4: return "sse4";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    case Isa::NEON: return "neon";
+    default: return "unknown";
+    }
+}
+
+const char* sourceFormatName(SourceFormat format)
+{
+    switch (format)
+    {
+    case SourceFormat::BGRA8: return "bgra8";
+    case SourceFormat::RGBA8: return "rgba8";
+    case SourceFormat::RGBA16F: return "rgba16f";
+    case SourceFormat::RGBA32F: return "rgba32f";
+    default: return "unknown";
+    }
+}
+
+const char* formatName(RenderStreamLink::SenderPixelFormat format)
+{
+    switch (format)
+    {
+    case RenderStreamLink::FMT_BGRA: return "bgra";
+    case RenderStreamLink::FMT_RGBA: return "rgba";
+    case RenderStreamLink::FMT_BGRX: return "bgrx";
+    case RenderStreamLink::FMT_RGBX: return "rgbx";
+    case RenderStreamLink::FMT_UYVY_422: return "uyvy422";
+    case RenderStreamLink::FMT_NDI_UYVY_422_A: return "ndi_uyvy422_a";
+    case RenderStreamLink::FMT_UC_YUV422_10BIT: return "yuv422_10";
+    case RenderStreamLink::FMT_UC_YUV422_12BIT: return "yuv422_12";
+    case RenderStreamLink::FMT_UC_RGB_10BIT: return "rgb_10";
+    case RenderStreamLink::FMT_UC_RGB_12BIT: return "rgb_12";
+    case RenderStreamLink::FMT_UC_RGBA_10BIT: return "rgba_10";
+    case RenderStreamLink::FMT_UC_RGBA_12BIT: return "rgba_12";
+    default: return "unknown";
+    }
+}
+
+const char* alphaOpName(AlphaOp op)
+{
+    switch (op)
+    {
+    case AlphaOp::None: return "none";
+    case AlphaOp::SetOne: return "set_one";
+    case AlphaOp::Invert: return "invert";
+    case AlphaOp::Premultiply: return "premultiply";
+    case AlphaOp::Unpremultiply: return "unpremultiply";
+    default: return "unknown";
+    }
+}
+
+void convertRows(const Image& image, int firstRow, int endRow)
+{
+    convertRows(image, firstRow, endRow, activeIsa());
+}
+
+void convertRows(const Image& image, int firstRow, int endRow, Isa isa)
+{
+    const Detail::KernelTable& kernels = *Detail::kernelsFor(isSupported(isa) ? isa : Isa::Scalar);
+    for (int row = firstRow; row < endRow; ++row)
+        Detail::convertRow(kernels, image, row);
+
+    // The alpha plane is padded out to a whole row of the main plane, cleared along with the last row.
+    if (endRow == image.height && image.dstPitch > 0 && Detail::formatInfo(image.dstFormat).alphaPlane)
+    {
+        const size_t used = image.dstPitch * size_t(image.height) + size_t(image.width) * size_t(image.height);
+        const size_t end = (used + image.dstPitch - 1) / image.dstPitch * image.dstPitch;
+        std::memset(static_cast<uint8_t*>(image.dst) + used, 0, end - used);
+    }
+}
+
+void convert(const Image& image)
+{
+    convertRows(image, 0, image.height);
+}
+}
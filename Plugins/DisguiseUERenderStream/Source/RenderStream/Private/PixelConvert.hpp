@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU conversion from captured pixels into every RenderStreamLink::SenderPixelFormat. Engine independent.
+//
+// All conversions go through 16-bit fixed point so that the SIMD kernels produce exactly the same bytes as the
+// scalar reference. YUV output is BT.709 limited range with 4:2:2 chroma taken from the mean of each pixel pair.
+//
+// Destination layouts:
+//   FMT_BGRA, FMT_RGBA, FMT_BGRX, FMT_RGBX   4 bytes per pixel, X is written as 255
+//   FMT_UYVY_422                             U Y0 V Y1 per pixel pair
+//   FMT_NDI_UYVY_422_A                       UYVY plane, followed by `height` rows of `width` 8-bit alpha values,
+//                                            zero padded to whole UYVY rows for odd heights
+//   FMT_UC_YUV422_10BIT / 12BIT              ST 2110-20 pgroups: Cb Y0 Cr Y1 packed big-endian, 5 / 6 bytes per pair
+//   FMT_UC_RGB_10BIT                         ST 2110-20 pgroups: 4 pixels of R G B packed into 15 bytes
+//   FMT_UC_RGB_12BIT                         ST 2110-20 pgroups: 2 pixels of R G B packed into 9 bytes
+//   FMT_UC_RGBA_10BIT / 12BIT                R G B A packed big-endian, 5 / 6 bytes per pixel
+// Rows that end part way through a pixel group are padded by repeating the last pixel. 8-bit sources going to
+// UYVY are converted by a single fused kernel, which is what the NDI alpha output uses.
+//
+// Alpha operations are applied in the same pass, compiled into each kernel rather than run over the frame again.
+// Premultiply and unpremultiply change the colour of every output format, not only the ones carrying alpha.
+namespace PixelConvert
+{
+    enum class SourceFormat : uint32_t
+    {
+        BGRA8,      // 8-bit unorm, B G R A in memory
+        RGBA8,      // 8-bit unorm, R G B A in memory
+        RGBA16F,    // IEEE half per channel
+        RGBA32F,    // IEEE float per channel
+
+        Count
+    };
+
+    enum class AlphaOp : uint32_t
+    {
+        None,
+        SetOne,
+        Invert,
+        Premultiply,
+        Unpremultiply,  // Colour of fully transparent pixels becomes 0
+
+        Count
+    };
+
+    enum class Isa : uint32_t
+    {
+        Scalar,
+        SSE4,
+        AVX2,       // Also requires F16C
+        AVX512,     // AVX-512 F and BW
+        NEON,
+
+        Count
+    };
+
+    struct Image
+    {
+        const void* src = nullptr;
+        size_t srcPitch = 0;                // Bytes between source rows
+        SourceFormat srcFormat = SourceFormat::BGRA8;
+
+        void* dst = nullptr;
+        size_t dstPitch = 0;                // Bytes between rows of the main destination plane
+        RenderStreamLink::SenderPixelFormat dstFormat = RenderStreamLink::FMT_BGRA;
+
+        AlphaOp alphaOp = AlphaOp::None;
+
+        int width = 0;
+        int height = 0;
+    };
+
+    size_t sourceBytesPerPixel(SourceFormat format);
+    size_t rowBytes(RenderStreamLink::SenderPixelFormat format, int width);                  // Tightly packed row of the main plane
+    int frameRows(RenderStreamLink::SenderPixelFormat format, int width, int height);        // Main plane rows the frame spans, the height given to rs_sendFrame
+    size_t frameBytes(RenderStreamLink::SenderPixelFormat format, int width, int height);    // Whole frame, including any alpha plane
+
+    Isa detectIsa();            // Best instruction set supported by both this build and the running CPU
+    Isa activeIsa();            // Instruction set used by convert/convertRows, detectIsa() unless overridden
+    void setActiveIsa(Isa isa); // Unsupported instruction sets fall back to detectIsa()
+    bool isSupported(Isa isa);
+    const char* isaName(Isa isa);
+    const char* sourceFormatName(SourceFormat format);
+    const char* alphaOpName(AlphaOp op);
+    const char* formatName(RenderStreamLink::SenderPixelFormat format);
+
+    // Converts rows [firstRow, endRow). Rows are independent so a frame may be split between threads.
+    void convertRows(const Image& image, int firstRow, int endRow);
+    void convertRows(const Image& image, int firstRow, int endRow, Isa isa);
+    void convert(const Image& image);
+}
@@ -0,0 +1,152 @@
+#include "PixelConvertInternal.hpp"
+
+#if PIXELCONVERT_X64
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,f16c"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,f16c")
+#endif
+
+namespace PixelConvert
+{
+namespace Detail
+{
+namespace AVX2
+{
+    typedef __m256i U;
+    typedef __m256 F;
+    constexpr int W = 8;
+
+    static inline U load(const uint32_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+    static inline void store(uint32_t* p, U v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+    static inline U loadBytes(const void* p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+    static inline void storeBytes(void* p, U v) { _mm256_storeu_si256(static_cast<__m256i*>(p), v); }
+    static inline U set1(int32_t v) { return _mm256_set1_epi32(v); }
+    static inline U add(U a, U b) { return _mm256_add_epi32(a, b); }
+    static inline U sub(U a, U b) { return _mm256_sub_epi32(a, b); }
+    static inline U mul(U a, U b) { return _mm256_mullo_epi32(a, b); }
+    static inline U or_(U a, U b) { return _mm256_or_si256(a, b); }
+    static inline U xor_(U a, U b) { return _mm256_xor_si256(a, b); }
+    static inline U sll8(U v) { return _mm256_slli_epi32(v, 8); }
+    static inline U srl1(U v) { return _mm256_srli_epi32(v, 1); }
+    static inline U srl8(U v) { return _mm256_srli_epi32(v, 8); }
+    static inline U srl16(U v) { return _mm256_srli_epi32(v, 16); }
+    static inline U sraYuv(U v) { return _mm256_srai_epi32(v, YuvShift); }
+    static inline U minimum(U a, U b) { return _mm256_min_epi32(a, b); }
+    static inline U maximum(U a, U b) { return _mm256_max_epi32(a, b); }
+    static inline U shuffleBytes(U v, U control) { return _mm256_shuffle_epi8(v, control); }
+
+    static inline void deinterleave(U lo, U hi, U& even, U& odd)
+    {
+        // Shuffles work per 128-bit lane, the permute puts the 64-bit blocks back in order.
+        const __m256 l = _mm256_castsi256_ps(lo);
+        const __m256 h = _mm256_castsi256_ps(hi);
+        even = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(l, h, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+        odd = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(l, h, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    static inline U bytes4(U c0, U c1, U c2, U c3)
+    {
+        return _mm256_or_si256(_mm256_or_si256(c0, _mm256_slli_epi32(c1, 8)), _mm256_or_si256(_mm256_slli_epi32(c2, 16), _mm256_slli_epi32(c3, 24)));
+    }
+
+    static inline void narrow16(uint8_t* dst, const uint32_t* c)
+    {
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(load(c), load(c + 8)), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1)));
+    }
+
+    static inline void storeWords(uint8_t* dst, U v)
+    {
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(words));
+    }
+
+    static inline U widen(U v)
+    {
+        return _mm256_or_si256(_mm256_slli_epi32(v, 8), v); // x * 257
+    }
+
+    static inline void unpack8(U v, U& c0, U& c1, U& c2, U& c3)
+    {
+        const __m256i mask = _mm256_set1_epi32(0xff);
+        c0 = _mm256_and_si256(v, mask);
+        c1 = _mm256_and_si256(_mm256_srli_epi32(v, 8), mask);
+        c2 = _mm256_and_si256(_mm256_srli_epi32(v, 16), mask);
+        c3 = _mm256_srli_epi32(v, 24);
+    }
+
+    // v0..v3 each hold two pixels. A 4x4 transpose per lane leaves pixel 2 * i + lane in element 4 * lane + i,
+    // which the final permute puts back in pixel order.
+    static inline void transpose(F v0, F v1, F v2, F v3, F& r, F& g, F& b, F& a)
+    {
+        const __m256 t0 = _mm256_unpacklo_ps(v0, v1);
+        const __m256 t1 = _mm256_unpackhi_ps(v0, v1);
+        const __m256 t2 = _mm256_unpacklo_ps(v2, v3);
+        const __m256 t3 = _mm256_unpackhi_ps(v2, v3);
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        r = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), order);
+        g = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), order);
+        b = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), order);
+        a = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)), order);
+    }
+
+    static inline void loadRGBA32F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const float* f = reinterpret_cast<const float*>(p);
+        transpose(_mm256_loadu_ps(f), _mm256_loadu_ps(f + 8), _mm256_loadu_ps(f + 16), _mm256_loadu_ps(f + 24), r, g, b, a);
+    }
+
+    static inline F halfToFloat8(const uint8_t* p)
+    {
+        return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    static inline void loadRGBA16F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        transpose(halfToFloat8(p), halfToFloat8(p + 16), halfToFloat8(p + 32), halfToFloat8(p + 48), r, g, b, a);
+    }
+
+    static inline U toFixed(F v)
+    {
+        // max(v, 0) returns 0 for NaN.
+        v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(65535.f)));
+    }
+
+    static inline U unpremultiplyComponent(U c, __m256 scale, U transparent)
+    {
+        const __m256 v = _mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), scale), _mm256_set1_ps(65535.f));
+        return _mm256_andnot_si256(transparent, _mm256_cvtps_epi32(v));
+    }
+
+    static inline void unpremultiply(U& r, U& g, U& b, U a)
+    {
+        const __m256 scale = _mm256_div_ps(_mm256_set1_ps(65535.f), _mm256_cvtepi32_ps(a));
+        const U transparent = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+        r = unpremultiplyComponent(r, scale, transparent);
+        g = unpremultiplyComponent(g, scale, transparent);
+        b = unpremultiplyComponent(b, scale, transparent);
+    }
+
+#include "PixelConvertKernels.inl"
+}
+
+    const KernelTable AVX2Kernels = {
+        PIXELCONVERT_ALPHA_OPS(AVX2::load), &AVX2::quantize, &AVX2::yuv, &AVX2::interleave8, &AVX2::narrow8,
+        PIXELCONVERT_BYTE_ALPHA_OPS(AVX2::swizzle8), PIXELCONVERT_ALPHA_OPS(AVX2::uyvy8)
+    };
+}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
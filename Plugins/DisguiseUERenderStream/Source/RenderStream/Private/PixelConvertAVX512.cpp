@@ -0,0 +1,149 @@
+#include "PixelConvertInternal.hpp"
+
+#if PIXELCONVERT_X64
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw,avx2,f16c"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx2,f16c")
+#endif
+
+namespace PixelConvert
+{
+namespace Detail
+{
+namespace AVX512
+{
+    typedef __m512i U;
+    typedef __m512 F;
+    constexpr int W = 16;
+
+    static inline U load(const uint32_t* p) { return _mm512_load_si512(p); }
+    static inline void store(uint32_t* p, U v) { _mm512_store_si512(p, v); }
+    static inline U loadBytes(const void* p) { return _mm512_loadu_si512(p); }
+    static inline void storeBytes(void* p, U v) { _mm512_storeu_si512(p, v); }
+    static inline U set1(int32_t v) { return _mm512_set1_epi32(v); }
+    static inline U add(U a, U b) { return _mm512_add_epi32(a, b); }
+    static inline U sub(U a, U b) { return _mm512_sub_epi32(a, b); }
+    static inline U mul(U a, U b) { return _mm512_mullo_epi32(a, b); }
+    static inline U or_(U a, U b) { return _mm512_or_si512(a, b); }
+    static inline U xor_(U a, U b) { return _mm512_xor_si512(a, b); }
+    static inline U sll8(U v) { return _mm512_slli_epi32(v, 8); }
+    static inline U srl1(U v) { return _mm512_srli_epi32(v, 1); }
+    static inline U srl8(U v) { return _mm512_srli_epi32(v, 8); }
+    static inline U srl16(U v) { return _mm512_srli_epi32(v, 16); }
+    static inline U sraYuv(U v) { return _mm512_srai_epi32(v, YuvShift); }
+    static inline U minimum(U a, U b) { return _mm512_min_epi32(a, b); }
+    static inline U maximum(U a, U b) { return _mm512_max_epi32(a, b); }
+    static inline U shuffleBytes(U v, U control) { return _mm512_shuffle_epi8(v, control); }
+
+    static inline void deinterleave(U lo, U hi, U& even, U& odd)
+    {
+        const __m512i evenIndex = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        const __m512i oddIndex = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        even = _mm512_permutex2var_epi32(lo, evenIndex, hi);
+        odd = _mm512_permutex2var_epi32(lo, oddIndex, hi);
+    }
+
+    static inline U bytes4(U c0, U c1, U c2, U c3)
+    {
+        return _mm512_or_si512(_mm512_or_si512(c0, _mm512_slli_epi32(c1, 8)), _mm512_or_si512(_mm512_slli_epi32(c2, 16), _mm512_slli_epi32(c3, 24)));
+    }
+
+    static inline void narrow16(uint8_t* dst, const uint32_t* c)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm512_cvtepi32_epi8(load(c)));
+    }
+
+    static inline void storeWords(uint8_t* dst, U v)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm512_cvtepi32_epi16(v));
+    }
+
+    static inline U widen(U v)
+    {
+        return _mm512_or_si512(_mm512_slli_epi32(v, 8), v); // x * 257
+    }
+
+    static inline void unpack8(U v, U& c0, U& c1, U& c2, U& c3)
+    {
+        const __m512i mask = _mm512_set1_epi32(0xff);
+        c0 = _mm512_and_si512(v, mask);
+        c1 = _mm512_and_si512(_mm512_srli_epi32(v, 8), mask);
+        c2 = _mm512_and_si512(_mm512_srli_epi32(v, 16), mask);
+        c3 = _mm512_srli_epi32(v, 24);
+    }
+
+    // v0..v3 each hold four pixels. A 4x4 transpose per lane leaves pixel 4 * i + lane in element 4 * lane + i,
+    // which the final permute puts back in pixel order.
+    static inline void transpose(F v0, F v1, F v2, F v3, F& r, F& g, F& b, F& a)
+    {
+        const __m512 t0 = _mm512_unpacklo_ps(v0, v1);
+        const __m512 t1 = _mm512_unpackhi_ps(v0, v1);
+        const __m512 t2 = _mm512_unpacklo_ps(v2, v3);
+        const __m512 t3 = _mm512_unpackhi_ps(v2, v3);
+        const __m512i order = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        r = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+        g = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+        b = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+        a = _mm512_permutexvar_ps(order, _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+    }
+
+    static inline void loadRGBA32F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const float* f = reinterpret_cast<const float*>(p);
+        transpose(_mm512_loadu_ps(f), _mm512_loadu_ps(f + 16), _mm512_loadu_ps(f + 32), _mm512_loadu_ps(f + 48), r, g, b, a);
+    }
+
+    static inline F halfToFloat16(const uint8_t* p)
+    {
+        return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+
+    static inline void loadRGBA16F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        transpose(halfToFloat16(p), halfToFloat16(p + 32), halfToFloat16(p + 64), halfToFloat16(p + 96), r, g, b, a);
+    }
+
+    static inline U toFixed(F v)
+    {
+        // max(v, 0) returns 0 for NaN.
+        v = _mm512_min_ps(_mm512_max_ps(v, _mm512_setzero_ps()), _mm512_set1_ps(1.f));
+        return _mm512_cvtps_epi32(_mm512_mul_ps(v, _mm512_set1_ps(65535.f)));
+    }
+
+    static inline U unpremultiplyComponent(U c, __m512 scale, __mmask16 opaque)
+    {
+        const __m512 v = _mm512_min_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(c), scale), _mm512_set1_ps(65535.f));
+        return _mm512_maskz_mov_epi32(opaque, _mm512_cvtps_epi32(v));
+    }
+
+    static inline void unpremultiply(U& r, U& g, U& b, U a)
+    {
+        const __m512 scale = _mm512_div_ps(_mm512_set1_ps(65535.f), _mm512_cvtepi32_ps(a));
+        const __mmask16 opaque = _mm512_test_epi32_mask(a, a);
+        r = unpremultiplyComponent(r, scale, opaque);
+        g = unpremultiplyComponent(g, scale, opaque);
+        b = unpremultiplyComponent(b, scale, opaque);
+    }
+
+#include "PixelConvertKernels.inl"
+}
+
+    const KernelTable AVX512Kernels = {
+        PIXELCONVERT_ALPHA_OPS(AVX512::load), &AVX512::quantize, &AVX512::yuv, &AVX512::interleave8, &AVX512::narrow8,
+        PIXELCONVERT_BYTE_ALPHA_OPS(AVX512::swizzle8), PIXELCONVERT_ALPHA_OPS(AVX512::uyvy8)
+    };
+}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "PixelConvert.hpp"
+
+#include <cstring>
+#include <utility>
+
+// Shared between the scalar reference and the per instruction set kernels of PixelConvert.
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define PIXELCONVERT_X64 1
+#else
+#define PIXELCONVERT_X64 0
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define PIXELCONVERT_ARM64 1
+#else
+#define PIXELCONVERT_ARM64 0
+#endif
+
+namespace PixelConvert
+{
+namespace Detail
+{
+    // Rows are converted in chunks that stay in L1, so every kernel reads and writes frame memory once.
+    constexpr int ChunkPixels = 128;
+    // Tails are padded so that no kernel has to handle partial vectors, YUV kernels consume two vectors at a time.
+    constexpr int MaxVectorPixels = 32;
+
+    constexpr int YuvShift = 19;
+    constexpr int32_t YuvRound = 1 << (YuvShift - 1);
+
+    enum class Layout : uint32_t
+    {
+        Bytes4,     // 8-bit BGRA/RGBA/BGRX/RGBX
+        Uyvy,       // 8-bit UYVY, optionally with an alpha plane
+        Yuv10,
+        Yuv12,
+        Rgb10,
+        Rgb12,
+        Rgba10,
+        Rgba12,
+    };
+
+    struct FormatInfo
+    {
+        Layout layout;
+        int depth;          // Bits per component
+        int groupPixels;    // Pixels per packed group
+        int groupBytes;     // Bytes per packed group
+        bool alphaPlane;
+    };
+
+    const FormatInfo& formatInfo(RenderStreamLink::SenderPixelFormat format);
+
+    // BT.709 limited range in 16-bit fixed point: out = offset + ((c.r * r + c.g * g + c.b * b + YuvRound) >> YuvShift)
+    struct YuvCoefficients
+    {
+        int32_t yr, yg, yb;
+        int32_t ur, ug, ub;
+        int32_t vr, vg, vb;
+        int32_t yOffset, cOffset;
+        int32_t maxValue;
+    };
+
+    const YuvCoefficients& yuvCoefficients(int depth);
+
+    // Quantised components of up to ChunkPixels pixels. r/g/b/a hold 16-bit fixed point after loading and are
+    // quantised in place for RGB layouts. YUV layouts use the pair arrays, y0/y1 being the even/odd luma.
+    struct Chunk
+    {
+        alignas(64) uint32_t r[ChunkPixels];
+        alignas(64) uint32_t g[ChunkPixels];
+        alignas(64) uint32_t b[ChunkPixels];
+        alignas(64) uint32_t a[ChunkPixels];
+        alignas(64) uint32_t y0[ChunkPixels / 2];
+        alignas(64) uint32_t y1[ChunkPixels / 2];
+        alignas(64) uint32_t cb[ChunkPixels / 2];
+        alignas(64) uint32_t cr[ChunkPixels / 2];
+    };
+
+    constexpr size_t AlphaOpCount = size_t(AlphaOp::Count);
+    constexpr size_t ByteAlphaOpCount = size_t(AlphaOp::Invert) + 1; // Operations a byte shuffle can do
+
+    // Kernel tables hold one instantiation per alpha operation, indexed by AlphaOp.
+#define PIXELCONVERT_ALPHA_OPS(fn) { &fn<AlphaOp::None>, &fn<AlphaOp::SetOne>, &fn<AlphaOp::Invert>, &fn<AlphaOp::Premultiply>, &fn<AlphaOp::Unpremultiply> }
+#define PIXELCONVERT_BYTE_ALPHA_OPS(fn) { &fn<AlphaOp::None>, &fn<AlphaOp::SetOne>, &fn<AlphaOp::Invert> }
+
+    struct KernelTable
+    {
+        // Loads count pixels (a multiple of MaxVectorPixels) as 16-bit fixed point and applies the alpha operation.
+        void (*load[AlphaOpCount])(SourceFormat format, const uint8_t* src, int count, Chunk& chunk);
+        // Quantises r/g/b/a to depth bits in place.
+        void (*quantize)(Chunk& chunk, int count, int depth);
+        // Fills y0/y1/cb/cr from r/g/b at depth bits and quantises a to 8 bits.
+        void (*yuv)(Chunk& chunk, int count, int depth);
+        // Writes count groups of four bytes taken from four component arrays.
+        void (*interleave8)(uint8_t* dst, const uint32_t* c0, const uint32_t* c1, const uint32_t* c2, const uint32_t* c3, int count);
+        // Writes count bytes.
+        void (*narrow8)(uint8_t* dst, const uint32_t* c, int count);
+        // 8-bit BGRA/RGBA to any of the four byte layouts, count pixels in any number.
+        void (*swizzle8[ByteAlphaOpCount])(const uint8_t* src, bool rgbaSource, uint8_t* dst, int count, RenderStreamLink::SenderPixelFormat format);
+        // 8-bit BGRA/RGBA straight to UYVY and, when alpha is set, 8-bit alpha. count is a multiple of MaxVectorPixels.
+        void (*uyvy8[AlphaOpCount])(const uint8_t* src, bool rgbaSource, int count, uint8_t* dst, uint8_t* alpha);
+    };
+
+    extern const KernelTable ScalarKernels;
+#if PIXELCONVERT_X64
+    extern const KernelTable SSE4Kernels;
+    extern const KernelTable AVX2Kernels;
+    extern const KernelTable AVX512Kernels;
+#endif
+#if PIXELCONVERT_ARM64
+    extern const KernelTable NEONKernels;
+#endif
+
+    void convertRow(const KernelTable& kernels, const Image& image, int row);
+
+    inline uint32_t quantize(uint32_t value, int depth)
+    {
+        return (value * ((1u << depth) - 1) + 0x8000u) >> 16;
+    }
+
+    // round(c * a / 65535) without a division, exact over the whole 16-bit range.
+    inline uint32_t premultiply(uint32_t c, uint32_t a)
+    {
+        const uint32_t x = c * a + 0x8000u;
+        return (x + (x >> 16)) >> 16;
+    }
+
+    inline bool isByteSource(SourceFormat format)
+    {
+        return format == SourceFormat::BGRA8 || format == SourceFormat::RGBA8;
+    }
+
+    // Byte order and X handling for the swizzle kernels: source byte index per destination byte.
+    inline void swizzleOrder(RenderStreamLink::SenderPixelFormat format, bool rgbaSource, int order[4], bool& opaque)
+    {
+        const bool rgb = (format == RenderStreamLink::FMT_RGBA || format == RenderStreamLink::FMT_RGBX) != rgbaSource;
+        order[0] = rgb ? 2 : 0;
+        order[1] = 1;
+        order[2] = rgb ? 0 : 2;
+        order[3] = 3;
+        opaque = format == RenderStreamLink::FMT_BGRX || format == RenderStreamLink::FMT_RGBX;
+    }
+
+    inline float halfToFloat(uint16_t h)
+    {
+        const uint32_t shiftedExp = 0x7c00u << 13;
+        uint32_t o = uint32_t(h & 0x7fff) << 13;
+        const uint32_t exp = shiftedExp & o;
+        o += (127 - 15) << 23;
+        if (exp == shiftedExp)
+        {
+            o += (128 - 16) << 23; // Inf/NaN
+        }
+        else if (exp == 0)
+        {
+            o += 1 << 23; // Denormal, renormalise
+            float f;
+            std::memcpy(&f, &o, sizeof(f));
+            f -= 6.10351562e-05f; // 2^-14
+            std::memcpy(&o, &f, sizeof(o));
+        }
+        o |= uint32_t(h & 0x8000) << 16;
+        float result;
+        std::memcpy(&result, &o, sizeof(result));
+        return result;
+    }
+}
+}
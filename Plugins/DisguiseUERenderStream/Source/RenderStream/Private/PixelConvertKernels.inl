@@ -0,0 +1,265 @@
+// Vector kernels shared by every instruction set. Included once per instruction set, inside the namespace of
+// PixelConvertSSE4.cpp, PixelConvertAVX2.cpp, ... which provides:
+//   U, F                   32-bit integer and float lanes
+//   W                      pixels per vector
+//   load, store            aligned uint32_t arrays
+//   loadBytes, storeBytes  unaligned bytes
+//   set1, add, sub, mul, or_, xor_, sll8, srl1, srl8, srl16, sraYuv, minimum, maximum
+//   deinterleave           splits two vectors into even and odd lanes
+//   unpack8                splits 4-byte pixels into their four bytes
+//   widen                  8-bit value to 16-bit fixed point
+//   bytes4                 packs four vectors of byte values into 4-byte groups
+//   narrow16               writes 16 byte values
+//   storeWords             writes the low 16 bits of every lane
+//   shuffleBytes           byte shuffle within each 16-byte lane
+//   loadRGBA16F, loadRGBA32F, toFixed
+//   unpremultiply          divides r/g/b by a in single precision, 0 where a is 0
+// No include guard on purpose.
+
+// Alpha operations on 16-bit fixed point, one specialisation per AlphaOp so the unused ones cost nothing.
+template <AlphaOp Op>
+struct Alpha
+{
+    static void apply(U&, U&, U&, U&) {}
+};
+
+template <>
+struct Alpha<AlphaOp::SetOne>
+{
+    static void apply(U&, U&, U&, U& a) { a = set1(0xffff); }
+};
+
+template <>
+struct Alpha<AlphaOp::Invert>
+{
+    static void apply(U&, U&, U&, U& a) { a = sub(set1(0xffff), a); }
+};
+
+template <>
+struct Alpha<AlphaOp::Premultiply>
+{
+    // Same as premultiply() in PixelConvertInternal.hpp, c * a fits the lane as an unsigned value.
+    static U scale(U c, U a)
+    {
+        const U x = add(mul(c, a), set1(0x8000));
+        return srl16(add(x, srl16(x)));
+    }
+
+    static void apply(U& r, U& g, U& b, U& a)
+    {
+        r = scale(r, a);
+        g = scale(g, a);
+        b = scale(b, a);
+    }
+};
+
+template <>
+struct Alpha<AlphaOp::Unpremultiply>
+{
+    static void apply(U& r, U& g, U& b, U& a) { unpremultiply(r, g, b, a); }
+};
+
+template <AlphaOp Op>
+static void storePixels(Chunk& chunk, int i, U r, U g, U b, U a)
+{
+    Alpha<Op>::apply(r, g, b, a);
+    store(chunk.r + i, r);
+    store(chunk.g + i, g);
+    store(chunk.b + i, b);
+    store(chunk.a + i, a);
+}
+
+template <AlphaOp Op>
+static void load(SourceFormat format, const uint8_t* src, int count, Chunk& chunk)
+{
+    switch (format)
+    {
+    case SourceFormat::BGRA8:
+    case SourceFormat::RGBA8:
+        for (int i = 0; i < count; i += W)
+        {
+            U c0, c1, c2, c3;
+            unpack8(loadBytes(src + i * 4), c0, c1, c2, c3);
+            if (format == SourceFormat::RGBA8)
+                std::swap(c0, c2);
+            storePixels<Op>(chunk, i, widen(c2), widen(c1), widen(c0), widen(c3));
+        }
+        break;
+    case SourceFormat::RGBA16F:
+        for (int i = 0; i < count; i += W)
+        {
+            F r, g, b, a;
+            loadRGBA16F(src + i * 8, r, g, b, a);
+            storePixels<Op>(chunk, i, toFixed(r), toFixed(g), toFixed(b), toFixed(a));
+        }
+        break;
+    case SourceFormat::RGBA32F:
+    default:
+        for (int i = 0; i < count; i += W)
+        {
+            F r, g, b, a;
+            loadRGBA32F(src + i * 16, r, g, b, a);
+            storePixels<Op>(chunk, i, toFixed(r), toFixed(g), toFixed(b), toFixed(a));
+        }
+        break;
+    }
+}
+
+static void quantizeComponent(uint32_t* c, int count, U scale)
+{
+    const U round = set1(0x8000);
+    for (int i = 0; i < count; i += W)
+        store(c + i, srl16(add(mul(load(c + i), scale), round)));
+}
+
+static void quantize(Chunk& chunk, int count, int depth)
+{
+    const U scale = set1((1 << depth) - 1);
+    quantizeComponent(chunk.r, count, scale);
+    quantizeComponent(chunk.g, count, scale);
+    quantizeComponent(chunk.b, count, scale);
+    quantizeComponent(chunk.a, count, scale);
+}
+
+static U weigh(U r, U g, U b, U cr, U cg, U cb, U offset)
+{
+    return add(offset, sraYuv(add(add(add(mul(cr, r), mul(cg, g)), mul(cb, b)), set1(YuvRound))));
+}
+
+static void yuv(Chunk& chunk, int count, int depth)
+{
+    const YuvCoefficients& c = yuvCoefficients(depth);
+    const U yr = set1(c.yr), yg = set1(c.yg), yb = set1(c.yb);
+    const U ur = set1(c.ur), ug = set1(c.ug), ub = set1(c.ub);
+    const U vr = set1(c.vr), vg = set1(c.vg), vb = set1(c.vb);
+    const U yOffset = set1(c.yOffset), cOffset = set1(c.cOffset);
+    const U zero = set1(0), one = set1(1), maxValue = set1(c.maxValue);
+
+    for (int i = 0; i < count; i += 2 * W)
+    {
+        U r0, r1, g0, g1, b0, b1;
+        deinterleave(load(chunk.r + i), load(chunk.r + i + W), r0, r1);
+        deinterleave(load(chunk.g + i), load(chunk.g + i + W), g0, g1);
+        deinterleave(load(chunk.b + i), load(chunk.b + i + W), b0, b1);
+
+        const int j = i / 2;
+        store(chunk.y0 + j, weigh(r0, g0, b0, yr, yg, yb, yOffset));
+        store(chunk.y1 + j, weigh(r1, g1, b1, yr, yg, yb, yOffset));
+
+        const U r = srl1(add(add(r0, r1), one));
+        const U g = srl1(add(add(g0, g1), one));
+        const U b = srl1(add(add(b0, b1), one));
+        store(chunk.cb + j, minimum(maximum(weigh(r, g, b, ur, ug, ub, cOffset), zero), maxValue));
+        store(chunk.cr + j, minimum(maximum(weigh(r, g, b, vr, vg, vb, cOffset), zero), maxValue));
+    }
+    quantizeComponent(chunk.a, count, set1(255));
+}
+
+static void interleave8(uint8_t* dst, const uint32_t* c0, const uint32_t* c1, const uint32_t* c2, const uint32_t* c3, int count)
+{
+    int i = 0;
+    for (; i + W <= count; i += W)
+        storeBytes(dst + i * 4, bytes4(load(c0 + i), load(c1 + i), load(c2 + i), load(c3 + i)));
+    for (; i < count; ++i)
+    {
+        dst[i * 4 + 0] = uint8_t(c0[i]);
+        dst[i * 4 + 1] = uint8_t(c1[i]);
+        dst[i * 4 + 2] = uint8_t(c2[i]);
+        dst[i * 4 + 3] = uint8_t(c3[i]);
+    }
+}
+
+static void narrow8(uint8_t* dst, const uint32_t* c, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+        narrow16(dst + i, c + i);
+    for (; i < count; ++i)
+        dst[i] = uint8_t(c[i]);
+}
+
+// Byte shuffle, with SetOne and Invert done on the alpha byte as an or and an xor.
+template <AlphaOp Op>
+static void swizzle8(const uint8_t* src, bool rgbaSource, uint8_t* dst, int count, RenderStreamLink::SenderPixelFormat format)
+{
+    int order[4];
+    bool opaque;
+    swizzleOrder(format, rgbaSource, order, opaque);
+    const uint8_t fillByte = opaque || Op == AlphaOp::SetOne ? 255 : 0;
+    const uint8_t flipByte = Op == AlphaOp::Invert ? 255 : 0;
+
+    alignas(64) uint8_t control[W * 4];
+    alignas(64) uint8_t fill[W * 4];
+    alignas(64) uint8_t flip[W * 4];
+    for (int k = 0; k < W * 4; ++k)
+    {
+        control[k] = uint8_t((k & 0xc) + order[k & 3]);
+        fill[k] = (k & 3) == 3 ? fillByte : 0;
+        flip[k] = (k & 3) == 3 ? flipByte : 0;
+    }
+    const U shuffle = loadBytes(control);
+    const U alphaFill = loadBytes(fill);
+    const U alphaFlip = loadBytes(flip);
+
+    int i = 0;
+    for (; i + W <= count; i += W)
+        storeBytes(dst + i * 4, or_(xor_(shuffleBytes(loadBytes(src + i * 4), shuffle), alphaFlip), alphaFill));
+    for (; i < count; ++i)
+    {
+        const uint8_t* p = src + i * 4;
+        uint8_t* q = dst + i * 4;
+        q[0] = p[order[0]];
+        q[1] = p[order[1]];
+        q[2] = p[order[2]];
+        q[3] = uint8_t((p[order[3]] ^ flipByte) | fillByte);
+    }
+}
+
+// Fused 8-bit to UYVY: pixels are split into even and odd while still packed, so each pair is read, converted
+// and written without going through the chunk arrays.
+template <AlphaOp Op>
+static void uyvy8(const uint8_t* src, bool rgbaSource, int count, uint8_t* dst, uint8_t* alpha)
+{
+    const YuvCoefficients& c = yuvCoefficients(8);
+    const U yr = set1(c.yr), yg = set1(c.yg), yb = set1(c.yb);
+    const U ur = set1(c.ur), ug = set1(c.ug), ub = set1(c.ub);
+    const U vr = set1(c.vr), vg = set1(c.vg), vb = set1(c.vb);
+    const U yOffset = set1(c.yOffset), cOffset = set1(c.cOffset);
+    const U zero = set1(0), one = set1(1), maxValue = set1(c.maxValue);
+
+    for (int i = 0; i < count; i += 2 * W)
+    {
+        U even, odd;
+        deinterleave(loadBytes(src + i * 4), loadBytes(src + i * 4 + W * 4), even, odd);
+
+        U b0, g0, r0, a0, b1, g1, r1, a1;
+        unpack8(even, b0, g0, r0, a0);
+        unpack8(odd, b1, g1, r1, a1);
+        if (rgbaSource)
+        {
+            std::swap(r0, b0);
+            std::swap(r1, b1);
+        }
+        r0 = widen(r0);
+        g0 = widen(g0);
+        b0 = widen(b0);
+        a0 = widen(a0);
+        r1 = widen(r1);
+        g1 = widen(g1);
+        b1 = widen(b1);
+        a1 = widen(a1);
+        Alpha<Op>::apply(r0, g0, b0, a0);
+        Alpha<Op>::apply(r1, g1, b1, a1);
+
+        const U r = srl1(add(add(r0, r1), one));
+        const U g = srl1(add(add(g0, g1), one));
+        const U b = srl1(add(add(b0, b1), one));
+        const U cb = minimum(maximum(weigh(r, g, b, ur, ug, ub, cOffset), zero), maxValue);
+        const U cr = minimum(maximum(weigh(r, g, b, vr, vg, vb, cOffset), zero), maxValue);
+        storeBytes(dst + i * 2, bytes4(cb, weigh(r0, g0, b0, yr, yg, yb, yOffset), cr, weigh(r1, g1, b1, yr, yg, yb, yOffset)));
+
+        // Alpha stays a multiple of 257 here, so dropping the low byte is the exact 8-bit quantisation.
+        if (alpha)
+            storeWords(alpha + i, or_(srl8(a0), sll8(srl8(a1))));
+    }
+}
@@ -0,0 +1,129 @@
+#include "PixelConvertInternal.hpp"
+
+#if PIXELCONVERT_ARM64
+
+#include <arm_neon.h>
+
+namespace PixelConvert
+{
+namespace Detail
+{
+namespace NEON
+{
+    typedef int32x4_t U;
+    typedef float32x4_t F;
+    constexpr int W = 4;
+
+    static inline U load(const uint32_t* p) { return vreinterpretq_s32_u32(vld1q_u32(p)); }
+    static inline void store(uint32_t* p, U v) { vst1q_u32(p, vreinterpretq_u32_s32(v)); }
+    static inline U loadBytes(const void* p) { return vreinterpretq_s32_u8(vld1q_u8(static_cast<const uint8_t*>(p))); }
+    static inline void storeBytes(void* p, U v) { vst1q_u8(static_cast<uint8_t*>(p), vreinterpretq_u8_s32(v)); }
+    static inline U set1(int32_t v) { return vdupq_n_s32(v); }
+    static inline U add(U a, U b) { return vaddq_s32(a, b); }
+    static inline U sub(U a, U b) { return vsubq_s32(a, b); }
+    static inline U mul(U a, U b) { return vmulq_s32(a, b); }
+    static inline U or_(U a, U b) { return vorrq_s32(a, b); }
+    static inline U xor_(U a, U b) { return veorq_s32(a, b); }
+    static inline U sll8(U v) { return vshlq_n_s32(v, 8); }
+    static inline U srl1(U v) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(v), 1)); }
+    static inline U srl8(U v) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(v), 8)); }
+    static inline U srl16(U v) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(v), 16)); }
+    static inline U sraYuv(U v) { return vshrq_n_s32(v, YuvShift); }
+    static inline U minimum(U a, U b) { return vminq_s32(a, b); }
+    static inline U maximum(U a, U b) { return vmaxq_s32(a, b); }
+
+    static inline U shuffleBytes(U v, U control)
+    {
+        return vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(v), vreinterpretq_u8_s32(control)));
+    }
+
+    static inline void deinterleave(U lo, U hi, U& even, U& odd)
+    {
+        const int32x4x2_t split = vuzpq_s32(lo, hi);
+        even = split.val[0];
+        odd = split.val[1];
+    }
+
+    static inline U bytes4(U c0, U c1, U c2, U c3)
+    {
+        return vorrq_s32(vorrq_s32(c0, vshlq_n_s32(c1, 8)), vorrq_s32(vshlq_n_s32(c2, 16), vshlq_n_s32(c3, 24)));
+    }
+
+    static inline void narrow16(uint8_t* dst, const uint32_t* c)
+    {
+        const uint16x8_t lo = vcombine_u16(vmovn_u32(vld1q_u32(c)), vmovn_u32(vld1q_u32(c + 4)));
+        const uint16x8_t hi = vcombine_u16(vmovn_u32(vld1q_u32(c + 8)), vmovn_u32(vld1q_u32(c + 12)));
+        vst1q_u8(dst, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+
+    static inline void storeWords(uint8_t* dst, U v)
+    {
+        vst1_u8(dst, vreinterpret_u8_u16(vmovn_u32(vreinterpretq_u32_s32(v))));
+    }
+
+    static inline U widen(U v)
+    {
+        return vorrq_s32(vshlq_n_s32(v, 8), v); // x * 257
+    }
+
+    static inline void unpack8(U v, U& c0, U& c1, U& c2, U& c3)
+    {
+        const uint32x4_t u = vreinterpretq_u32_s32(v);
+        const uint32x4_t mask = vdupq_n_u32(0xff);
+        c0 = vreinterpretq_s32_u32(vandq_u32(u, mask));
+        c1 = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(u, 8), mask));
+        c2 = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(u, 16), mask));
+        c3 = vreinterpretq_s32_u32(vshrq_n_u32(u, 24));
+    }
+
+    static inline void loadRGBA32F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const float32x4x4_t v = vld4q_f32(reinterpret_cast<const float*>(p));
+        r = v.val[0];
+        g = v.val[1];
+        b = v.val[2];
+        a = v.val[3];
+    }
+
+    static inline void loadRGBA16F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const uint16x4x4_t v = vld4_u16(reinterpret_cast<const uint16_t*>(p));
+        r = vcvt_f32_f16(vreinterpret_f16_u16(v.val[0]));
+        g = vcvt_f32_f16(vreinterpret_f16_u16(v.val[1]));
+        b = vcvt_f32_f16(vreinterpret_f16_u16(v.val[2]));
+        a = vcvt_f32_f16(vreinterpret_f16_u16(v.val[3]));
+    }
+
+    static inline U toFixed(F v)
+    {
+        // maxnm returns the number when the other operand is NaN, so NaN becomes 0.
+        v = vminq_f32(vmaxnmq_f32(v, vdupq_n_f32(0.f)), vdupq_n_f32(1.f));
+        return vcvtnq_s32_f32(vmulq_f32(v, vdupq_n_f32(65535.f)));
+    }
+
+    static inline U unpremultiplyComponent(U c, F scale, uint32x4_t transparent)
+    {
+        const F v = vminq_f32(vmulq_f32(vcvtq_f32_s32(c), scale), vdupq_n_f32(65535.f));
+        return vreinterpretq_s32_u32(vbicq_u32(vreinterpretq_u32_s32(vcvtnq_s32_f32(v)), transparent));
+    }
+
+    static inline void unpremultiply(U& r, U& g, U& b, U a)
+    {
+        const F scale = vdivq_f32(vdupq_n_f32(65535.f), vcvtq_f32_s32(a));
+        const uint32x4_t transparent = vceqq_s32(a, vdupq_n_s32(0));
+        r = unpremultiplyComponent(r, scale, transparent);
+        g = unpremultiplyComponent(g, scale, transparent);
+        b = unpremultiplyComponent(b, scale, transparent);
+    }
+
+#include "PixelConvertKernels.inl"
+}
+
+    const KernelTable NEONKernels = {
+        PIXELCONVERT_ALPHA_OPS(NEON::load), &NEON::quantize, &NEON::yuv, &NEON::interleave8, &NEON::narrow8,
+        PIXELCONVERT_BYTE_ALPHA_OPS(NEON::swizzle8), PIXELCONVERT_ALPHA_OPS(NEON::uyvy8)
+    };
+}
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include "PixelConvertInternal.hpp"
+
+#if PIXELCONVERT_X64
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1,ssse3")
+#endif
+
+namespace PixelConvert
+{
+namespace Detail
+{
+namespace SSE4
+{
+    typedef __m128i U;
+    typedef __m128 F;
+    constexpr int W = 4;
+
+    static inline U load(const uint32_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+    static inline void store(uint32_t* p, U v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+    static inline U loadBytes(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    static inline void storeBytes(void* p, U v) { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+    static inline U set1(int32_t v) { return _mm_set1_epi32(v); }
+    static inline U add(U a, U b) { return _mm_add_epi32(a, b); }
+    static inline U sub(U a, U b) { return _mm_sub_epi32(a, b); }
+    static inline U mul(U a, U b) { return _mm_mullo_epi32(a, b); }
+    static inline U or_(U a, U b) { return _mm_or_si128(a, b); }
+    static inline U xor_(U a, U b) { return _mm_xor_si128(a, b); }
+    static inline U sll8(U v) { return _mm_slli_epi32(v, 8); }
+    static inline U srl1(U v) { return _mm_srli_epi32(v, 1); }
+    static inline U srl8(U v) { return _mm_srli_epi32(v, 8); }
+    static inline U srl16(U v) { return _mm_srli_epi32(v, 16); }
+    static inline U sraYuv(U v) { return _mm_srai_epi32(v, YuvShift); }
+    static inline U minimum(U a, U b) { return _mm_min_epi32(a, b); }
+    static inline U maximum(U a, U b) { return _mm_max_epi32(a, b); }
+    static inline U shuffleBytes(U v, U control) { return _mm_shuffle_epi8(v, control); }
+
+    static inline void deinterleave(U lo, U hi, U& even, U& odd)
+    {
+        even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+        odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    static inline U bytes4(U c0, U c1, U c2, U c3)
+    {
+        return _mm_or_si128(_mm_or_si128(c0, _mm_slli_epi32(c1, 8)), _mm_or_si128(_mm_slli_epi32(c2, 16), _mm_slli_epi32(c3, 24)));
+    }
+
+    static inline void narrow16(uint8_t* dst, const uint32_t* c)
+    {
+        const __m128i lo = _mm_packus_epi32(load(c), load(c + 4));
+        const __m128i hi = _mm_packus_epi32(load(c + 8), load(c + 12));
+        storeBytes(dst, _mm_packus_epi16(lo, hi));
+    }
+
+    static inline void storeWords(uint8_t* dst, U v)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi32(v, v));
+    }
+
+    static inline U widen(U v)
+    {
+        return _mm_or_si128(_mm_slli_epi32(v, 8), v); // x * 257
+    }
+
+    static inline void unpack8(U v, U& c0, U& c1, U& c2, U& c3)
+    {
+        const __m128i mask = _mm_set1_epi32(0xff);
+        c0 = _mm_and_si128(v, mask);
+        c1 = _mm_and_si128(_mm_srli_epi32(v, 8), mask);
+        c2 = _mm_and_si128(_mm_srli_epi32(v, 16), mask);
+        c3 = _mm_srli_epi32(v, 24);
+    }
+
+    static inline void transpose(F v0, F v1, F v2, F v3, F& r, F& g, F& b, F& a)
+    {
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        r = v0;
+        g = v1;
+        b = v2;
+        a = v3;
+    }
+
+    static inline void loadRGBA32F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const float* f = reinterpret_cast<const float*>(p);
+        transpose(_mm_loadu_ps(f), _mm_loadu_ps(f + 4), _mm_loadu_ps(f + 8), _mm_loadu_ps(f + 12), r, g, b, a);
+    }
+
+    // No F16C here, same bit manipulation as halfToFloat.
+    static inline F halfToFloat4(U h)
+    {
+        const __m128i shiftedExp = _mm_set1_epi32(0x7c00 << 13);
+        __m128i o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+        const __m128i exp = _mm_and_si128(o, shiftedExp);
+        o = _mm_add_epi32(o, _mm_set1_epi32((127 - 15) << 23));
+        o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exp, shiftedExp), _mm_set1_epi32((128 - 16) << 23)));
+        const __m128 denormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), _mm_set1_ps(6.10351562e-05f));
+        o = _mm_blendv_epi8(o, _mm_castps_si128(denormal), _mm_cmpeq_epi32(exp, _mm_setzero_si128()));
+        o = _mm_or_si128(o, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16));
+        return _mm_castsi128_ps(o);
+    }
+
+    static inline void loadRGBA16F(const uint8_t* p, F& r, F& g, F& b, F& a)
+    {
+        const __m128i h01 = loadBytes(p);
+        const __m128i h23 = loadBytes(p + 16);
+        transpose(halfToFloat4(_mm_cvtepu16_epi32(h01)), halfToFloat4(_mm_cvtepu16_epi32(_mm_srli_si128(h01, 8))),
+            halfToFloat4(_mm_cvtepu16_epi32(h23)), halfToFloat4(_mm_cvtepu16_epi32(_mm_srli_si128(h23, 8))), r, g, b, a);
+    }
+
+    static inline U toFixed(F v)
+    {
+        // max(v, 0) returns 0 for NaN.
+        v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(65535.f)));
+    }
+
+    static inline U unpremultiplyComponent(U c, __m128 scale, U transparent)
+    {
+        const __m128 v = _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), scale), _mm_set1_ps(65535.f));
+        return _mm_andnot_si128(transparent, _mm_cvtps_epi32(v));
+    }
+
+    static inline void unpremultiply(U& r, U& g, U& b, U a)
+    {
+        const __m128 scale = _mm_div_ps(_mm_set1_ps(65535.f), _mm_cvtepi32_ps(a));
+        const U transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        r = unpremultiplyComponent(r, scale, transparent);
+        g = unpremultiplyComponent(g, scale, transparent);
+        b = unpremultiplyComponent(b, scale, transparent);
+    }
+
+#include "PixelConvertKernels.inl"
+}
+
+    const KernelTable SSE4Kernels = {
+        PIXELCONVERT_ALPHA_OPS(SSE4::load), &SSE4::quantize, &SSE4::yuv, &SSE4::interleave8, &SSE4::narrow8,
+        PIXELCONVERT_BYTE_ALPHA_OPS(SSE4::swizzle8), PIXELCONVERT_ALPHA_OPS(SSE4::uyvy8)
+    };
+}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
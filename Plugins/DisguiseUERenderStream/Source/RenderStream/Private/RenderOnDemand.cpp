@@ -0,0 +1,70 @@
+#include "RenderOnDemand.hpp"
+
+void RenderOnDemand::configure(const Settings& settings)
+{
+    m_settings = settings;
+    reset();
+}
+
+void RenderOnDemand::reset()
+{
+    m_fingerprint = 0;
+    m_unchanged = 0;
+    m_seen = false;
+    m_lastIdleRender = 0;
+}
+
+RenderOnDemand::Decision RenderOnDemand::next(uint64_t fingerprint, bool receiving, int64_t now)
+{
+    Decision decision;
+    if (!receiving)
+    {
+        // Whatever was kept may be stale by the time d3 comes back.
+        m_seen = false;
+        const int64_t interval = m_settings.idleRate > 0. ? int64_t(1e9 / m_settings.idleRate) : 0;
+        if (interval > 0 && m_lastIdleRender != 0 && now - m_lastIdleRender < interval)
+        {
+            decision.action = Action::Skip;
+            ++m_stats.skipped;
+            return decision;
+        }
+        m_lastIdleRender = now;
+        ++m_stats.rendered;
+        return decision;
+    }
+    m_lastIdleRender = 0;
+
+    if (m_settings.policy == Policy::Always)
+    {
+        ++m_stats.rendered;
+        return decision;
+    }
+
+    if (!m_seen || fingerprint != m_fingerprint)
+    {
+        m_fingerprint = fingerprint;
+        m_seen = true;
+        m_unchanged = 0;
+    }
+    else if (m_unchanged <= m_settings.settleFrames)
+    {
+        ++m_unchanged;
+    }
+
+    if (m_unchanged <= m_settings.settleFrames)
+    {
+        decision.keep = m_settings.policy == Policy::Resend && m_unchanged == m_settings.settleFrames;
+        ++m_stats.rendered;
+    }
+    else if (m_settings.policy == Policy::Resend)
+    {
+        decision.action = Action::Resend;
+        ++m_stats.resent;
+    }
+    else
+    {
+        decision.action = Action::Skip;
+        ++m_stats.skipped;
+    }
+    return decision;
+}
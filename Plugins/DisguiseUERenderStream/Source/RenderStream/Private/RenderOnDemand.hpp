@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+// Decides frame by frame whether a capture renders its view, for scenes that only change with what d3 sends. The
+// inputs of a frame, the camera rendered with the scene and parameters applied, are reduced to a fingerprint. Once it
+// has held for a few frames, letting temporal effects settle, the last frame is kept and following frames with the
+// same fingerprint repeat it, or are not sent at all. While nothing is received from d3 frames are rendered at a
+// trickle instead. Times are LatencyTracer::now() nanoseconds.
+class RenderOnDemand
+{
+public:
+    enum class Policy : uint8_t
+    {
+        Always,     // Render every frame
+        Resend,     // Send the kept frame again while the inputs are unchanged
+        Suppress,   // Send nothing while the inputs are unchanged
+    };
+
+    enum class Action : uint8_t
+    {
+        Render,
+        Resend,
+        Skip,
+    };
+
+    struct Settings
+    {
+        Policy policy = Policy::Always;
+        uint32_t settleFrames = 8;      // Rendered with unchanged inputs before rendering stops
+        double idleRate = 0.;           // Frames per second while nothing is received, 0 for every frame
+    };
+
+    struct Decision
+    {
+        Action action = Action::Render;
+        bool keep = false;              // Rendered for the last time, later frames may repeat it
+    };
+
+    struct Stats
+    {
+        uint64_t rendered = 0;
+        uint64_t resent = 0;
+        uint64_t skipped = 0;
+    };
+
+    void configure(const Settings& settings);
+    void reset();
+
+    // The decision for the next frame, with inputs hashed to fingerprint.
+    Decision next(uint64_t fingerprint, bool receiving, int64_t now);
+
+    // True when the defaults apply and every frame is rendered.
+    bool always() const { return m_settings.policy == Policy::Always && m_settings.idleRate <= 0.; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    Settings m_settings;
+    uint64_t m_fingerprint = 0;
+    uint32_t m_unchanged = 0;           // Frames since the fingerprint last changed, up to settleFrames + 1
+    bool m_seen = false;
+    int64_t m_lastIdleRender = 0;
+    Stats m_stats;
+};
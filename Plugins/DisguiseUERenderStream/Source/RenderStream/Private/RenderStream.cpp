@@ -4,22 +4,35 @@
 
 #include "RenderStreamSettings.h"
 #include "RenderStreamMediaCapture.h"
+#include "RenderStreamEvents.h"
 
 #include "Core/Public/Modules/ModuleManager.h"
 #include "CoreUObject/Public/Misc/PackageName.h"
 #include "Misc/CoreDelegates.h"
-#include "Json/Public/Serialization/JsonSerializer.h"
 #include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Parse.h"
 
 #include "Kismet/GameplayStatics.h"
 #include "Engine/LevelStreaming.h"
 #include "Engine/LevelScriptActor.h"
+#include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "Camera/CameraActor.h"
 #include "ShaderCore.h"
+#include "RHI.h"
+#include "RenderCore.h"
 
 #include "Interfaces/IPluginManager.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
 #include "fnv.hpp"
+#include "ParameterDiff.hpp"
+#include <chrono>
+#include <initializer_list>
 #include <map>
 
 
@@ -27,6 +40,15 @@ DEFINE_LOG_CATEGORY(LogRenderStream);
 
 #define LOCTEXT_NAMESPACE "FRenderStreamModule"
 
+// Latency of every frame sent, traced with -trace=counters. Each value is set once the frame is sent, with the frame id
+// set alongside to match it to d3's frame.
+TRACE_DECLARE_INT_COUNTER(RenderStreamLatencyFrameId, TEXT("RenderStream/Latency/FrameId"));
+TRACE_DECLARE_FLOAT_COUNTER(RenderStreamLatencyApplied, TEXT("RenderStream/Latency/Applied (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(RenderStreamLatencyUserData, TEXT("RenderStream/Latency/UserData (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(RenderStreamLatencyCaptured, TEXT("RenderStream/Latency/Captured (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(RenderStreamLatencySent, TEXT("RenderStream/Latency/Sent (ms)"));
+TRACE_DECLARE_FLOAT_COUNTER(RenderStreamLatencyTotal, TEXT("RenderStream/Latency/Total (ms)"));
+
 namespace {
     void log_default(const char* text) {
         UE_LOG(LogRenderStream, Log, TEXT("%s"), ANSI_TO_TCHAR(text));
@@ -39,6 +61,57 @@ namespace {
     void log_error(const char* text) {
         UE_LOG(LogRenderStream, Error, TEXT("%s"), ANSI_TO_TCHAR(text));
     }
+
+    void logLatency()
+    {
+        const LatencyTracer& latency = FRenderStreamModule::Get()->Latency();
+        for (size_t i = 1; i <= LatencyTracer::TotalIndex; ++i)
+        {
+            const LatencyTracer::Summary s = latency.summary(i);
+            UE_LOG(LogRenderStream, Log, TEXT("Latency %-9s %8llu frames  p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms"), ANSI_TO_TCHAR(LatencyTracer::stageName(i)),
+                uint64(s.count), double(s.p50) / 1e6, double(s.p99) / 1e6, double(s.max) / 1e6);
+        }
+        const LatencyHistogram& switches = FRenderStreamModule::Get()->SceneSwitchTime();
+        UE_LOG(LogRenderStream, Log, TEXT("Scene switch %8llu times   p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms"),
+            uint64(switches.count()), double(switches.percentile(50.)) / 1e6, double(switches.percentile(99.)) / 1e6, double(switches.max()) / 1e6);
+    }
+
+    FAutoConsoleCommand LatencyCommand(
+        TEXT("RenderStream.Latency"),
+        TEXT("Logs p50, p99 and max latency of every stage from receiving d3 frame data to rs_sendFrame, and of scene switches."),
+        FConsoleCommandDelegate::CreateStatic(&logLatency));
+
+    FAutoConsoleCommand LatencyResetCommand(
+        TEXT("RenderStream.LatencyReset"),
+        TEXT("Clears the RenderStream latency histograms."),
+        FConsoleCommandDelegate::CreateLambda([]() { FRenderStreamModule::Get()->Latency().reset(); FRenderStreamModule::Get()->SceneSwitchTime().reset(); }));
+
+    FAutoConsoleCommand LatencyDumpCommand(
+        TEXT("RenderStream.LatencyDump"),
+        TEXT("Writes the RenderStream latency histograms as CSV, to the given path or Saved/Profiling/RenderStreamLatency.csv."),
+        FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            const FString Path = Args.Num() > 0 ? Args[0] : FPaths::Combine(FPaths::ProfilingDir(), TEXT("RenderStreamLatency.csv"));
+            IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+            if (FRenderStreamModule::Get()->Latency().writeCsv(TCHAR_TO_UTF8(*Path)))
+                UE_LOG(LogRenderStream, Log, TEXT("Wrote latency to %s"), *Path);
+            else
+                UE_LOG(LogRenderStream, Error, TEXT("Unable to write latency to %s"), *Path);
+        }));
+
+    FAutoConsoleCommand RecordCommand(
+        TEXT("RenderStream.Record"),
+        TEXT("Records every frame received from d3 to the given session log, or to Saved/Profiling/RenderStream-<time>.rslog. Replay with -RenderStreamReplay=<path>."),
+        FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            const FString Path = Args.Num() > 0 ? Args[0] : FPaths::Combine(FPaths::ProfilingDir(), FString::Printf(TEXT("RenderStream-%s.rslog"), *FDateTime::Now().ToString()));
+            FRenderStreamModule::Get()->StartRecording(Path);
+        }));
+
+    FAutoConsoleCommand StopRecordingCommand(
+        TEXT("RenderStream.StopRecording"),
+        TEXT("Finishes the RenderStream session log being recorded."),
+        FConsoleCommandDelegate::CreateLambda([]() { FRenderStreamModule::Get()->StopRecording(); }));
 }
 
 void RenderStreamStatus::setInputAndOutputStatuses(const FString& topText, const FString& bottomText, const FSlateColor& color)
@@ -79,6 +152,10 @@ void FRenderStreamModule::StartupModule()
     }
     else
     {
+        RenderStreamLink::instance().rs_registerLoggingFunc(&log_default);
+        RenderStreamLink::instance().rs_registerErrorLoggingFunc(&log_error);
+        RenderStreamLink::instance().rs_registerVerboseLoggingFunc(&log_verbose);
+
         int major, minor;
         RenderStreamLink::instance().rs_getVersion(&major, &minor);
         UE_LOG(LogRenderStream, Log, TEXT("Loaded d3renderstream.dll version %i.%i."), major, minor);
@@ -109,6 +186,22 @@ void FRenderStreamModule::StartupModule()
             return;
         }
         UE_LOG(LogRenderStream, Log, TEXT("Created Asset '%s'"), *assetName);
+
+        // Replay swaps the library's frame data entry points, so it has to start before anything waits on them.
+        FString ReplayPath;
+        if (FParse::Value(FCommandLine::Get(), TEXT("RenderStreamReplay="), ReplayPath) && !ReplayPath.IsEmpty())
+        {
+            float Speed = 1.f;
+            FParse::Value(FCommandLine::Get(), TEXT("RenderStreamReplaySpeed="), Speed);
+            const bool Loop = FParse::Param(FCommandLine::Get(), TEXT("RenderStreamReplayLoop"));
+            RenderStreamLink::instance().startReplay(TCHAR_TO_UTF8(*ReplayPath), m_assetHandle, Speed, Loop);
+        }
+
+        m_receiver = MakeUnique<FrameReceiver>(m_assetHandle);
+
+        FString RecordPath;
+        if (FParse::Value(FCommandLine::Get(), TEXT("RenderStreamRecord="), RecordPath) && !RecordPath.IsEmpty())
+            StartRecording(RecordPath);
     }
 
     OnBeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FRenderStreamModule::OnBeginFrame);
@@ -116,6 +209,8 @@ void FRenderStreamModule::StartupModule()
 
 void FRenderStreamModule::ShutdownModule()
 {
+    m_converter.Reset();
+
     if (!RenderStreamLink::instance().isAvailable())
         return;
 
@@ -123,6 +218,17 @@ void FRenderStreamModule::ShutdownModule()
 
     FCoreDelegates::OnBeginFrame.Remove(OnBeginFrameHandle);
 
+    // The receive thread may be inside rs_awaitFrameData, stop it before the asset and library go away.
+    StopRecording();
+    if (m_receiver)
+    {
+        const FrameReceiver::Stats stats = m_receiver->stats();
+        UE_LOG(LogRenderStream, Log, TEXT("Received %llu frames, %llu failed waits, %llu frames never used"), uint64(stats.received), uint64(stats.failed), uint64(stats.overwritten));
+        m_receiver.Reset();
+    }
+    if (m_latency.frames() > 0)
+        logLatency();
+
     if (m_assetHandle != 0)
         RenderStreamLink::instance().rs_destroyAsset(&m_assetHandle);
 
@@ -134,6 +240,76 @@ void FRenderStreamModule::ShutdownModule()
     }
 }
 
+bool FRenderStreamModule::StartRecording(const FString& Path)
+{
+    if (!m_receiver)
+    {
+        UE_LOG(LogRenderStream, Error, TEXT("Unable to record, RenderStream is not running"));
+        return false;
+    }
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+    std::unique_ptr<SessionWriter> Writer = SessionWriter::create(TCHAR_TO_UTF8(*Path));
+    if (!Writer)
+    {
+        UE_LOG(LogRenderStream, Error, TEXT("Unable to create session log %s"), *Path);
+        return false;
+    }
+
+    StopRecording();
+    m_receiver->startRecording(std::move(Writer));
+    UE_LOG(LogRenderStream, Log, TEXT("Recording RenderStream session to %s"), *Path);
+    return true;
+}
+
+void FRenderStreamModule::StopRecording()
+{
+    if (!m_receiver)
+        return;
+
+    std::unique_ptr<SessionWriter> Writer = m_receiver->stopRecording();
+    if (!Writer)
+        return;
+    Writer->close();
+    UE_LOG(LogRenderStream, Log, TEXT("Recorded %llu frames, %llu bytes to %s"), uint64(Writer->frames()), uint64(Writer->bytes()), UTF8_TO_TCHAR(Writer->path().c_str()));
+}
+
+ConvertScheduler& FRenderStreamModule::Converter()
+{
+    const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+    const size_t threads = size_t(FMath::Max(settings ? settings->ConversionThreads : URenderStreamSettings::ConversionThreadsDefault, 0));
+    const uint64_t affinity = uint64_t(settings ? settings->ConversionAffinityMask : URenderStreamSettings::ConversionAffinityMaskDefault);
+    if (!m_converter || m_converter->requestedThreads() != threads || m_converter->affinityMask() != affinity)
+    {
+        m_converter.Reset();
+        m_converter = MakeUnique<ConvertScheduler>(threads, affinity);
+        UE_LOG(LogRenderStream, Log, TEXT("Converting frames on %llu threads"), uint64(m_converter->threadCount()));
+    }
+    return *m_converter;
+}
+
+void FRenderStreamModule::RecordLatency(const LatencyTracer::Trace& Trace)
+{
+    m_latency.record(Trace);
+
+    int64_t Durations[LatencyTracer::TotalIndex + 1];
+    if (!LatencyTracer::durations(Trace, Durations))
+        return;
+
+    TRACE_COUNTER_SET(RenderStreamLatencyFrameId, int64(Trace.frameId));
+    // Stages the frame did not reach, such as user data for texture frames, keep their previous value.
+    if (Durations[size_t(LatencyTracer::Stage::Applied)] >= 0)
+        TRACE_COUNTER_SET(RenderStreamLatencyApplied, double(Durations[size_t(LatencyTracer::Stage::Applied)]) / 1e6);
+    if (Durations[size_t(LatencyTracer::Stage::UserData)] >= 0)
+        TRACE_COUNTER_SET(RenderStreamLatencyUserData, double(Durations[size_t(LatencyTracer::Stage::UserData)]) / 1e6);
+    if (Durations[size_t(LatencyTracer::Stage::Captured)] >= 0)
+        TRACE_COUNTER_SET(RenderStreamLatencyCaptured, double(Durations[size_t(LatencyTracer::Stage::Captured)]) / 1e6);
+    if (Durations[size_t(LatencyTracer::Stage::Sent)] >= 0)
+        TRACE_COUNTER_SET(RenderStreamLatencySent, double(Durations[size_t(LatencyTracer::Stage::Sent)]) / 1e6);
+    if (Durations[LatencyTracer::TotalIndex] >= 0)
+        TRACE_COUNTER_SET(RenderStreamLatencyTotal, double(Durations[LatencyTracer::TotalIndex]) / 1e6);
+}
+
 bool FRenderStreamModule::SupportsAutomaticShutdown ()
 {
     return true;
@@ -144,64 +320,198 @@ bool FRenderStreamModule::SupportsDynamicReloading ()
     return true;
 }
 
-void validateField(StreamFNV& fnv, FString key_, FString undecoratedSuffix, const TSharedPtr< FJsonValue >& JsonValue)
+bool FRenderStreamModule::RefreshSchemaSource(const FString& SchemaPath)
 {
-    if (!JsonValue)
-        throw std::runtime_error("Null parameter");
-    const TSharedPtr<FJsonObject>& JsonParameter = JsonValue->AsObject();
-    if (!JsonParameter)
-        throw std::runtime_error("Non-object parameter");
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamRefreshSchema);
 
-    FString key = key_ + (undecoratedSuffix.IsEmpty() ? "" : "_" + undecoratedSuffix);
+    const FFileStatData Stat = IFileManager::Get().GetStatData(*SchemaPath);
+    if (Stat.bIsValid && Stat.FileSize == m_schemaSource.size && Stat.ModificationTime == m_schemaSource.modified)
+        return false;
 
-    if (key != JsonParameter->GetStringField(TEXT("key")))
-        throw std::runtime_error("Parameter mismatch");
+    TArray<uint8> Bytes;
+    if (!Stat.bIsValid || !FFileHelper::LoadFileToArray(Bytes, *SchemaPath))
+    {
+        const bool changed = m_schemaSource.size != -1 || !m_schemaSent;
+        if (changed)
+            UE_LOG(LogRenderStream, Error, TEXT("Failed to parse schema %s"), *SchemaPath);
+        m_schemaSource = SchemaSource();
+        return changed;
+    }
 
-    const std::string stdKey = TCHAR_TO_ANSI(*key);
-    fnv.addData(reinterpret_cast<const unsigned char*>(stdKey.data()), stdKey.size());
+    // Saving the file again without changes, as the editor does on every blueprint compile, only moves the timestamp.
+    const uint64_t hash = fnvHash(Bytes.GetData(), size_t(Bytes.Num()));
+    m_schemaSource.size = Stat.FileSize;
+    m_schemaSource.modified = Stat.ModificationTime;
+    if (m_schemaSource.parsed && hash == m_schemaSource.hash)
+        return false;
+
+    m_schemaSource.hash = hash;
+    m_schemaSource.parsed = false;
+    std::string& text = m_schemaSource.text;
+    if (Bytes.Num() >= 2 && ((Bytes[0] == 0xff && Bytes[1] == 0xfe) || (Bytes[0] == 0xfe && Bytes[1] == 0xff)))
+    {
+        // Saved as UTF-16 by an older editor module.
+        FString Text;
+        FFileHelper::BufferToString(Text, Bytes.GetData(), Bytes.Num());
+        text = TCHAR_TO_UTF8(*Text);
+    }
+    else
+    {
+        const int32 bom = Bytes.Num() >= 3 && Bytes[0] == 0xef && Bytes[1] == 0xbb && Bytes[2] == 0xbf ? 3 : 0;
+        text.assign(reinterpret_cast<const char*>(Bytes.GetData()) + bom, size_t(Bytes.Num() - bom));
+    }
+
+    const FString CompiledPath = FPaths::ChangeExtension(SchemaPath, TEXT("bin"));
+    TArray<uint8> CompiledBytes;
+    CompiledSchema& compiled = m_schemaSource.compiled;
+    if (FFileHelper::LoadFileToArray(CompiledBytes, *CompiledPath, FILEREAD_Silent) &&
+        compiled.deserialise(CompiledBytes.GetData(), size_t(CompiledBytes.Num())) &&
+        compiled.sourceSize == uint64_t(Bytes.Num()) && compiled.sourceHash == hash)
+    {
+        UE_LOG(LogRenderStream, Log, TEXT("Loaded compiled schema %s"), *CompiledPath);
+    }
+    else
+    {
+        std::string error;
+        if (!compiled.parse(text.data(), text.size(), error))
+        {
+            UE_LOG(LogRenderStream, Error, TEXT("Failed to parse schema %s: %s"), *SchemaPath, UTF8_TO_TCHAR(error.c_str()));
+            return true;
+        }
+        compiled.sourceSize = uint64_t(Bytes.Num());
+        compiled.sourceHash = hash;
+
+        const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+        if (settings ? settings->bWriteCompiledSchema : URenderStreamSettings::bWriteCompiledSchemaDefault)
+        {
+            const std::vector<uint8_t> serialised = compiled.serialise();
+            if (FFileHelper::SaveArrayToFile(TArrayView<const uint8>(serialised.data(), int32(serialised.size())), *CompiledPath))
+                UE_LOG(LogRenderStream, Log, TEXT("Wrote compiled schema %s"), *CompiledPath);
+            else
+                UE_LOG(LogRenderStream, Warning, TEXT("Unable to write compiled schema %s"), *CompiledPath);
+        }
+    }
+
+    m_schemaSource.parsed = true;
+    return true;
 }
 
-void FRenderStreamModule::ValidateSchema(const TSharedPtr<FJsonObject>& JsonSchema, const AActor* Root, const AActor* PersistentRoot, SchemaSpec& spec)
+void FRenderStreamModule::UpdateLevelLookup(const UWorld& World)
 {
-    StreamFNV fnv;
-
-    const FString Scene = JsonSchema->GetStringField(TEXT("name"));
-    TArray< TSharedPtr<FJsonValue> > JsonParameters = JsonSchema->GetArrayField(TEXT("parameters"));
+    const TArray<ULevelStreaming*>& streamingLevels = World.GetStreamingLevels();
+    if (m_levelLookupWorld.Get() == &World && m_levelLookupLevels == streamingLevels)
+        return;
 
-    const FString nPersistentParametersFieldName = TEXT("nPersistentParameters");
-    const FString nLevelParametersFieldName = TEXT("nLevelParameters");
-    if (!JsonSchema->HasField(nPersistentParametersFieldName) ||
-        !JsonSchema->HasField(nLevelParametersFieldName))
+    m_levelLookup.clear();
+    for (ULevelStreaming* streamingLevel : streamingLevels)
     {
-        throw std::runtime_error("Missing supplementary fields in schema.json. Rebuild schema by opening project in Editor.");
+        FString Scene = FPackageName::GetLongPackageAssetName(streamingLevel->GetWorldAssetPackageName());
+        if (streamingLevel->GetWorld())
+            Scene.RemoveFromStart(streamingLevel->GetWorld()->StreamingLevelsPrefix);
+        m_levelLookup[Scene] = streamingLevel;
     }
+    m_levelLookupWorld = &World;
+    m_levelLookupLevels = streamingLevels;
+}
 
-    const int nPersistentParameters = int(JsonSchema->GetNumberField(nPersistentParametersFieldName));
-    const int nLevelParameters = int(JsonSchema->GetNumberField(nLevelParametersFieldName));
+bool FRenderStreamModule::IsValidatedFor(const SchemaSpec& spec, const ULevelStreaming* streamingLevel, const AActor* Root, const AActor* PersistentRoot)
+{
+    return PersistentRoot &&
+        spec.streamingLevel == streamingLevel &&
+        spec.schemaRoot == Root && spec.validatedRoot.Get() == Root &&
+        spec.schemaPersistentRoot == PersistentRoot && spec.validatedPersistentRoot.Get() == PersistentRoot;
+}
 
+FRenderStreamModule::SchemaSpec* FRenderStreamModule::ValidatedSpec(const UWorld& World, uint32_t scene, const AActor* Root, const AActor* PersistentRoot)
+{
+    if (scene >= m_specs.size())
+        return nullptr;
+    if (IsValidatedFor(m_specs[scene], m_specs[scene].streamingLevel, Root, PersistentRoot))
+        return &m_specs[scene];
+
+    // The bindings hold offsets into the actors they were resolved against. A root unloaded and loaded again, or
+    // reinstanced, may come back at the same address with a different layout, so it is validated again before any
+    // write. A schema that does not match the roots would otherwise be reloaded every frame.
+    if (m_revalidatedScene == scene && m_revalidatedRoot.Get() == Root && m_revalidatedPersistentRoot.Get() == PersistentRoot)
+        return nullptr;
+    m_revalidatedScene = scene;
+    m_revalidatedRoot = Root;
+    m_revalidatedPersistentRoot = PersistentRoot;
+
+    UE_LOG(LogRenderStream, Log, TEXT("Schema of scene %u no longer matches its level, loading it again"), scene);
+    LoadSchemas(World);
+    if (scene >= m_specs.size() || !IsValidatedFor(m_specs[scene], m_specs[scene].streamingLevel, Root, PersistentRoot))
+        return nullptr;
+    return &m_specs[scene];
+}
+
+namespace {
+    // Throws unless the scene's keys from first on are those expected.
+    void validateKeys(const std::vector<std::string>& expected, const CompiledSchema::Scene& schema, size_t first)
+    {
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            if (first + i >= schema.keyCount())
+                throw std::runtime_error("Property not exposed in schema");
+            if (!schema.keyEquals(first + i, expected[i]))
+                throw std::runtime_error("Parameter mismatch");
+        }
+    }
+}
+
+void FRenderStreamModule::ValidateSchema(const FString& Scene, const CompiledSchema::Scene& schema, const AActor* Root, const AActor* PersistentRoot, const RootBindings& persistent, SchemaSpec& spec)
+{
     UE_LOG(LogRenderStream, Log, TEXT("Validating schema for %s"), *Scene);
 
-    if (ValidateRoot(PersistentRoot, JsonParameters, spec, fnv) != nPersistentParameters)
+    validateKeys(persistent.keys, schema, 0);
+    if (persistent.keys.size() != schema.nPersistentParameters)
         throw std::runtime_error("Excess persistent parameters in schema");
+    spec.persistentBindings = persistent.bindings;
+    spec.nParameters = persistent.keys.size();
 
+    spec.levelBindings.clear();
     if (Root)
     {
-        JsonParameters.RemoveAt(0, nPersistentParameters);
-
-        if (ValidateRoot(Root, JsonParameters, spec, fnv) != nLevelParameters)
+        RootBindings level;
+        BindRoot(Root, level);
+        validateKeys(level.keys, schema, schema.nPersistentParameters);
+        if (level.keys.size() != schema.nLevelParameters)
             throw std::runtime_error("Excess level parameters in schema");
+        spec.levelBindings = std::move(level.bindings);
+        spec.nParameters += level.keys.size();
     }
 
     spec.schemaRoot = Root;
     spec.schemaPersistentRoot = PersistentRoot;
+    spec.validatedRoot = Root;
+    spec.validatedPersistentRoot = PersistentRoot;
     UE_LOG(LogRenderStream, Log, TEXT("Validated schema"));
 
-    spec.schemaHash = fnv.getHash();
+    // The keys in use are those validated, which the parse has already hashed.
+    spec.schemaHash = schema.keysHash(spec.nParameters);
+    spec.interpolator.setContinuous(ContinuousParameters(spec));
 }
 
-size_t FRenderStreamModule::ValidateRoot(const AActor* Root, const TArray< TSharedPtr<FJsonValue> >& JsonParameters, SchemaSpec& spec, StreamFNV& fnv) const
+void FRenderStreamModule::BindRoot(const AActor* Root, RootBindings& out)
 {
-    size_t nParameters = 0; 
+    out.bindings.clear();
+    out.keys.clear();
+
+    auto bind = [Root, &out](const FProperty* Property, ParameterBinding::Kind kind, std::initializer_list<const char*> suffixes)
+    {
+        ParameterBinding binding;
+        binding.kind = kind;
+        binding.components = uint8(suffixes.size());
+        binding.offset = int32(static_cast<const uint8*>(Property->ContainerPtrToValuePtr<void>(Root)) - reinterpret_cast<const uint8*>(Root));
+        binding.boolProperty = CastField<const FBoolProperty>(Property);
+        binding.name = Property->GetFName();
+        out.bindings.push_back(binding);
+
+        // Keys as the editor generates them, the property name with the component as an undecorated suffix.
+        const std::string name = TCHAR_TO_UTF8(*Property->GetName());
+        for (const char* suffix : suffixes)
+            out.keys.push_back(*suffix ? name + "_" + suffix : name);
+    };
 
     for (TFieldIterator<FProperty> PropIt(Root->GetClass(), EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
     {
@@ -214,69 +524,39 @@ size_t FRenderStreamModule::ValidateRoot(const AActor* Root, const TArray< TShar
         else if (const FBoolProperty* BoolProperty = CastField<const FBoolProperty>(Property))
         {
             UE_LOG(LogRenderStream, Log, TEXT("Exposed bool property: %s"), *Name);
-            if (JsonParameters.Num() < nParameters + 1)
-                throw std::runtime_error("Property not exposed in schema");
-            validateField(fnv, Name, "", JsonParameters[nParameters]);
-            ++nParameters;
+            bind(Property, ParameterBinding::Kind::Bool, { "" });
         }
         else if (const FByteProperty* ByteProperty = CastField<const FByteProperty>(Property))
         {
             UE_LOG(LogRenderStream, Log, TEXT("Exposed int property: %s"), *Name);
-            if (JsonParameters.Num() < nParameters + 1)
-                throw std::runtime_error("Property not exposed in schema");
-            validateField(fnv, Name, "", JsonParameters[nParameters]);
-            ++nParameters;
+            bind(Property, ParameterBinding::Kind::Byte, { "" });
         }
         else if (const FIntProperty* IntProperty = CastField<const FIntProperty>(Property))
         {
             UE_LOG(LogRenderStream, Log, TEXT("Exposed int property: %s"), *Name);
-            if (JsonParameters.Num() < nParameters + 1)
-                throw std::runtime_error("Property not exposed in schema");
-            validateField(fnv, Name, "", JsonParameters[nParameters]);
-            ++nParameters;
+            bind(Property, ParameterBinding::Kind::Int, { "" });
         }
         else if (const FFloatProperty* FloatProperty = CastField<const FFloatProperty>(Property))
         {
             UE_LOG(LogRenderStream, Log, TEXT("Exposed float property: %s"), *Name);
-            if (JsonParameters.Num() < nParameters + 1)
-                throw std::runtime_error("Property not exposed in schema");
-            validateField(fnv, Name, "", JsonParameters[nParameters]);
-            ++nParameters;
+            bind(Property, ParameterBinding::Kind::Float, { "" });
         }
         else if (const FStructProperty* StructProperty = CastField<const FStructProperty>(Property))
         {
-            const void* StructAddress = StructProperty->ContainerPtrToValuePtr<void>(Root);
             if (StructProperty->Struct == TBaseStructure<FVector>::Get())
             {
                 UE_LOG(LogRenderStream, Log, TEXT("Exposed vector property: %s"), *Name);
-                if (JsonParameters.Num() < nParameters + 3)
-                    throw std::runtime_error("Properties not exposed in schema");
-                validateField(fnv, Name, "x", JsonParameters[nParameters + 0]);
-                validateField(fnv, Name, "y", JsonParameters[nParameters + 1]);
-                validateField(fnv, Name, "z", JsonParameters[nParameters + 2]);
-                nParameters += 3;
+                bind(Property, ParameterBinding::Kind::Vector, { "x", "y", "z" });
             }
             else if (StructProperty->Struct == TBaseStructure<FColor>::Get())
             {
                 UE_LOG(LogRenderStream, Log, TEXT("Exposed colour property: %s"), *Name);
-                if (JsonParameters.Num() < nParameters + 4)
-                    throw std::runtime_error("Properties not exposed in schema");
-                validateField(fnv, Name, "r", JsonParameters[nParameters + 0]);
-                validateField(fnv, Name, "g", JsonParameters[nParameters + 1]);
-                validateField(fnv, Name, "b", JsonParameters[nParameters + 2]);
-                validateField(fnv, Name, "a", JsonParameters[nParameters + 3]);
-                nParameters += 4;
+                bind(Property, ParameterBinding::Kind::Color, { "r", "g", "b", "a" });
             }
             else if (StructProperty->Struct == TBaseStructure<FLinearColor>::Get())
             {
                 UE_LOG(LogRenderStream, Log, TEXT("Exposed linear colour property: %s"), *Name);
-                if (JsonParameters.Num() < nParameters + 4)
-                    throw std::runtime_error("Properties not exposed in schema");
-                validateField(fnv, Name, "r", JsonParameters[nParameters + 0]);
-                validateField(fnv, Name, "g", JsonParameters[nParameters + 1]);
-                validateField(fnv, Name, "b", JsonParameters[nParameters + 2]);
-                validateField(fnv, Name, "a", JsonParameters[nParameters + 3]);
-                nParameters += 4;
+                bind(Property, ParameterBinding::Kind::LinearColor, { "r", "g", "b", "a" });
             }
             else
             {
@@ -288,135 +568,174 @@ size_t FRenderStreamModule::ValidateRoot(const AActor* Root, const TArray< TShar
             UE_LOG(LogRenderStream, Log, TEXT("Unsupported exposed property: %s"), *Name);
         }
     }
+}
+
+void FRenderStreamModule::ApplyParameters(SchemaSpec& spec, AActor* persistentRoot, AActor* levelRoot, const std::vector<float>& parameters)
+{
+    // d3 sends every parameter every frame, mostly unchanged. Only the first frame of a schema is written in full.
+    const size_t n = spec.nParameters;
+    const uint64_t* changed = nullptr;
+    if (spec.appliedParameters.size() == n)
+    {
+        if (ParameterDiff::compare(spec.appliedParameters.data(), parameters.data(), n, m_changedMask) == 0)
+            return;
+        changed = m_changedMask.data();
+    }
+
+    URenderStreamEvents* Events = GEngine ? GEngine->GetEngineSubsystem<URenderStreamEvents>() : nullptr;
+    TArray<FName>* changedNames = Events && Events->HasParameterListeners() ? &m_changedParameters : nullptr;
+    m_changedParameters.Reset();
+
+    const size_t offset = ApplyBindings(persistentRoot, spec.persistentBindings, parameters.data(), changed, 0, changedNames);
+    if (levelRoot)
+        ApplyBindings(levelRoot, spec.levelBindings, parameters.data() + offset, changed, offset, changedNames);
+    spec.appliedParameters.assign(parameters.begin(), parameters.begin() + n);
+    spec.appliedHash = fnvHash(reinterpret_cast<const uint8_t*>(spec.appliedParameters.data()), n * sizeof(float));
 
-    spec.nParameters += nParameters;
-    return nParameters;
+    if (changedNames)
+        Events->BroadcastParametersChanged(m_changedParameters);
 }
 
-size_t FRenderStreamModule::ApplyParameters(AActor* Root, const std::vector<float>& parameters, const size_t offset)
+const std::vector<float>& FRenderStreamModule::SampleParameters(SchemaSpec& spec, const std::vector<float>& parameters)
 {
-    if (!Root)
-        return offset;
+    const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+    const ERenderStreamParameterInterpolation setting = settings ? settings->ParameterInterpolation : URenderStreamSettings::ParameterInterpolationDefault;
+    const ParameterInterpolator::Mode mode = setting == ERenderStreamParameterInterpolation::CUBIC ? ParameterInterpolator::Mode::Cubic :
+        setting == ERenderStreamParameterInterpolation::LINEAR ? ParameterInterpolator::Mode::Linear : ParameterInterpolator::Mode::Step;
+    if (spec.interpolator.mode() != mode)
+        spec.interpolator.configure(mode);
+    if (mode == ParameterInterpolator::Mode::Step || spec.interpolator.size() != spec.nParameters)
+        return parameters;
+
+    spec.interpolator.push(m_frameData.localTime, m_frameData.localTimeDelta, parameters.data());
+    return spec.interpolator.evaluate(0.);
+}
 
-    size_t i = offset;
-    for (TFieldIterator<FProperty> PropIt(Root->GetClass(), EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
+std::vector<uint8_t> FRenderStreamModule::ContinuousParameters(const SchemaSpec& spec)
+{
+    std::vector<uint8_t> continuous;
+    continuous.reserve(spec.nParameters);
+    for (const std::vector<ParameterBinding>* bindings : { &spec.persistentBindings, &spec.levelBindings })
     {
-        FProperty* Property = *PropIt;
-        if (!Property->HasAllPropertyFlags(CPF_Edit | CPF_BlueprintVisible) || Property->HasAllPropertyFlags(CPF_DisableEditOnInstance))
-        {
-            continue;
-        }
-        else if (const FBoolProperty* BoolProperty = CastField<const FBoolProperty>(Property))
-        {
-            const bool v = bool(parameters.at(i));
-            BoolProperty->SetPropertyValue_InContainer(Root, v);
-            ++i;
-        }
-        else if (FByteProperty* ByteProperty = CastField<FByteProperty>(Property))
-        {
-            const uint8 v = uint8(parameters.at(i));
-            ByteProperty->SetPropertyValue_InContainer(Root, v);
-            ++i;
-        }
-        else if (FIntProperty* IntProperty = CastField<FIntProperty>(Property))
+        for (const ParameterBinding& binding : *bindings)
         {
-            const int32 v = int(parameters.at(i));
-            IntProperty->SetPropertyValue_InContainer(Root, v);
-            ++i;
+            const bool interpolated = binding.kind == ParameterBinding::Kind::Float || binding.kind == ParameterBinding::Kind::Vector ||
+                binding.kind == ParameterBinding::Kind::Color || binding.kind == ParameterBinding::Kind::LinearColor;
+            continuous.insert(continuous.end(), binding.components, uint8_t(interpolated));
         }
-        else if (FFloatProperty* FloatProperty = CastField<FFloatProperty>(Property))
+    }
+    continuous.resize(spec.nParameters, 0);
+    return continuous;
+}
+
+size_t FRenderStreamModule::ApplyBindings(AActor* Root, const std::vector<ParameterBinding>& bindings, const float* parameters, const uint64_t* changed, size_t first, TArray<FName>* changedNames)
+{
+    uint8* base = reinterpret_cast<uint8*>(Root);
+    const float* p = parameters;
+    for (const ParameterBinding& binding : bindings)
+    {
+        if (changed && !ParameterDiff::any(changed, first + size_t(p - parameters), binding.components))
         {
-            const float v = parameters.at(i);
-            FloatProperty->SetPropertyValue_InContainer(Root, v);
-            ++i;
+            p += binding.components;
+            continue;
         }
-        else if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+        if (changedNames)
+            changedNames->Add(binding.name);
+
+        void* address = base + binding.offset;
+        switch (binding.kind)
         {
-            void* StructAddress = StructProperty->ContainerPtrToValuePtr<void>(Root);
-            if (StructProperty->Struct == TBaseStructure<FVector>::Get())
-            {
-                FVector v(parameters.at(i), parameters.at(i + 1), parameters.at(i + 2));
-                StructProperty->CopyCompleteValue(StructAddress, &v);
-                i += 3;
-            }
-            else if (StructProperty->Struct == TBaseStructure<FColor>::Get())
-            {
-                FColor v(parameters.at(i) * 255, parameters.at(i + 1) * 255, parameters.at(i + 2) * 255, parameters.at(i + 3) * 255);
-                StructProperty->CopyCompleteValue(StructAddress, &v);
-                i += 4;
-            }
-            else if (StructProperty->Struct == TBaseStructure<FLinearColor>::Get())
-            {
-                FLinearColor v(parameters.at(i), parameters.at(i + 1), parameters.at(i + 2), parameters.at(i + 3));
-                StructProperty->CopyCompleteValue(StructAddress, &v);
-                i += 4;
-            }
+        case ParameterBinding::Kind::Bool:
+            binding.boolProperty->SetPropertyValue(address, bool(p[0]));
+            break;
+        case ParameterBinding::Kind::Byte:
+            *static_cast<uint8*>(address) = uint8(p[0]);
+            break;
+        case ParameterBinding::Kind::Int:
+            *static_cast<int32*>(address) = int32(p[0]);
+            break;
+        case ParameterBinding::Kind::Float:
+            *static_cast<float*>(address) = p[0];
+            break;
+        case ParameterBinding::Kind::Vector:
+            *static_cast<FVector*>(address) = FVector(p[0], p[1], p[2]);
+            break;
+        case ParameterBinding::Kind::Color:
+            *static_cast<FColor*>(address) = FColor(uint8(p[0] * 255), uint8(p[1] * 255), uint8(p[2] * 255), uint8(p[3] * 255));
+            break;
+        case ParameterBinding::Kind::LinearColor:
+            *static_cast<FLinearColor*>(address) = FLinearColor(p[0], p[1], p[2], p[3]);
+            break;
         }
+        p += binding.components;
     }
-    return i;
+    return size_t(p - parameters);
 }
 
 void FRenderStreamModule::LoadSchemas(const UWorld& World)
 {
-    m_specs.clear();
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamLoadSchemas);
 
-    FString Schema;
-    FString SchemaPath = FPaths::Combine(*FPaths::ProjectContentDir(), *FString("DisguiseRenderStream"), *FString("schema.json"));
-    FFileHelper::LoadFileToString(Schema, *SchemaPath);
+    const FString SchemaPath = FPaths::Combine(*FPaths::ProjectContentDir(), *FString("DisguiseRenderStream"), *FString("schema.json"));
 
-    TArray< TSharedPtr<FJsonValue> > JsonSchemas;
+    // Specs still validated against the current roots of their scenes are kept as they are, which is what makes the
+    // reload after each streaming level load cheap.
+    std::vector<SchemaSpec> previous;
+    previous.swap(m_specs);
 
-    TSharedRef< TJsonReader<> > Reader = TJsonReaderFactory<>::Create(Schema);
-    if (FJsonSerializer::Deserialize(Reader, JsonSchemas))
-    {
+    bool valid = false;
 #if WITH_EDITOR
-        try
-        {
+    try
+    {
 #endif
-            const TArray<ULevelStreaming*>& streamingLevels = World.GetStreamingLevels();
+        if (RefreshSchemaSource(SchemaPath))
+            previous.clear();
+        valid = m_schemaSource.parsed;
 
-            std::map<FString, ULevelStreaming*> LevelLookup;
-            for (ULevelStreaming* streamingLevel : streamingLevels)
-            {
-                FString Scene = FPackageName::GetLongPackageAssetName(streamingLevel->GetWorldAssetPackageName());
-                if (streamingLevel->GetWorld())
-                    Scene.RemoveFromStart(streamingLevel->GetWorld()->StreamingLevelsPrefix);
-                LevelLookup[Scene] = streamingLevel;
-            }
+        if (valid)
+        {
+            UpdateLevelLookup(World);
+
+            const AActor* persistentRoot = World.PersistentLevel->GetLevelScriptActor();
+            RootBindings persistent;
+            bool persistentBound = false;
 
-            m_specs.resize(JsonSchemas.Num());
+            const std::vector<CompiledSchema::Scene>& scenes = m_schemaSource.compiled.scenes;
+            m_specs.resize(scenes.size());
             for (size_t i = 0; i < m_specs.size(); ++i)
             {
-                if (!JsonSchemas[i]) 
-                    throw std::runtime_error("Null schema");
-                const TSharedPtr<FJsonObject>& JsonSchema = JsonSchemas[i]->AsObject();
-                if (!JsonSchema)
-                    throw std::runtime_error("Non-object schema");
-                const FString Scene = JsonSchema->GetStringField(TEXT("name"));
-                ULevelStreaming* streamingLevel = LevelLookup[Scene];
+                const FString Scene = UTF8_TO_TCHAR(scenes[i].name.c_str());
+                const auto level = m_levelLookup.find(Scene);
+                ULevelStreaming* streamingLevel = level != m_levelLookup.end() ? level->second : nullptr;
+                const AActor* levelRoot = streamingLevel ? streamingLevel->GetLevelScriptActor() : nullptr;
+
                 SchemaSpec& spec = m_specs[i];
-                spec.streamingLevel = streamingLevel;
+                if (i < previous.size() && IsValidatedFor(previous[i], streamingLevel, levelRoot, persistentRoot))
+                {
+                    spec = std::move(previous[i]);
+                    continue;
+                }
 
-                const AActor* persistentRoot = World.PersistentLevel->GetLevelScriptActor();
-                const AActor* levelRoot = streamingLevel ? streamingLevel->GetLevelScriptActor() : nullptr;
-                ValidateSchema(JsonSchema, levelRoot, persistentRoot, spec);
+                // Every scene starts with the parameters of the persistent level.
+                if (!persistentBound)
+                {
+                    BindRoot(persistentRoot, persistent);
+                    persistentBound = true;
+                }
+                spec.streamingLevel = streamingLevel;
+                ValidateSchema(Scene, scenes[i], levelRoot, persistentRoot, persistent, spec);
 
                 UE_LOG(LogRenderStream, Log, TEXT("Loaded schema for %s (%s): %d parameters"), *Scene, streamingLevel ? *streamingLevel->GetWorldAssetPackageName() : TEXT("null"), spec.nParameters);
             }
-#if WITH_EDITOR
         }
-        catch (const std::exception& e)
-        {
-            UE_LOG(LogRenderStream, Error, TEXT("Failed to parse schema %s: %s"), *SchemaPath, *FString(e.what()));
-            Schema = TEXT("[]");
-        }
-#endif
+#if WITH_EDITOR
     }
-    else
+    catch (const std::exception& e)
     {
-        UE_LOG(LogRenderStream, Error, TEXT("Failed to parse schema %s"), *SchemaPath);
-        Schema = TEXT("[]");
+        UE_LOG(LogRenderStream, Error, TEXT("Failed to parse schema %s: %s"), *SchemaPath, *FString(e.what()));
+        valid = false;
     }
+#endif
 
     if (m_specs.empty())
     {
@@ -427,25 +746,295 @@ void FRenderStreamModule::LoadSchemas(const UWorld& World)
         spec.schemaHash = fnv.getHash();
     }
 
-    if (RenderStreamLink::instance().rs_setSchema(m_assetHandle, TCHAR_TO_ANSI(*Schema)) != 0)
+    std::vector<uint64_t> costs(m_specs.size());
+    for (size_t i = 0; i < m_specs.size(); ++i)
+        costs[i] = m_specs[i].streamingLevel ? LevelCost(*m_specs[i].streamingLevel) : 0;
+    m_residency.setScenes(costs);
+
+    std::vector<size_t> levelOfScene(m_specs.size(), SceneSwitch::NoLevel);
+    for (size_t i = 0; i < m_specs.size(); ++i)
+    {
+        const int32 index = m_specs[i].streamingLevel ? m_levelLookupLevels.IndexOfByKey(m_specs[i].streamingLevel) : INDEX_NONE;
+        if (index != INDEX_NONE)
+            levelOfScene[i] = size_t(index);
+    }
+    m_sceneSwitch.setScenes(levelOfScene, size_t(m_levelLookupLevels.Num()));
+
+    if (m_receiver)
+    {
+        std::vector<FrameReceiver::Schema> schemas(m_specs.size());
+        for (size_t i = 0; i < m_specs.size(); ++i)
+        {
+            schemas[i].hash = m_specs[i].schemaHash;
+            schemas[i].nParameters = m_specs[i].nParameters;
+        }
+        m_receiver->setSchemas(schemas);
+    }
+
+    // d3 only needs the schema again when it changed.
+    const uint64_t sentHash = valid ? m_schemaSource.hash : 0;
+    if (m_schemaSent && sentHash == m_sentSchemaHash)
+        return;
+    const char* schema = valid ? m_schemaSource.text.c_str() : "[]";
+    if (RenderStreamLink::instance().rs_setSchema(m_assetHandle, schema) != 0)
     {
         UE_LOG(LogRenderStream, Error, TEXT("Unable to set remote parameter schema"));
+        return;
+    }
+    m_schemaSent = true;
+    m_sentSchemaHash = sentHash;
+}
+
+uint64_t FRenderStreamModule::LevelCost(const ULevelStreaming& streamingLevel)
+{
+    const FName PackageName = streamingLevel.GetWorldAssetPackageFName();
+    if (const uint64* cost = m_levelCosts.Find(PackageName))
+        return *cost;
+
+    // Levels in PIE are duplicates of the package on disk.
+    FString Filename;
+    int64 size = 0;
+    if (FPackageName::DoesPackageExist(UWorld::RemovePIEPrefix(PackageName.ToString()), nullptr, &Filename))
+        size = FMath::Max<int64>(IFileManager::Get().FileSize(*Filename), 0);
+    m_levelCosts.Add(PackageName, uint64(size));
+    return uint64(size);
+}
+
+void FRenderStreamModule::HintScene(const FString& Scene)
+{
+    const std::string name = TCHAR_TO_UTF8(*Scene);
+    const std::vector<CompiledSchema::Scene>& scenes = m_schemaSource.compiled.scenes;
+    for (size_t i = 0; m_schemaSource.parsed && i < scenes.size(); ++i)
+    {
+        if (scenes[i].name == name)
+        {
+            m_residency.hint(i);
+            return;
+        }
+    }
+    UE_LOG(LogRenderStream, Warning, TEXT("Unable to prefetch %s, no such scene in the schema"), *Scene);
+}
+
+void FRenderStreamModule::UpdateResidency(const UWorld& World, uint32_t scene)
+{
+    const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+    const int32 budgetMB = settings ? settings->SceneResidencyBudgetMB : URenderStreamSettings::SceneResidencyBudgetMBDefault;
+    if (budgetMB <= 0)
+        return;
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamUpdateResidency);
+
+    // Only levels of this world are touched, the specs may still refer to those of one that has gone.
+    const TArray<ULevelStreaming*>& streamingLevels = World.GetStreamingLevels();
+    m_residency.setBudget(uint64_t(budgetMB) << 20);
+    m_residency.show(scene);
+    if (m_residency.update())
+    {
+        for (size_t i = 0; i < m_specs.size(); ++i)
+        {
+            ULevelStreaming* streamingLevel = m_specs[i].streamingLevel;
+            if (!streamingLevel || !streamingLevels.Contains(streamingLevel))
+                continue;
+            // Resident levels other than the one shown stay hidden until d3 switches to them.
+            const bool resident = m_residency.resident(i);
+            streamingLevel->SetShouldBeLoaded(resident);
+            if (!resident)
+                streamingLevel->SetShouldBeVisible(false);
+        }
+        UE_LOG(LogRenderStream, Log, TEXT("Scene residency %.1f of %.1f MB"), double(m_residency.residentCost()) / (1 << 20), double(m_residency.budget()) / (1 << 20));
+    }
+
+    // Levels loaded in the background have no validated schema yet, which LoadSchemas catches up on. One level evicted
+    // and another loaded between two frames leaves as many loaded, so the level script actors themselves are compared.
+    // A weak pointer also tells a level loaded again at the same address from the one seen before.
+    bool changed = m_residentRoots.size() != m_specs.size();
+    m_residentRoots.resize(m_specs.size());
+    for (size_t i = 0; i < m_specs.size(); ++i)
+    {
+        const ULevelStreaming* streamingLevel = m_specs[i].streamingLevel;
+        const AActor* root = streamingLevel && streamingLevels.Contains(streamingLevel) && streamingLevel->IsLevelLoaded() ?
+            streamingLevel->GetLevelScriptActor() : nullptr;
+        if (m_residentRoots[i].Get() != root || (!root && !m_residentRoots[i].IsExplicitlyNull()))
+        {
+            m_residentRoots[i] = root;
+            changed = true;
+        }
     }
+    if (changed)
+        LoadSchemas(World);
 }
 
 void FRenderStreamModule::OnBeginFrame()
 {
-    if (!RenderStreamLink::instance().isAvailable())
+    // Nothing comes from d3 without a receiver, captures only render at their idle rate.
+    if (!m_receiver)
+    {
+        DecideRenders();
+        UpdateResolution();
+        return;
+    }
+    // A custom time step waits for frames itself, as the engine updates its time.
+    if (m_timeStepActive)
+        return;
+
+    // Without captures nothing waits for d3, the newest frame only keeps the asset in sync.
+    const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+    const bool frameLock = m_activeCaptures.Num() > 0 && (settings ? settings->bFrameLock : URenderStreamSettings::bFrameLockDefault);
+    bool received;
+    if (frameLock)
+    {
+        const int32 timeoutMs = settings ? settings->FrameLockTimeoutMs : URenderStreamSettings::FrameLockTimeoutMsDefault;
+        received = m_receiver->consumeBy(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs));
+    }
+    else
+    {
+        received = m_receiver->consume();
+    }
+
+    // Nothing new from d3, what the last frame applied stays in place but for interpolated parameters.
+    if (received)
+        ApplyFrame();
+    else
+        InterpolateFrame();
+    DecideRenders();
+    UpdateResolution();
+}
+
+bool FRenderStreamModule::AwaitFrame(std::chrono::steady_clock::time_point Deadline)
+{
+    if (!m_receiver)
+        return false;
+    const bool received = m_receiver->consumeBy(Deadline);
+    if (received)
+        ApplyFrame();
+    else
+        InterpolateFrame();
+    DecideRenders();
+    UpdateResolution();
+    return received;
+}
+
+void FRenderStreamModule::DecideRenders()
+{
+    // What the captures' views depend on besides their cameras: the scene, its parameters as applied and how far a
+    // switch to it has got.
+    uint64_t inputs[3] = { m_frameData.scene, 0, uint64_t(m_sceneSwitch.state()) };
+    if (m_frameData.scene < m_specs.size())
+        inputs[1] = m_specs[m_frameData.scene].appliedHash;
+    const uint64_t fingerprint = fnvHash(reinterpret_cast<const uint8_t*>(inputs), sizeof(inputs));
+
+    for (const TWeakObjectPtr<URenderStreamMediaCapture>& ptr : m_activeCaptures)
+    {
+        if (URenderStreamMediaCapture* capture = ptr.Get())
+            capture->DecideRender(fingerprint, m_receiver && m_frameDataValid);
+    }
+}
+
+void FRenderStreamModule::UpdateResolution()
+{
+    IConsoleVariable* ScreenPercentage = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ScreenPercentage"));
+    if (!ScreenPercentage)
+        return;
+
+    const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
+    const bool enabled = settings ? settings->bDynamicResolution : URenderStreamSettings::bDynamicResolutionDefault;
+    if (!enabled || m_activeCaptures.Num() == 0)
+    {
+        if (m_screenPercentageBefore >= 0.f)
+        {
+            ScreenPercentage->Set(m_screenPercentageBefore, ECVF_SetByCode);
+            m_screenPercentageBefore = -1.f;
+            m_resolution.reset();
+        }
+        return;
+    }
+
+    ResolutionController::Settings resolution;
+    resolution.minScale = double(settings ? settings->DynamicResolutionMinPercent : URenderStreamSettings::DynamicResolutionMinPercentDefault) / 100.;
+    resolution.maxScale = double(settings ? settings->DynamicResolutionMaxPercent : URenderStreamSettings::DynamicResolutionMaxPercentDefault) / 100.;
+    resolution.budget = double(settings ? settings->DynamicResolutionBudgetPercent : URenderStreamSettings::DynamicResolutionBudgetPercentDefault) / 100.;
+    resolution.hysteresis = double(settings ? settings->DynamicResolutionHysteresisPercent : URenderStreamSettings::DynamicResolutionHysteresisPercentDefault) / 100.;
+    resolution.raiseFrames = settings ? settings->DynamicResolutionRaiseFrames : URenderStreamSettings::DynamicResolutionRaiseFramesDefault;
+    m_resolution.configure(resolution);
+    if (m_screenPercentageBefore < 0.f)
+    {
+        m_screenPercentageBefore = ScreenPercentage->GetFloat();
+        m_resolution.reset();
+        ScreenPercentage->Set(float(m_resolution.scale() * 100.), ECVF_SetByCode);
+    }
+
+    // Frames the engine did not draw, or without d3's frame period to measure them against, say nothing of the cost.
+    if (!m_receiver || !m_frameDataValid)
         return;
+    for (const TWeakObjectPtr<URenderStreamMediaCapture>& ptr : m_activeCaptures)
+    {
+        const URenderStreamMediaCapture* capture = ptr.Get();
+        if (capture && !capture->IsRendering())
+            return;
+    }
+
+    ResolutionController::Sample sample;
+    sample.period = m_frameData.frameRateNumerator > 0 && m_frameData.frameRateDenominator > 0 ?
+        double(m_frameData.frameRateDenominator) / double(m_frameData.frameRateNumerator) : m_frameData.localTimeDelta;
+    sample.gpu = FPlatformTime::ToSeconds(RHIGetGPUFrameCycles());
+    sample.renderThread = FPlatformTime::ToSeconds(GRenderThreadTime);
+    sample.send = double(m_latency.last(size_t(LatencyTracer::Stage::Sent))) * 1e-9;
+    if (m_resolution.update(sample))
+    {
+        ScreenPercentage->Set(float(m_resolution.scale() * 100.), ECVF_SetByCode);
+        UE_LOG(LogRenderStream, Verbose, TEXT("Dynamic resolution: screen percentage %.0f, frames at %.0f%% of the budget"), m_resolution.scale() * 100., m_resolution.load() * 100.);
+    }
+
+    if (m_resolution.sendBound() != m_sendBound)
+    {
+        m_sendBound = m_resolution.sendBound();
+        if (m_sendBound)
+            UE_LOG(LogRenderStream, Warning, TEXT("Sending frames takes longer than d3's frame period allows, which a lower resolution does not help."));
+    }
+}
+
+void FRenderStreamModule::InterpolateFrame()
+{
+    if (!m_frameDataValid)
+        return;
+
+    const double period = m_frameData.localTimeDelta > 0. ? m_frameData.localTimeDelta : m_frameData.frameRateNumerator > 0 ?
+        double(m_frameData.frameRateDenominator) / double(m_frameData.frameRateNumerator) : 0.;
+    m_subFrame = period > 0. ? FMath::Clamp(double(LatencyTracer::now() - m_frameAppliedAt) * 1e-9 / period, 0., 1.) : 0.;
+
+    if (m_activeCaptures.Num() == 0 || m_frameData.scene >= m_specs.size())
+        return;
+    if (!m_specs[m_frameData.scene].interpolator.moving())
+        return;
+
+    // Only into the actors the frame itself was applied to.
+    URenderStreamMediaCapture* SchemaCallbackTarget = m_activeCaptures[0].Get();
+    const UWorld* World = SchemaCallbackTarget ? SchemaCallbackTarget->SchemaWorld() : nullptr;
+    if (!World || m_levelLookupWorld.Get() != World)
+        return;
+    AActor* persistentRoot = World->PersistentLevel->GetLevelScriptActor();
+    AActor* levelRoot = nullptr;
+    if (ULevelStreaming* streamingLevel = m_specs[m_frameData.scene].streamingLevel)
+    {
+        levelRoot = streamingLevel->IsLevelLoaded() ? streamingLevel->GetLevelScriptActor() : nullptr;
+        if (!levelRoot)
+            return;
+    }
+    // Validated again, the spec starts over without anything to interpolate.
+    SchemaSpec* spec = ValidatedSpec(*World, m_frameData.scene, levelRoot, persistentRoot);
+    if (!spec || !spec->interpolator.moving())
+        return;
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamInterpolateFrame);
+    ApplyParameters(*spec, persistentRoot, levelRoot, spec->interpolator.evaluate(m_subFrame));
+}
 
-    // If no captures are active, maintain asset sync, but do not delay processing.
-    int timeout = 0;
-    if (m_activeCaptures.Num() > 0)
-        timeout = 500;
+void FRenderStreamModule::ApplyFrame()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamApplyFrame);
 
-    RenderStreamLink::AssetHandle updateAsset = 0;
-    uint32_t ret = RenderStreamLink::instance().rs_awaitFrameData(&updateAsset, timeout, &m_frameData);
-    if (ret != 0 || m_assetHandle != updateAsset || m_frameData.scene >= m_specs.size())
+    const FrameReceiver::Snapshot& snapshot = m_receiver->latest();
+    if (!snapshot.valid || snapshot.frameData.scene >= m_specs.size())
     {
         if (m_frameDataValid)
             m_status.setInputStatus("Stopped receiving data from d3", RSSTATUS_ORANGE);
@@ -453,93 +1042,127 @@ void FRenderStreamModule::OnBeginFrame()
         return;
     }
 
+    m_frameData = snapshot.frameData;
+    m_frameAppliedAt = LatencyTracer::now();
+    m_subFrame = 0.;
+    m_frameTrace = LatencyTracer::Trace();
+    m_frameTrace.frameId = snapshot.sequence;
+    m_frameTrace.stamps[size_t(LatencyTracer::Stage::Received)] = snapshot.receivedAt;
     if (!m_frameDataValid)
-        m_status.setInputStatus("Receiving data from d3", RSSTATUS_GREEN);
+        m_status.setInputStatus(RenderStreamLink::instance().isReplaying() ? "Replaying recorded session" : "Receiving data from d3", RSSTATUS_GREEN);
     m_frameDataValid = true;
 
     // If no captures are active, skip schema validation (and error logging).
     if (m_activeCaptures.Num() == 0)
         return;
 
-    const SchemaSpec& spec = m_specs.at(m_frameData.scene);
-
     URenderStreamMediaCapture* SchemaCallbackTarget = m_activeCaptures[0].Get();
     const UWorld* World = SchemaCallbackTarget ? SchemaCallbackTarget->SchemaWorld() : nullptr;
+
+    // May reload the schemas, so comes before holding on to one.
     if (World)
+        UpdateResidency(*World, m_frameData.scene);
+    if (m_frameData.scene >= m_specs.size())
+        return;
+
+    ULevelStreaming* streamingLevel = m_specs[m_frameData.scene].streamingLevel;
+    const std::vector<float>& parameters = snapshot.parameters;
+
+    // The switch works on the streaming levels of the world the schemas were last loaded for.
+    if (World && m_levelLookupWorld.Get() == World)
     {
         AActor* persistentRoot = World->PersistentLevel->GetLevelScriptActor();
-        if (spec.streamingLevel == nullptr && spec.schemaPersistentRoot == persistentRoot) // base level
+
+        // Levels only change visibility when d3 switches scene.
+        if (m_sceneSwitch.select(m_frameData.scene, LatencyTracer::now(), m_levelsToHide))
         {
-            std::vector<float> parameters;
-            parameters.resize(spec.nParameters);
-            if (RenderStreamLink::instance().rs_getFrameParameters(m_assetHandle, spec.schemaHash, parameters.data(), parameters.size() * sizeof(float)) == RenderStreamLink::RS_ERROR_SUCCESS)
-            {
-                ApplyParameters(persistentRoot, parameters, 0);
-            }
-            for (ULevelStreaming* streamingLevel : World->GetStreamingLevels())
+            for (size_t level : m_levelsToHide)
+                m_levelLookupLevels[int32(level)]->SetShouldBeVisible(false);
+        }
+
+        if (streamingLevel == nullptr) // base level
+        {
+            SchemaSpec* spec = ValidatedSpec(*World, m_frameData.scene, nullptr, persistentRoot);
+            if (spec && snapshot.parametersValid && parameters.size() >= spec->nParameters)
             {
-                streamingLevel->SetShouldBeVisible(false);
+                ApplyParameters(*spec, persistentRoot, nullptr, SampleParameters(*spec, parameters));
             }
         }
-        else
+        else if (!streamingLevel->IsLevelLoaded())
         {
-            for (ULevelStreaming* streamingLevel : World->GetStreamingLevels())
+            UE_LOG(LogRenderStream, Log, TEXT("Loading level %s"), *streamingLevel->GetWorldAssetPackageFName().ToString());
+            FLatentActionInfo LatentInfo;
+            LatentInfo.CallbackTarget = SchemaCallbackTarget;
+            LatentInfo.ExecutionFunction = "UpdateSchema";
+            LatentInfo.UUID = int32(uintptr_t(this));
+            LatentInfo.Linkage = 0;
+            UGameplayStatics::LoadStreamLevel(World, streamingLevel->GetWorldAssetPackageFName(), true, true, LatentInfo);
+        }
+        else if (SchemaSpec* spec = ValidatedSpec(*World, m_frameData.scene, streamingLevel->GetLevelScriptActor(), persistentRoot))
+        {
+            if (m_sceneSwitch.show())
+                streamingLevel->SetShouldBeVisible(true);
+            AActor* levelRoot = streamingLevel->GetLevelScriptActor();
+            if (!parameters.empty() && snapshot.parametersValid && parameters.size() >= spec->nParameters)
             {
-                if (spec.streamingLevel == streamingLevel)
-                {
-                    if (!streamingLevel->IsLevelLoaded())
-                    {
-                        UE_LOG(LogRenderStream, Log, TEXT("Loading level %s"), *streamingLevel->GetWorldAssetPackageFName().ToString());
-                        FLatentActionInfo LatentInfo;
-                        LatentInfo.CallbackTarget = SchemaCallbackTarget;
-                        LatentInfo.ExecutionFunction = "UpdateSchema";
-                        LatentInfo.UUID = int32(uintptr_t(this));
-                        LatentInfo.Linkage = 0;
-                        UGameplayStatics::LoadStreamLevel(World, streamingLevel->GetWorldAssetPackageFName(), true, true, LatentInfo);
-                    }
-                    else if (spec.schemaRoot == streamingLevel->GetLevelScriptActor())
-                    {
-                        AActor* levelRoot = streamingLevel->GetLevelScriptActor();
-                        streamingLevel->SetShouldBeVisible(true);
-                        std::vector<float> parameters;
-                        parameters.resize(spec.nParameters);
-                        if (!parameters.empty() && RenderStreamLink::instance().rs_getFrameParameters(m_assetHandle, spec.schemaHash, parameters.data(), parameters.size() * sizeof(float)) == RenderStreamLink::RS_ERROR_SUCCESS)
-                        {
-                            size_t offset = 0;
-                            offset = ApplyParameters(persistentRoot, parameters, offset);
-                            ApplyParameters(levelRoot, parameters, offset);
-                        }
-                    }
-                }
-                else if (spec.streamingLevel != nullptr)
-                {
-                    streamingLevel->SetShouldBeVisible(false); // hide all levels not associated with this schema
-                }
+                ApplyParameters(*spec, persistentRoot, levelRoot, SampleParameters(*spec, parameters));
             }
         }
+
+        if (m_sceneSwitch.state() == SceneSwitch::State::Showing && (!streamingLevel || streamingLevel->IsLevelVisible()))
+        {
+            const int64_t duration = m_sceneSwitch.shown(LatencyTracer::now());
+            m_sceneSwitchTime.record(uint64_t(duration));
+            UE_LOG(LogRenderStream, Log, TEXT("Switched to scene %u (%s) in %.2f ms"), m_frameData.scene,
+                streamingLevel ? *streamingLevel->GetWorldAssetPackageName() : TEXT("persistent level"), double(duration) / 1e6);
+        }
     }
 
     for (const TWeakObjectPtr<URenderStreamMediaCapture>& ptr : m_activeCaptures)
     {
         if (URenderStreamMediaCapture* capture = ptr.Get())
         {
-            RenderStreamLink::CameraData cameraData;
-            if (RenderStreamLink::instance().rs_getFrameCamera(m_assetHandle, capture->streamHandle(), &cameraData) == RenderStreamLink::RS_ERROR_SUCCESS)
+            for (const FrameReceiver::Camera& camera : snapshot.cameras)
             {
-                capture->ApplyCameraData(m_frameData, cameraData);
+                if (camera.valid && camera.stream == capture->streamHandle())
+                {
+                    capture->ApplyCameraData(m_frameData, camera.data, m_frameTrace);
+                    break;
+                }
             }
         }
     }
 }
 
+bool FRenderStreamModule::LatestCamera(RenderStreamLink::StreamHandle Stream, FrameReceiver::LatestCamera& Out) const
+{
+    return m_receiver && m_receiver->latestCamera(Stream, Out);
+}
+
 void FRenderStreamModule::AddActiveCapture(URenderStreamMediaCapture* InCapture)
 {
     m_activeCaptures.Add(InCapture);
+    UpdateReceiverStreams();
 }
 
 void FRenderStreamModule::RemoveActiveCapture(URenderStreamMediaCapture* InCapture)
 {
     m_activeCaptures.Remove(InCapture);
+    UpdateReceiverStreams();
+}
+
+void FRenderStreamModule::UpdateReceiverStreams()
+{
+    if (!m_receiver)
+        return;
+
+    std::vector<RenderStreamLink::StreamHandle> streams;
+    for (const TWeakObjectPtr<URenderStreamMediaCapture>& ptr : m_activeCaptures)
+    {
+        if (URenderStreamMediaCapture* capture = ptr.Get())
+            streams.push_back(capture->streamHandle());
+    }
+    m_receiver->setStreams(streams);
 }
 
 
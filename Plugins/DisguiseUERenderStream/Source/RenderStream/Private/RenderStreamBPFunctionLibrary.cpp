@@ -3,6 +3,7 @@
 
 #include "RenderStreamMediaOutput.h"
 #include "RenderStreamMediaCapture.h"
+#include "RenderStream.h"
 
 #include "Camera/CameraActor.h"
 #include "CinematicCamera/Public/CineCameraActor.h"
@@ -60,4 +61,9 @@ URenderStreamBPFunctionLibrary::URenderStreamBPFunctionLibrary(const FObjectInit
 {
     if (MediaCapture)
         MediaCapture->StopCapture(true);
+}
+
+/*static*/ void URenderStreamBPFunctionLibrary::PrefetchScene(const FString& Scene)
+{
+    FRenderStreamModule::Get()->HintScene(Scene);
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "RenderStreamCustomTimeStep.h"
+
+#include "RenderStream.h"
+#include "LatencyTracer.hpp"
+
+#include "Misc/App.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <chrono>
+
+namespace
+{
+    const TCHAR* StateName(FrameClock::State state)
+    {
+        switch (state)
+        {
+        case FrameClock::State::Synchronizing: return TEXT("synchronizing");
+        case FrameClock::State::Synchronized: return TEXT("synchronized");
+        case FrameClock::State::Error: return TEXT("lost");
+        default: return TEXT("closed");
+        }
+    }
+}
+
+URenderStreamCustomTimeStep::URenderStreamCustomTimeStep(const class FObjectInitializer& objectInitializer)
+    : Super(objectInitializer)
+    , MaxWaitMs(100)
+    , bStepByFrameTime(true)
+{
+}
+
+bool URenderStreamCustomTimeStep::Initialize(UEngine* InEngine)
+{
+    m_clock.reset();
+    m_reportedState = FrameClock::State::Closed;
+    FRenderStreamModule::Get()->SetTimeStepActive(true);
+    return true;
+}
+
+void URenderStreamCustomTimeStep::Shutdown(UEngine* InEngine)
+{
+    FRenderStreamModule::Get()->SetTimeStepActive(false);
+    const FrameClock::Stats& stats = m_clock.stats();
+    if (stats.arrived > 0)
+        UE_LOG(LogRenderStream, Log, TEXT("Genlock: %llu frames on time, %llu missed, %llu skipped, drift %.1f ppm"),
+            uint64(stats.arrived), uint64(stats.missed), uint64(stats.skipped), m_clock.driftPpm());
+}
+
+bool URenderStreamCustomTimeStep::UpdateTimeStep(UEngine* InEngine)
+{
+    // Without d3 the engine keeps its own time step. So it does without captures, taking the newest frame as it comes.
+    FRenderStreamModule* Module = FRenderStreamModule::Get();
+    if (!Module->IsReceiving())
+        return true;
+    if (Module->m_activeCaptures.Num() == 0)
+    {
+        Module->AwaitFrame(std::chrono::steady_clock::now());
+        return true;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamGenlock);
+
+    FApp::UpdateLastTime();
+
+    // Waits on the receive thread's signal, not spinning, until shortly after the next frame is due.
+    const int64_t start = LatencyTracer::now();
+    const int64_t deadline = m_clock.deadline(start, int64_t(MaxWaitMs) * 1000000);
+    const std::chrono::steady_clock::time_point until(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadline)));
+    if (Module->AwaitFrame(until) && Module->m_frameDataValid)
+        m_clock.arrived(Module->m_frameTrace.stamps[size_t(LatencyTracer::Stage::Received)], Module->m_frameData);
+    else
+        m_clock.missed();
+
+    const double now = FPlatformTime::Seconds();
+    FApp::SetCurrentTime(now);
+    FApp::SetIdleTime(double(LatencyTracer::now() - start) * 1e-9);
+    // A missed frame also steps by d3's frame time, so the engine coasts at d3's rate until frames return.
+    FApp::SetDeltaTime(bStepByFrameTime && m_clock.lastDelta() > 0. ? m_clock.lastDelta() : now - FApp::GetLastTime());
+
+    const FrameClock::State state = m_clock.state();
+    if (state != m_reportedState)
+    {
+        UE_LOG(LogRenderStream, Log, TEXT("Genlock %s: period %.3f ms (nominal %.3f ms), jitter %.3f ms, drift %.1f ppm"), StateName(state),
+            m_clock.period() * 1e3, m_clock.nominalPeriod() * 1e3, m_clock.jitter() * 1e3, m_clock.driftPpm());
+        m_reportedState = state;
+    }
+    return false;
+}
+
+ECustomTimeStepSynchronizationState URenderStreamCustomTimeStep::GetSynchronizationState() const
+{
+    if (!FRenderStreamModule::Get()->IsReceiving())
+        return ECustomTimeStepSynchronizationState::Closed;
+
+    switch (m_clock.state())
+    {
+    case FrameClock::State::Synchronizing: return ECustomTimeStepSynchronizationState::Synchronizing;
+    case FrameClock::State::Synchronized: return ECustomTimeStepSynchronizationState::Synchronized;
+    case FrameClock::State::Error: return ECustomTimeStepSynchronizationState::Error;
+    default: return ECustomTimeStepSynchronizationState::Closed;
+    }
+}
@@ -0,0 +1,11 @@
+#include "RenderStreamEvents.h"
+
+void URenderStreamEvents::BroadcastParametersChanged(const TArray<FName>& Parameters)
+{
+    if (Parameters.Num() == 0)
+        return;
+
+    for (const FName& Parameter : Parameters)
+        OnParameterChanged.Broadcast(Parameter);
+    OnParametersChanged.Broadcast(Parameters);
+}
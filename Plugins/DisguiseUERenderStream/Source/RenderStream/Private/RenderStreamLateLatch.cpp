@@ -0,0 +1,192 @@
+#include "RenderStreamLateLatch.h"
+
+#include "RenderStream.h"
+#include "RenderStreamMediaCapture.h"
+
+#include "Camera/CameraComponent.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/Actor.h"
+#include "RenderingThread.h"
+#include "SceneView.h"
+
+FRenderStreamLateLatch::FRenderStreamLateLatch(const FAutoRegister& AutoRegister, FRenderStreamModule* Module)
+    : FSceneViewExtensionBase(AutoRegister)
+    , m_module(Module)
+    , m_views(0)
+    , m_latched(0)
+{
+}
+
+void FRenderStreamLateLatch::Configure(const Config& config)
+{
+    m_config = config;
+    m_appliedSequence = 0;
+
+    TSharedRef<FRenderStreamLateLatch, ESPMode::ThreadSafe> self = StaticCastSharedRef<FRenderStreamLateLatch>(AsShared());
+    const CameraFilter::Settings filter = config.filter;
+    const CameraPredictor::Model prediction = config.prediction;
+    const double horizon = config.horizon;
+    ENQUEUE_RENDER_COMMAND(RenderStreamConfigureLateLatch)([self, filter, prediction, horizon](FRHICommandListImmediate&)
+    {
+        self->m_filter.configure(filter);
+        self->m_predictor.configure(prediction, horizon);
+        self->m_lastSequence = 0;
+        self->m_family = Family();
+        for (Latch& latch : self->m_latches)
+            latch.valid = false;
+    });
+}
+
+void FRenderStreamLateLatch::SetApplied(const RenderStreamLink::CameraResponseData& response, uint64 sequence)
+{
+    m_applied = response;
+    m_appliedSequence = sequence;
+}
+
+FRenderStreamLateLatch::Stats FRenderStreamLateLatch::GetStats() const
+{
+    Stats stats;
+    stats.views = m_views.load(std::memory_order_relaxed);
+    stats.latched = m_latched.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FRenderStreamLateLatch::BeginRenderViewFamily(FSceneViewFamily& InViewFamily)
+{
+    // Nothing to move from until the game thread applied a camera.
+    if (m_appliedSequence == 0 || m_applied.camera.cameraHandle == 0)
+        return;
+
+    USceneComponent* Location = m_config.locationReceiver.Get();
+    USceneComponent* Rotation = m_config.rotationReceiver.Get();
+    const UCameraComponent* Camera = m_config.camera.Get();
+
+    Family family;
+    for (const FSceneView* View : InViewFamily.Views)
+    {
+        const AActor* ViewActor = View ? View->ViewActor : nullptr;
+        if (ViewActor && ((Location && Location->GetOwner() == ViewActor) || (Rotation && Rotation->GetOwner() == ViewActor)))
+        {
+            family.viewActor = ViewActor;
+            break;
+        }
+    }
+    if (!family.viewActor)
+        return;
+
+    // The view only moves with receivers it is attached to. Nested receivers are applied child first, each then
+    // moving its children as they already are.
+    auto addStep = [&family, Camera](USceneComponent* Component, bool location, bool rotation)
+    {
+        if (!Component || (Camera && Camera != Component && !Camera->IsAttachedTo(Component)))
+            return;
+        Step& step = family.steps[family.nSteps++];
+        step.local = Component->GetRelativeTransform();
+        step.parent = step.local.Inverse() * Component->GetComponentTransform();
+        step.location = location;
+        step.rotation = rotation;
+    };
+    if (Location == Rotation)
+    {
+        addStep(Location, true, true);
+    }
+    else if (Location && Rotation && Rotation->IsAttachedTo(Location))
+    {
+        addStep(Rotation, false, true);
+        addStep(Location, true, false);
+    }
+    else
+    {
+        addStep(Location, true, false);
+        addStep(Rotation, false, true);
+    }
+    if (family.nSteps == 0)
+        return;
+
+    // The rendering thread sees the same frame number in GFrameNumberRenderThread, as does the capture of this frame.
+    family.frameNumber = GFrameNumber;
+    family.stream = m_config.stream;
+    family.unitScale = m_config.unitScale;
+    family.applied = m_applied;
+    family.sequence = m_appliedSequence;
+
+    TSharedRef<FRenderStreamLateLatch, ESPMode::ThreadSafe> self = StaticCastSharedRef<FRenderStreamLateLatch>(AsShared());
+    ENQUEUE_RENDER_COMMAND(RenderStreamLateLatchFamily)([self, family](FRHICommandListImmediate&)
+    {
+        self->m_family = family;
+    });
+}
+
+void FRenderStreamLateLatch::PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView)
+{
+    const Family& family = m_family;
+    if (family.nSteps == 0 || GFrameNumberRenderThread != family.frameNumber || InView.ViewActor != family.viewActor)
+        return;
+
+    m_views.fetch_add(1, std::memory_order_relaxed);
+
+    FrameReceiver::LatestCamera latest;
+    if (!m_module->LatestCamera(family.stream, latest))
+        return;
+
+    // Every camera seen goes through the filter once, whether or not it ends up newer than the game thread's.
+    if (latest.sequence != m_lastSequence)
+    {
+        RenderStreamLink::CameraData pose = latest.data;
+        m_filter.filter(latest.frameData.tTracked, latest.frameData.localTimeDelta, pose);
+        m_lastPose = m_predictor.predict(latest.frameData.tTracked, pose);
+        m_lastSequence = latest.sequence;
+    }
+    if (latest.sequence <= family.sequence || m_lastPose.cameraHandle == 0)
+        return;
+
+    const FVector Location = URenderStreamMediaCapture::TrackedLocation(m_lastPose, family.unitScale);
+    const FQuat Rotation = URenderStreamMediaCapture::TrackedRotation(m_lastPose);
+
+    // The view keeps its place relative to each receiver while the receiver moves to the latched pose.
+    FTransform ViewTransform(InView.ViewRotation, InView.ViewLocation);
+    for (int32 i = 0; i < family.nSteps; ++i)
+    {
+        const Step& step = family.steps[i];
+        FTransform Local = step.local;
+        if (step.location)
+            Local.SetTranslation(Location);
+        if (step.rotation)
+            Local.SetRotation(Rotation);
+        ViewTransform = ViewTransform * (step.local * step.parent).Inverse() * (Local * step.parent);
+    }
+    InView.ViewLocation = ViewTransform.GetLocation();
+    InView.ViewRotation = ViewTransform.Rotator();
+    InView.UpdateViewMatrix();
+
+    // d3 is told the pose rendered, with the lens the game thread applied.
+    Latch& latch = m_latches[family.frameNumber % LatchFrames];
+    latch.frameNumber = family.frameNumber;
+    latch.valid = true;
+    latch.response = family.applied;
+    latch.response.tTracked = latest.frameData.tTracked;
+    latch.response.camera.x = m_lastPose.x;
+    latch.response.camera.y = m_lastPose.y;
+    latch.response.camera.z = m_lastPose.z;
+    latch.response.camera.rx = m_lastPose.rx;
+    latch.response.camera.ry = m_lastPose.ry;
+    latch.response.camera.rz = m_lastPose.rz;
+    latch.sequence = latest.sequence;
+    latch.receivedAt = latest.receivedAt;
+    m_latched.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FRenderStreamLateLatch::Patch(uint32 FrameNumber, RenderStreamLink::CameraResponseData& response, LatencyTracer::Trace& trace) const
+{
+    const Latch& latch = m_latches[FrameNumber % LatchFrames];
+    if (!latch.valid || latch.frameNumber != FrameNumber)
+        return;
+
+    response = latch.response;
+
+    // Measured from the latched frame's arrival. The game thread stages happened before it arrived, so are left out.
+    trace.frameId = latch.sequence;
+    trace.stamps[size_t(LatencyTracer::Stage::Received)] = latch.receivedAt;
+    trace.stamps[size_t(LatencyTracer::Stage::Applied)] = 0;
+    trace.stamps[size_t(LatencyTracer::Stage::UserData)] = 0;
+}
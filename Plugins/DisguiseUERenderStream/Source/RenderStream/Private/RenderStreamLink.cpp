@@ -10,8 +10,168 @@
 #include <WinError.h>
 #include <Winreg.h>
 #include <libloaderapi.h>
+#else
+#include <dlfcn.h>
 #endif 
 
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Parse.h"
+
+#include "SessionLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Explicit library location, in order: -RenderStreamLibrary=<path>, the RENDERSTREAM_LIBRARY environment variable,
+    // then LibraryPath in the RenderStream project settings. Empty means the installed d3 library.
+    FString libraryOverride()
+    {
+        FString path;
+        if (FParse::Value(FCommandLine::Get(), TEXT("RenderStreamLibrary="), path) && !path.IsEmpty())
+            return path;
+
+        path = FPlatformMisc::GetEnvironmentVariable(TEXT("RENDERSTREAM_LIBRARY"));
+        if (!path.IsEmpty())
+            return path;
+
+        // Read straight from config, this runs before the settings object exists.
+        if (GConfig)
+            GConfig->GetString(TEXT("/Script/RenderStream.RenderStreamSettings"), TEXT("LibraryPath"), path, GEngineIni);
+        return path;
+    }
+}
+
+namespace
+{
+    // The rs_* entry points are plain functions, so the replayed session lives here. All three are only called from
+    // the receive thread, one frame at a time.
+    struct ReplaySession
+    {
+        std::unique_ptr<SessionReader> reader;
+        RenderStreamLink::AssetHandle asset = 0;
+        double speed = 1.;
+        bool loop = false;
+
+        size_t next = 0;
+        uint64_t loops = 0;
+        bool started = false;
+        std::chrono::steady_clock::time_point start;
+        int64_t startTime = 0;
+        SessionFrame current;
+        bool hasCurrent = false;
+
+        // Stream handles change between sessions. Recorded streams, in order of first appearance, are matched to live
+        // ones in the order their cameras are first asked for.
+        std::vector<RenderStreamLink::StreamHandle> recordedStreams;
+        std::vector<RenderStreamLink::StreamHandle> liveStreams;
+    };
+
+    std::unique_ptr<ReplaySession>& replaySession()
+    {
+        static std::unique_ptr<ReplaySession> session;
+        return session;
+    }
+
+    RenderStreamLink::RS_ERROR replayAwaitFrameData(RenderStreamLink::AssetHandle* assetHandle, int timeoutMs, RenderStreamLink::FrameData* data)
+    {
+        ReplaySession& s = *replaySession();
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+
+        if (s.next >= s.reader->frameCount())
+        {
+            if (!s.loop || s.reader->frameCount() == 0)
+            {
+                std::this_thread::sleep_until(deadline);
+                return RenderStreamLink::RS_ERROR_UNSPECIFIED;
+            }
+            s.next = 0;
+            s.started = false;
+            ++s.loops;
+        }
+
+        const SessionFrame frame = s.reader->frame(s.next);
+        if (!s.started)
+        {
+            s.start = std::chrono::steady_clock::now();
+            s.startTime = frame.time;
+            s.started = true;
+        }
+        if (s.speed > 0.)
+        {
+            const std::chrono::steady_clock::time_point due = s.start + std::chrono::nanoseconds(int64_t(double(frame.time - s.startTime) / s.speed));
+            if (due > deadline)
+            {
+                std::this_thread::sleep_until(deadline);
+                return RenderStreamLink::RS_ERROR_UNSPECIFIED;
+            }
+            std::this_thread::sleep_until(due);
+        }
+
+        *assetHandle = s.asset;
+        *data = frame.frameData;
+        if (s.next == 0 && s.loops > 0)
+            data->flags |= RenderStreamLink::FRAMEDATA_RESET;
+        s.current = frame;
+        s.hasCurrent = true;
+        ++s.next;
+        return RenderStreamLink::RS_ERROR_SUCCESS;
+    }
+
+    RenderStreamLink::RS_ERROR replayGetFrameParameters(RenderStreamLink::AssetHandle assetHandle, uint64_t schemaHash, void* outParameterData, size_t outParameterDataSize)
+    {
+        const ReplaySession& s = *replaySession();
+        if (assetHandle != s.asset)
+            return RenderStreamLink::RS_ERROR_INVALIDHANDLE;
+        if (!s.hasCurrent)
+            return RenderStreamLink::RS_ERROR_NOTFOUND;
+        if (!s.current.parametersValid)
+            return RenderStreamLink::RS_ERROR_UNSPECIFIED;
+        if (schemaHash != s.current.schemaHash || outParameterDataSize != s.current.nParameters * sizeof(float))
+            return RenderStreamLink::RS_ERROR_INCORRECTSCHEMA;
+        if (outParameterDataSize)
+            std::memcpy(outParameterData, s.current.parameters, outParameterDataSize);
+        return RenderStreamLink::RS_ERROR_SUCCESS;
+    }
+
+    RenderStreamLink::RS_ERROR replayGetFrameCamera(RenderStreamLink::AssetHandle assetHandle, RenderStreamLink::StreamHandle streamHandle, RenderStreamLink::CameraData* outCameraData)
+    {
+        ReplaySession& s = *replaySession();
+        if (assetHandle != s.asset)
+            return RenderStreamLink::RS_ERROR_INVALIDHANDLE;
+        if (!s.hasCurrent)
+            return RenderStreamLink::RS_ERROR_NOTFOUND;
+
+        auto live = std::find(s.liveStreams.begin(), s.liveStreams.end(), streamHandle);
+        if (live == s.liveStreams.end())
+        {
+            if (s.liveStreams.size() >= s.recordedStreams.size())
+                return RenderStreamLink::RS_ERROR_NOTFOUND;
+            s.liveStreams.push_back(streamHandle);
+            live = s.liveStreams.end() - 1;
+        }
+        const RenderStreamLink::StreamHandle recorded = s.recordedStreams[size_t(live - s.liveStreams.begin())];
+
+        for (size_t i = 0; i < s.current.nCameras; ++i)
+        {
+            const SessionCamera& camera = s.current.cameras[i];
+            if (camera.stream == recorded && camera.valid)
+            {
+                *outCameraData = camera.data;
+                outCameraData->id = streamHandle;
+                return RenderStreamLink::RS_ERROR_SUCCESS;
+            }
+        }
+        return RenderStreamLink::RS_ERROR_NOTFOUND;
+    }
+}
+
 /* static */ RenderStreamLink& RenderStreamLink::instance()
 {
     static RenderStreamLink r;
@@ -38,38 +198,49 @@ bool RenderStreamLink::loadExplicit()
     if (isAvailable())
         return true;
 
-#ifdef WINDOWS
+    const FString overridePath = libraryOverride();
 
-    //#define USE_HARD_PATH
-#ifndef USE_HARD_PATH
-    HKEY hKey;
-    HRESULT hResult = RegOpenKeyExW(HKEY_CURRENT_USER, L"Software\\d3 Technologies\\d3 Production Suite", 0, KEY_READ, &hKey);
-    if (FAILED(hResult))
+#ifdef WINDOWS
+    FString exePath;
+    FString dllName;
+    if (!overridePath.IsEmpty())
     {
-        UE_LOG(LogRenderStream, Error, TEXT("Failed to open d3 production suite registry key."));
-        return false;
+        exePath = FPaths::GetPath(overridePath) + TEXT("\\");
+        dllName = FPaths::GetCleanFilename(overridePath);
     }
-
-    FString valueName("exe path");
-    TCHAR buffer[512];
-    DWORD bufferSize = sizeof(buffer);
-    hResult = RegQueryValueExW(hKey, *valueName, 0, nullptr, reinterpret_cast<LPBYTE>(buffer), &bufferSize);
-    if (FAILED(hResult))
+    else
     {
-        UE_LOG(LogRenderStream, Error, TEXT("Failed to query exe path registry value."));
-        return false;
-    }
+        //#define USE_HARD_PATH
+#ifndef USE_HARD_PATH
+        HKEY hKey;
+        HRESULT hResult = RegOpenKeyExW(HKEY_CURRENT_USER, L"Software\\d3 Technologies\\d3 Production Suite", 0, KEY_READ, &hKey);
+        if (FAILED(hResult))
+        {
+            UE_LOG(LogRenderStream, Error, TEXT("Failed to open d3 production suite registry key."));
+            return false;
+        }
+
+        FString valueName("exe path");
+        TCHAR buffer[512];
+        DWORD bufferSize = sizeof(buffer);
+        hResult = RegQueryValueExW(hKey, *valueName, 0, nullptr, reinterpret_cast<LPBYTE>(buffer), &bufferSize);
+        if (FAILED(hResult))
+        {
+            UE_LOG(LogRenderStream, Error, TEXT("Failed to query exe path registry value."));
+            return false;
+        }
 
 
-    FString exePath(buffer);
+        exePath = FString(buffer);
 #else
-    FString exePath = "c:\\code\\d3dev2\\fbuild\\x64-msvc12.0-toolset120-Release-full\\d3\\build\\msvc\\d3.exe";
+        exePath = "c:\\code\\d3dev2\\fbuild\\x64-msvc12.0-toolset120-Release-full\\d3\\build\\msvc\\d3.exe";
 #endif
-    int32 index;
-    exePath.FindLastChar('\\', index);
-    if (index != exePath.Len() - 1)
-        exePath = exePath.Left(index + 1);
-    FString dllName("d3renderstream.dll");
+        int32 index;
+        exePath.FindLastChar('\\', index);
+        if (index != exePath.Len() - 1)
+            exePath = exePath.Left(index + 1);
+        dllName = "d3renderstream.dll";
+    }
 
     if (!FPaths::FileExists(exePath + dllName))
     {
@@ -83,6 +254,18 @@ bool RenderStreamLink::loadExplicit()
         UE_LOG(LogRenderStream, Error, TEXT("Failed to load %s."), *exePath);
         return false;
     }
+#else
+    // There is no d3 install to find outside Windows, default to the loader's search path.
+    const FString libraryPath = overridePath.IsEmpty() ? FString(TEXT("libd3renderstream.so")) : overridePath;
+    m_dll = dlopen(TCHAR_TO_UTF8(*libraryPath), RTLD_NOW | RTLD_LOCAL);
+    if (m_dll == nullptr)
+    {
+        const char* error = dlerror();
+        UE_LOG(LogRenderStream, Error, TEXT("Failed to load %s: %s"), *libraryPath, error ? UTF8_TO_TCHAR(error) : TEXT("unknown error"));
+        return false;
+    }
+    UE_LOG(LogRenderStream, Log, TEXT("Loaded RenderStream library %s"), *libraryPath);
+#endif
 
 #define LOAD_FN(FUNC_NAME) \
     FUNC_NAME = (FUNC_NAME ## Fn*)FPlatformProcess::GetDllExport(m_dll, TEXT(#FUNC_NAME)); \
@@ -120,23 +303,78 @@ bool RenderStreamLink::loadExplicit()
 
     m_loaded = true;
 
-    rs_registerLoggingFunc(&log_default);
-    rs_registerErrorLoggingFunc(&log_error);
-    rs_registerVerboseLoggingFunc(&log_verbose);
-
-#endif
-
     return isAvailable();
 }
 
 bool RenderStreamLink::unloadExplicit()
 {
-    if (rs_shutdown)
+    stopReplay();
+
+    // The function pointers die with the library, so only shut down what is actually loaded.
+    if (m_dll && m_loaded && rs_shutdown)
         rs_shutdown();
+    m_loaded = false;
 #ifdef WINDOWS
     if (m_dll)
         FreeLibrary((HMODULE)m_dll);
-    m_dll = nullptr;
+#else
+    if (m_dll)
+        dlclose(m_dll);
 #endif
+    m_dll = nullptr;
     return m_dll == nullptr;
 }
+
+bool RenderStreamLink::startReplay(const char* path, AssetHandle asset, double speed, bool loop)
+{
+    if (!isAvailable())
+        return false;
+    stopReplay();
+
+    std::unique_ptr<ReplaySession> session = std::make_unique<ReplaySession>();
+    session->reader = SessionReader::open(path);
+    if (!session->reader)
+    {
+        UE_LOG(LogRenderStream, Error, TEXT("Unable to open RenderStream session %s"), UTF8_TO_TCHAR(path));
+        return false;
+    }
+    session->asset = asset;
+    session->speed = std::max(speed, 0.);
+    session->loop = loop;
+
+    for (size_t i = 0; i < session->reader->frameCount(); ++i)
+    {
+        const SessionFrame frame = session->reader->frame(i);
+        for (size_t c = 0; c < frame.nCameras; ++c)
+        {
+            if (std::find(session->recordedStreams.begin(), session->recordedStreams.end(), frame.cameras[c].stream) == session->recordedStreams.end())
+                session->recordedStreams.push_back(frame.cameras[c].stream);
+        }
+    }
+
+    UE_LOG(LogRenderStream, Log, TEXT("Replaying %llu frames and %llu streams from %s%s"), uint64(session->reader->frameCount()), uint64(session->recordedStreams.size()),
+        UTF8_TO_TCHAR(path), session->reader->indexed() ? TEXT("") : TEXT(", index rebuilt from an unfinished recording"));
+    replaySession() = std::move(session);
+
+    m_liveAwaitFrameData = rs_awaitFrameData;
+    m_liveGetFrameParameters = rs_getFrameParameters;
+    m_liveGetFrameCamera = rs_getFrameCamera;
+    rs_awaitFrameData = &replayAwaitFrameData;
+    rs_getFrameParameters = &replayGetFrameParameters;
+    rs_getFrameCamera = &replayGetFrameCamera;
+    return true;
+}
+
+void RenderStreamLink::stopReplay()
+{
+    if (!isReplaying())
+        return;
+
+    rs_awaitFrameData = m_liveAwaitFrameData;
+    rs_getFrameParameters = m_liveGetFrameParameters;
+    rs_getFrameCamera = m_liveGetFrameCamera;
+    m_liveAwaitFrameData = nullptr;
+    m_liveGetFrameParameters = nullptr;
+    m_liveGetFrameCamera = nullptr;
+    replaySession().reset();
+}
@@ -8,8 +8,12 @@
 //#include <cuda_d3d11_interop.h>
 
 #include "RenderStreamMediaOutput.h"
+#include "RenderStreamLateLatch.h"
+#include "PixelConvert.hpp"
+#include "fnv.hpp"
 
 #include "Engine/Public/EngineUtils.h"
+#include "Engine/GameViewportClient.h"
 #include "Engine/Public/HardwareInfo.h"
 
 #include "Camera/CameraActor.h"
@@ -19,6 +23,7 @@
 #include "CinematicCamera/Public/CineCameraActor.h"
 #include "CinematicCamera/Public/CineCameraComponent.h"
 
+#if PLATFORM_WINDOWS
 #include <d3d11.h>
 #include "D3D11RHI/Public/D3D11State.h"
 #include "D3D11RHI/Public/D3D11Resources.h"
@@ -35,8 +40,10 @@ class FD3D12CommandAllocator;
 #include "D3D12RHI/Public/D3D12State.h"
 #include "D3D12RHI/Public/D3D12Resources.h"
 #include "D3D12RHI/Public/D3D12Util.h"
+#endif
 
 #include "RHI/Public/RHICommandList.h"
+#include "RenderingThread.h"
 
 #include "PipelineStateCache.h"
 #include "RendererInterface.h"
@@ -47,8 +54,10 @@ class FD3D12CommandAllocator;
 #include "RenderCore/Public/ShaderParameterMacros.h"
 #include "RenderCore/Public/ShaderParameterUtils.h"
 #include "Core/Public/Misc/ConfigCacheIni.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 
+#if PLATFORM_WINDOWS
 namespace
 {
     HRESULT DX12CreateSharedRenderTarget2D(ID3D12Device * device,
@@ -100,6 +109,7 @@ namespace
     }
 
 }
+#endif
 
 
 static EUnit getGlobalUnitEnum()
@@ -124,6 +134,9 @@ class RSResizeCopy
 {
     DECLARE_EXPORTED_SHADER_TYPE(RSResizeCopy, Global, /* RenderStream */);
 public:
+    // One permutation per PixelConvert::AlphaOp
+    class FAlphaOp : SHADER_PERMUTATION_INT("RS_ALPHA_OP", int32(PixelConvert::AlphaOp::Count));
+    using FPermutationDomain = TShaderPermutationDomain<FAlphaOp>;
 
     static bool ShouldCache(EShaderPlatform Platform)
     {
@@ -198,6 +211,7 @@ RenderStreamLink::SenderPixelFormat GetSendingFormat(ERenderStreamMediaOutputFor
     case ERenderStreamMediaOutputFormat::BGRA: return RenderStreamLink::SenderPixelFormat::FMT_BGRA;
         //case ERenderStreamMediaOutputFormat::RGBA: return RenderStreamLink::FourCC::RGBA;
     case ERenderStreamMediaOutputFormat::YUV422: return RenderStreamLink::SenderPixelFormat::FMT_UYVY_422;
+    case ERenderStreamMediaOutputFormat::YUV422_ALPHA: return RenderStreamLink::SenderPixelFormat::FMT_NDI_UYVY_422_A;
 
 
     case ERenderStreamMediaOutputFormat::YUV422_10b: return RenderStreamLink::SenderPixelFormat::FMT_UC_YUV422_10BIT;
@@ -216,18 +230,62 @@ float WidthMultiplier(RenderStreamLink::SenderPixelFormat fourcc)
 {
     switch (fourcc)
     {
-    case RenderStreamLink::SenderPixelFormat::FMT_NDI_UYVY_422_A:
-    case RenderStreamLink::SenderPixelFormat::FMT_UYVY_422: return 2.f;
+    case RenderStreamLink::SenderPixelFormat::FMT_UYVY_422: return 2.f; // Two pixels per BGRA texel out of the GPU conversion
     default: return 1.f;
     }
 }
 
-float HeightMultiplier(RenderStreamLink::SenderPixelFormat fourcc)
+// Bytes per pixel of the frame dimensions handed to rs_sendFrame
+size_t BytesPerPixel(RenderStreamLink::SenderPixelFormat fourcc)
 {
     switch (fourcc)
     {
-    case RenderStreamLink::SenderPixelFormat::FMT_NDI_UYVY_422_A: return 1.5f;
-    default: return 1.f;
+    case RenderStreamLink::SenderPixelFormat::FMT_NDI_UYVY_422_A:
+    case RenderStreamLink::SenderPixelFormat::FMT_UYVY_422: return 2;
+    default: return 4;
+    }
+}
+
+PixelConvert::AlphaOp GetAlphaOp(ERenderStreamAlphaType alpha)
+{
+    switch (alpha)
+    {
+    case ERenderStreamAlphaType::SET_ONE: return PixelConvert::AlphaOp::SetOne;
+    case ERenderStreamAlphaType::INVERT: return PixelConvert::AlphaOp::Invert;
+    case ERenderStreamAlphaType::PREMULTIPLY: return PixelConvert::AlphaOp::Premultiply;
+    case ERenderStreamAlphaType::UNPREMULTIPLY: return PixelConvert::AlphaOp::Unpremultiply;
+    default: return PixelConvert::AlphaOp::None;
+    }
+}
+
+CameraPredictor::Model GetPredictionModel(ERenderStreamCameraPrediction prediction)
+{
+    switch (prediction)
+    {
+    case ERenderStreamCameraPrediction::CONSTANT_VELOCITY: return CameraPredictor::Model::ConstantVelocity;
+    case ERenderStreamCameraPrediction::CONSTANT_ACCELERATION: return CameraPredictor::Model::ConstantAcceleration;
+    case ERenderStreamCameraPrediction::KALMAN: return CameraPredictor::Model::Kalman;
+    default: return CameraPredictor::Model::None;
+    }
+}
+
+FrameSender::Policy GetSendPolicy(ERenderStreamSendPolicy policy)
+{
+    switch (policy)
+    {
+    case ERenderStreamSendPolicy::BLOCK: return FrameSender::Policy::Block;
+    case ERenderStreamSendPolicy::DROP_OLDEST: return FrameSender::Policy::DropOldest;
+    default: return FrameSender::Policy::LatestWins;
+    }
+}
+
+RenderOnDemand::Policy GetRenderPolicy(ERenderStreamRenderPolicy policy)
+{
+    switch (policy)
+    {
+    case ERenderStreamRenderPolicy::RESEND: return RenderOnDemand::Policy::Resend;
+    case ERenderStreamRenderPolicy::SUPPRESS: return RenderOnDemand::Policy::Suppress;
+    default: return RenderOnDemand::Policy::Always;
     }
 }
 
@@ -249,9 +307,18 @@ bool URenderStreamMediaCapture::CreateSenderHandle()
 
     m_module = FRenderStreamModule::Get();
 
+    // Frames of a previous capture may still be queued on the rendering thread, reading the capture's settings and
+    // holding the sender and host buffers about to be replaced.
+    FlushRenderingCommands();
+
     m_fmt = GetSendingFormat(Output->OutputFormat());
 
     m_useUC = isUCFormat(Output->m_outputFormat);
+    m_cpuConvert = !m_useUC && Output->ConvertsOnCPU();
+    m_alphaOp = GetAlphaOp(Output->m_alphatype);
+
+    m_sender.Reset();
+    m_hostBuffers.reset();
 
     // name selection priority goes Camera > Location > Rotation
     USceneComponent* BestComp = m_cameraDataReceiver.Get();
@@ -265,6 +332,11 @@ bool URenderStreamMediaCapture::CreateSenderHandle()
     UpdateSchema();
 
     if (m_useUC) {
+#if !PLATFORM_WINDOWS
+        UE_LOG(LogRenderStream, Error, TEXT("Uncompressed RenderStream needs the D3D11 or D3D12 RHI."));
+        m_module->m_status.setOutputStatus("Error: Uncompressed streams need D3D11 or D3D12", RSSTATUS_RED);
+        return false;
+#else
         auto point = Output->m_desiredSize;
         FRHIResourceCreateInfo info{ FClearValueBinding::Green };
 
@@ -317,6 +389,7 @@ bool URenderStreamMediaCapture::CreateSenderHandle()
         }
         UE_LOG(LogRenderStream, Log, TEXT("Created uncompressed stream '%s'"), *m_streamName);
         m_module->m_status.setOutputStatus("Connected to uncompressed stream", RSSTATUS_GREEN);
+#endif
     }
     else {
         if (RenderStreamLink::instance().rs_createStream(m_module->m_assetHandle, TCHAR_TO_ANSI(*m_streamName), &m_streamHandle) != 0)
@@ -328,6 +401,31 @@ bool URenderStreamMediaCapture::CreateSenderHandle()
         }
         UE_LOG(LogRenderStream, Log, TEXT("Created NDI stream '%s'"), *m_streamName);
         m_module->m_status.setOutputStatus("Connected to NDI stream", RSSTATUS_GREEN);
+
+        if (Output->m_asyncSend)
+        {
+            const RenderStreamLink::AssetHandle assetHandle = m_module->m_assetHandle;
+            const RenderStreamLink::StreamHandle streamHandle = m_streamHandle;
+            FRenderStreamModule* module = m_module;
+            m_sender = MakeUnique<FrameSender>([assetHandle, streamHandle, module](FrameSender::Frame& frame)
+            {
+                TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamSendFrame);
+                const RenderStreamLink::RS_ERROR ret = RenderStreamLink::instance().rs_sendFrame(assetHandle, streamHandle, frame.frameType, frame.data, frame.width, frame.height, frame.format, &frame.response);
+                if (ret == RenderStreamLink::RS_ERROR_SUCCESS)
+                {
+                    frame.trace.stamp(LatencyTracer::Stage::Sent);
+                    module->RecordLatency(frame.trace);
+                }
+                return ret;
+            }, size_t(FMath::Max(Output->m_sendQueueDepth, 1)), GetSendPolicy(Output->m_sendPolicy));
+
+            m_hostBufferFlags = (Output->m_hostBufferLargePages ? FrameBufferPool::FLAG_LARGE_PAGES : 0) | (Output->m_hostBufferLocked ? FrameBufferPool::FLAG_LOCKED : 0);
+
+            // Without an override the capture size is only known once frames arrive, the pool is then created on the first one.
+            const FIntPoint size = Output->GetRequestedSize();
+            if (size.X > 0 && size.Y > 0)
+                EnsureHostBuffers(m_cpuConvert ? PixelConvert::frameBytes(m_fmt, size.X, size.Y) : size_t(size.X) * size_t(size.Y) * BytesPerPixel(m_fmt));
+        }
     }
 
     m_module->AddActiveCapture(this);
@@ -335,11 +433,71 @@ bool URenderStreamMediaCapture::CreateSenderHandle()
     return true;
 }
 
-void URenderStreamMediaCapture::ApplyCameraData(const RenderStreamLink::FrameData& frameData, const RenderStreamLink::CameraData& cameraData)
+void URenderStreamMediaCapture::ConvertFrame(const void* InBuffer, int32 Width, int32 Height, uint8* OutBuffer) const
 {
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamConvertFrame);
+
+    PixelConvert::Image image;
+    image.src = InBuffer;
+    image.srcPitch = size_t(Width) * 4;
+    image.srcFormat = PixelConvert::SourceFormat::BGRA8;
+    image.dst = OutBuffer;
+    image.dstPitch = PixelConvert::rowBytes(m_fmt, Width);
+    image.dstFormat = m_fmt;
+    image.width = Width;
+    image.height = Height;
+    image.alphaOp = m_alphaOp;
+
+    m_module->Converter().convert(image);
+}
+
+void URenderStreamMediaCapture::KeepFrame(const void* Frame, size_t FrameBytes, int32 Width, int32 Height)
+{
+    m_keptFrame.SetNumUninitialized(int32(FrameBytes), false);
+    FMemory::Memcpy(m_keptFrame.GetData(), Frame, FrameBytes);
+    m_keptWidth = Width;
+    m_keptHeight = Height;
+    m_keptValid = true;
+}
+
+bool URenderStreamMediaCapture::EnsureHostBuffers(size_t FrameBytes)
+{
+    if (m_hostBuffers && m_hostBuffers->bufferBytes() >= FrameBytes)
+        return true;
+
+    // One buffer for every queue slot, one being sent and one being filled. Buffers still in flight keep the old pool alive.
+    const size_t count = m_sender->capacity() + 2;
+    m_hostBuffers = FrameBufferPool::create(count, FrameBytes, m_hostBufferFlags);
+    if (m_hostBuffers->bufferCount() < count)
+    {
+        UE_LOG(LogRenderStream, Error, TEXT("Failed to allocate %llu host frame buffers of %llu bytes."), uint64(count), uint64(FrameBytes));
+        m_hostBuffers.reset();
+        return false;
+    }
+
+    if (m_hostBuffers->flags() != m_hostBufferFlags)
+        UE_LOG(LogRenderStream, Warning, TEXT("Host frame buffers allocated without large pages or locking, check process privileges."));
+    UE_LOG(LogRenderStream, Log, TEXT("Allocated %llu host frame buffers of %llu bytes for '%s'"), uint64(count), uint64(FrameBytes), *m_streamName);
+    return true;
+}
+
+void URenderStreamMediaCapture::ApplyCameraData(const RenderStreamLink::FrameData& frameData, const RenderStreamLink::CameraData& trackedData, const LatencyTracer::Trace& trace)
+{
+    // d3 is told the pose actually rendered, which with filtering or prediction is not the one tracked at tTracked.
+    RenderStreamLink::CameraData cameraData = trackedData;
+    if (cameraData.cameraHandle != 0)
+    {
+        m_filter.filter(frameData.tTracked, frameData.localTimeDelta, cameraData);
+        cameraData = m_predictor.predict(frameData.tTracked, cameraData);
+    }
+
     // Always update response data
     m_frameResponseData.tTracked = frameData.tTracked;
     m_frameResponseData.camera = cameraData;
+    m_frameTrace = trace;
+    m_frameTrace.stamp(LatencyTracer::Stage::Applied);
+    if (m_lateLatch)
+        m_lateLatch->SetApplied(m_frameResponseData, trace.frameId);
 
     if (cameraData.cameraHandle == 0)
         return;
@@ -362,21 +520,56 @@ void URenderStreamMediaCapture::ApplyCameraData(const RenderStreamLink::FrameDat
     USceneComponent* LocationComp = m_locationReceiver.Get();
     USceneComponent* RotationComp = m_rotationReceiver.Get();
     if (RotationComp)
-    {
-        float _pitch = cameraData.rx;
-        float _yaw = cameraData.ry;
-        float _roll = cameraData.rz;
-        FQuat rotationQuat = FQuat::MakeFromEuler(FVector(_roll, _pitch, _yaw));
-        RotationComp->SetRelativeRotation(rotationQuat);
-    }
+        RotationComp->SetRelativeRotation(TrackedRotation(cameraData));
     if (LocationComp)
-    {
-        FVector pos;
-        pos.X = FUnitConversion::Convert(float(cameraData.z), EUnit::Meters, m_unitScale);
-        pos.Y = FUnitConversion::Convert(float(cameraData.x), EUnit::Meters, m_unitScale);
-        pos.Z = FUnitConversion::Convert(float(cameraData.y), EUnit::Meters, m_unitScale);
-        LocationComp->SetRelativeLocation(pos);
-    }
+        LocationComp->SetRelativeLocation(TrackedLocation(cameraData, m_unitScale));
+}
+
+/*static*/ FVector URenderStreamMediaCapture::TrackedLocation(const RenderStreamLink::CameraData& cameraData, EUnit unitScale)
+{
+    FVector pos;
+    pos.X = FUnitConversion::Convert(float(cameraData.z), EUnit::Meters, unitScale);
+    pos.Y = FUnitConversion::Convert(float(cameraData.x), EUnit::Meters, unitScale);
+    pos.Z = FUnitConversion::Convert(float(cameraData.y), EUnit::Meters, unitScale);
+    return pos;
+}
+
+/*static*/ FQuat URenderStreamMediaCapture::TrackedRotation(const RenderStreamLink::CameraData& cameraData)
+{
+    float _pitch = cameraData.rx;
+    float _yaw = cameraData.ry;
+    float _roll = cameraData.rz;
+    return FQuat::MakeFromEuler(FVector(_roll, _pitch, _yaw));
+}
+
+void URenderStreamMediaCapture::DecideRender(uint64_t inputs, bool receiving)
+{
+    if (m_onDemand.always())
+        return;
+
+    // The camera as applied, and the newest from d3 when the late latch may still move the view to it.
+    RenderStreamLink::CameraData cameras[2] = { m_frameResponseData.camera, {} };
+    FrameReceiver::LatestCamera latest;
+    if (m_lateLatch && m_lateLatch->IsEnabled() && m_module->LatestCamera(m_streamHandle, latest))
+        cameras[1] = latest.data;
+
+    StreamFNV fingerprint;
+    fingerprint.addData(reinterpret_cast<const unsigned char*>(&inputs), sizeof(inputs));
+    fingerprint.addData(reinterpret_cast<const unsigned char*>(cameras), sizeof(cameras));
+    m_renderDecision = m_onDemand.next(fingerprint.getHash(), receiving, LatencyTracer::now());
+
+    // Only the game viewport can be told not to draw the world, a render target is drawn by whatever owns it.
+    const bool disable = m_renderDecision.action != RenderOnDemand::Action::Render;
+    UGameViewportClient* Viewport = m_gameViewport.Get();
+    if (Viewport && disable != m_worldRenderingDisabled)
+        Viewport->bDisableWorldRendering = disable;
+    m_worldRenderingDisabled = disable;
+}
+
+void URenderStreamMediaCapture::LateLatch(FRenderStreamUserData& userData) const
+{
+    if (m_lateLatch)
+        m_lateLatch->Patch(userData.frameNumber, userData.frameData, userData.trace);
 }
 
 UWorld* URenderStreamMediaCapture::SchemaWorld() const
@@ -417,6 +610,13 @@ void URenderStreamMediaCapture::OnCustomCapture_RenderingThread(
         m_printSuccess = true;
     }
 
+    TSharedPtr<FRenderStreamUserData, ESPMode::ThreadSafe> FrameData = StaticCastSharedPtr<FRenderStreamUserData>(InUserData);
+    const RenderOnDemand::Action action = FrameData->render.action;
+    if (action == RenderOnDemand::Action::Skip)
+        return;
+
+    // A resent frame is the one the shared texture still holds, the last drawn.
+    if (action == RenderOnDemand::Action::Render)
     {
         // convert the source with a draw call
         FGraphicsPipelineStateInitializer GraphicsPSOInit;
@@ -438,7 +638,9 @@ void URenderStreamMediaCapture::OnCustomCapture_RenderingThread(
         GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GMediaVertexDeclaration.VertexDeclarationRHI;
         GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
 
-        TShaderMapRef<RSResizeCopy> ConvertShader(ShaderMap);
+        RSResizeCopy::FPermutationDomain PermutationVector;
+        PermutationVector.Set<RSResizeCopy::FAlphaOp>(int32(m_alphaOp));
+        TShaderMapRef<RSResizeCopy> ConvertShader(ShaderMap, PermutationVector);
         GraphicsPSOInit.BoundShaderState.PixelShaderRHI = ConvertShader.GetPixelShader();
         SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);
         auto streamTexSize = m_bufTexture->GetTexture2D()->GetSizeXY();
@@ -458,37 +660,44 @@ void URenderStreamMediaCapture::OnCustomCapture_RenderingThread(
         RHICmdList.TransitionResource(EResourceTransitionAccess::EReadable, m_bufTexture);
 
         RHICmdList.EndRenderPass();
+        LateLatch(*FrameData);
+    }
 
-        TSharedPtr<FRenderStreamUserData, ESPMode::ThreadSafe> FrameData = StaticCastSharedPtr<FRenderStreamUserData>(InUserData);
-        
-        RHICmdList.EnqueueLambda([this, FrameData](FRHICommandListImmediate& RHICmdList) {
-            FRHITexture2D* tex2d2 = m_bufTexture->GetTexture2D();
-            auto point2 = tex2d2->GetSizeXY();
-            void* resource = m_bufTexture->GetTexture2D()->GetNativeResource();
+    FrameData->trace.stamp(LatencyTracer::Stage::Captured);
 
-            auto toggle = FHardwareInfo::GetHardwareInfo(NAME_RHI);
+    RHICmdList.EnqueueLambda([this, FrameData](FRHICommandListImmediate& RHICmdList) {
+        TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamSendTexture);
+        FRHITexture2D* tex2d2 = m_bufTexture->GetTexture2D();
+        auto point2 = tex2d2->GetSizeXY();
+        void* resource = m_bufTexture->GetTexture2D()->GetNativeResource();
 
-            RenderStreamLink::SenderFrameType senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX11_TEXTURE;
-            if (toggle == "D3D11")
-            {
-                senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX11_TEXTURE;
-            }
-            else if (toggle == "D3D12")
-            {
-                senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX12_TEXTURE;
-            }
-            else 
-            {
-                UE_LOG(LogRenderStream, Error, TEXT("RenderStream tried to send frame with unsupported RHI backend."));
-                return;
-            }
+        auto toggle = FHardwareInfo::GetHardwareInfo(NAME_RHI);
 
-            if (resource) 
+        RenderStreamLink::SenderFrameType senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX11_TEXTURE;
+        if (toggle == "D3D11")
+        {
+            senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX11_TEXTURE;
+        }
+        else if (toggle == "D3D12")
+        {
+            senderFrameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_DX12_TEXTURE;
+        }
+        else 
+        {
+            UE_LOG(LogRenderStream, Error, TEXT("RenderStream tried to send frame with unsupported RHI backend."));
+            return;
+        }
+
+        // Texture frames stay on this thread: the shared texture is redrawn every frame, so it must be consumed before the next draw.
+        if (resource) 
+        {
+            if (RenderStreamLink::instance().rs_sendFrame(m_module->m_assetHandle, m_streamHandle, senderFrameType, resource, point2.X, point2.Y, m_fmt, &FrameData->frameData) == RenderStreamLink::RS_ERROR_SUCCESS)
             {
-                RenderStreamLink::instance().rs_sendFrame(m_module->m_assetHandle, m_streamHandle, senderFrameType, resource, point2.X, point2.Y, m_fmt, &FrameData->frameData);
+                FrameData->trace.stamp(LatencyTracer::Stage::Sent);
+                m_module->RecordLatency(FrameData->trace);
             }
-        });
-    }
+        }
+    });
 }
 
 void URenderStreamMediaCapture::OnRHITextureCaptured_RenderingThread(const FCaptureBaseData& InBaseData, TSharedPtr<FMediaCaptureUserData, ESPMode::ThreadSafe> InUserData, FTextureRHIRef InTexture) {
@@ -500,18 +709,97 @@ void URenderStreamMediaCapture::OnFrameCaptured_RenderingThread(const FCaptureBa
     if (m_streamHandle == 0)
         return;
 
-    int frameWidth = Width * WidthMultiplier(m_fmt);
-    int frameHeight = Height * HeightMultiplier(m_fmt);
+    TRACE_CPUPROFILER_EVENT_SCOPE(RenderStreamHostFrame);
+
+    // Width is in pixels when converting on the CPU, in GPU texels otherwise
+    const bool convert = m_cpuConvert;
+    int frameWidth = convert ? Width : Width * WidthMultiplier(m_fmt);
+    // The NDI alpha plane, always converted on the CPU, adds its rows to the height rounded up to a whole row.
+    int frameHeight = convert ? PixelConvert::frameRows(m_fmt, Width, Height) : Height;
 
     TSharedPtr<FRenderStreamUserData, ESPMode::ThreadSafe> FrameData = StaticCastSharedPtr<FRenderStreamUserData>(InUserData);
+    const RenderOnDemand::Decision render = FrameData->render;
+    if (render.action == RenderOnDemand::Action::Skip)
+        return;
+
+    // A resent frame repeats the one kept, what was read back is of a viewport that did not draw the world.
+    const bool resend = render.action == RenderOnDemand::Action::Resend;
+    if (resend && !m_keptValid)
+        return;
+    if (!resend)
+    {
+        m_keptValid = false;
+        LateLatch(*FrameData);
+    }
+    FrameData->trace.stamp(LatencyTracer::Stage::Captured);
+
+    size_t frameBytes = convert ? PixelConvert::frameBytes(m_fmt, Width, Height) : size_t(Width) * size_t(Height) * 4;
+    if (resend)
+    {
+        frameBytes = size_t(m_keptFrame.Num());
+        frameWidth = m_keptWidth;
+        frameHeight = m_keptHeight;
+    }
+
+    if (m_sender)
+    {
+        // The readback buffer is only valid for the duration of this call. Copying it out lets MediaCapture recycle it
+        // straight away, the pooled copy is then owned by the sender until it has been sent.
+        FrameBufferPool::Buffer buffer;
+        if (EnsureHostBuffers(frameBytes))
+            buffer = m_hostBuffers->acquire();
+        if (!buffer)
+            return; // Counted by the pool
+
+        // Converting formats are packed straight into the pooled buffer, still a single pass over the frame.
+        if (resend)
+            FMemory::Memcpy(buffer.data(), m_keptFrame.GetData(), frameBytes);
+        else if (convert)
+            ConvertFrame(InBuffer, Width, Height, buffer.data());
+        else
+            FMemory::Memcpy(buffer.data(), InBuffer, frameBytes);
+        if (render.keep)
+            KeepFrame(buffer.data(), frameBytes, frameWidth, frameHeight);
+
+        FrameSender::Frame frame;
+        frame.frameType = RenderStreamLink::SenderFrameType::RS_FRAMETYPE_HOST_MEMORY;
+        frame.data = buffer.data();
+        frame.buffer = std::move(buffer);
+        frame.width = frameWidth;
+        frame.height = frameHeight;
+        frame.format = m_fmt;
+        frame.response = FrameData->frameData;
+        frame.trace = FrameData->trace;
+        m_sender->enqueue(std::move(frame));
+        return;
+    }
+
+    void* frame = InBuffer;
+    if (resend)
+    {
+        frame = m_keptFrame.GetData();
+    }
+    else if (convert)
+    {
+        m_convertBuffer.SetNumUninitialized(int32(frameBytes), false);
+        ConvertFrame(InBuffer, Width, Height, m_convertBuffer.GetData());
+        frame = m_convertBuffer.GetData();
+    }
+    if (render.keep)
+        KeepFrame(frame, frameBytes, frameWidth, frameHeight);
 
-    RenderStreamLink::instance().rs_sendFrame(m_module->m_assetHandle, m_streamHandle, RenderStreamLink::SenderFrameType::RS_FRAMETYPE_HOST_MEMORY, InBuffer, frameWidth, frameHeight, m_fmt, &FrameData->frameData);
+    if (RenderStreamLink::instance().rs_sendFrame(m_module->m_assetHandle, m_streamHandle, RenderStreamLink::SenderFrameType::RS_FRAMETYPE_HOST_MEMORY, frame, frameWidth, frameHeight, m_fmt, &FrameData->frameData) == RenderStreamLink::RS_ERROR_SUCCESS)
+    {
+        FrameData->trace.stamp(LatencyTracer::Stage::Sent);
+        m_module->RecordLatency(FrameData->trace);
+    }
 }
 
 
 bool URenderStreamMediaCapture::CaptureSceneViewportImpl(TSharedPtr<FSceneViewport>& InSceneViewport)
 {
     FSceneViewport* Viewport = InSceneViewport.Get();
+    m_gameViewport = GEngine && GEngine->GameViewport && GEngine->GameViewport->GetGameViewport() == Viewport ? GEngine->GameViewport : nullptr;
 
     if (!ReadyCapture())
     {
@@ -527,6 +815,7 @@ bool URenderStreamMediaCapture::CaptureSceneViewportImpl(TSharedPtr<FSceneViewpo
 
 bool URenderStreamMediaCapture::CaptureRenderTargetImpl(UTextureRenderTarget2D* InRenderTarget)
 {
+    m_gameViewport = nullptr;
     if (!ReadyCapture())
     {
         UE_LOG(LogRenderStream, Error, TEXT("Unable to start render target capture."));
@@ -551,11 +840,78 @@ bool URenderStreamMediaCapture::ReadyCapture()
 
     m_unitScale = getGlobalUnitEnum();
 
+    URenderStreamMediaOutput* Output = CastChecked<URenderStreamMediaOutput>(MediaOutput);
+    CameraFilter::Settings filter;
+    filter.rejectStale = Output->m_rejectStaleTracking;
+    filter.smooth = Output->m_smoothTracking;
+    filter.minCutoff = Output->m_trackingMinCutoff;
+    filter.beta = Output->m_trackingBeta;
+    m_filter.configure(filter);
+    m_predictor.configure(GetPredictionModel(Output->m_cameraPrediction), double(Output->m_predictionHorizonMs) / 1000.);
+
+    RenderOnDemand::Settings onDemand;
+    onDemand.policy = GetRenderPolicy(Output->m_renderPolicy);
+    onDemand.settleFrames = uint32_t(FMath::Max(Output->m_renderSettleFrames, 0));
+    onDemand.idleRate = FMath::Max(double(Output->m_idleFrameRate), 0.);
+    m_onDemand.configure(onDemand);
+    m_renderDecision = RenderOnDemand::Decision();
+
+    if (Output->m_lateLatchCamera && !m_lateLatch)
+        m_lateLatch = FSceneViewExtensions::NewExtension<FRenderStreamLateLatch>(m_module);
+    if (m_lateLatch)
+    {
+        FRenderStreamLateLatch::Config latch;
+        latch.stream = m_streamHandle;
+        latch.locationReceiver = m_locationReceiver;
+        latch.rotationReceiver = m_rotationReceiver;
+        latch.camera = m_cameraDataReceiver;
+        latch.unitScale = m_unitScale;
+        latch.filter = filter;
+        latch.prediction = m_predictor.model();
+        latch.horizon = m_predictor.horizon();
+        m_lateLatch->Configure(latch);
+        m_lateLatch->SetEnabled(Output->m_lateLatchCamera);
+    }
+
     return true;
 }
 
 void URenderStreamMediaCapture::StopCaptureImpl(bool bAllowPendingFrameToBeProcess)
 {
+    if (m_sender)
+    {
+        // Stop before the stream is destroyed. The sender object itself stays alive as the rendering thread may still hold it.
+        m_sender->stop(bAllowPendingFrameToBeProcess);
+        const FrameSender::Stats stats = m_sender->stats();
+        UE_LOG(LogRenderStream, Log, TEXT("Sender for '%s': %llu frames sent, %llu failed, %llu dropped, max queue depth %llu"),
+            *m_streamName, uint64(stats.sent), uint64(stats.failed), uint64(stats.dropped), uint64(stats.maxDepth));
+        if (m_hostBuffers && m_hostBuffers->exhausted() > 0)
+            UE_LOG(LogRenderStream, Warning, TEXT("Sender for '%s': %llu frames dropped with every host buffer in flight"), *m_streamName, uint64(m_hostBuffers->exhausted()));
+    }
+
+    if (m_lateLatch)
+    {
+        m_lateLatch->SetEnabled(false);
+        const FRenderStreamLateLatch::Stats latch = m_lateLatch->GetStats();
+        UE_LOG(LogRenderStream, Log, TEXT("Late latch for '%s': %llu of %llu views moved to a newer camera"), *m_streamName, uint64(latch.latched), uint64(latch.views));
+    }
+
+    if (m_worldRenderingDisabled)
+    {
+        if (UGameViewportClient* Viewport = m_gameViewport.Get())
+            Viewport->bDisableWorldRendering = false;
+        m_worldRenderingDisabled = false;
+    }
+    const RenderOnDemand::Stats onDemand = m_onDemand.stats();
+    if (onDemand.resent + onDemand.skipped > 0)
+        UE_LOG(LogRenderStream, Log, TEXT("Render on demand for '%s': %llu frames rendered, %llu resent, %llu not sent"),
+            *m_streamName, uint64(onDemand.rendered), uint64(onDemand.resent), uint64(onDemand.skipped));
+
+    const CameraFilter::Stats tracking = m_filter.stats();
+    if (tracking.duplicates + tracking.outOfOrder > 0)
+        UE_LOG(LogRenderStream, Log, TEXT("Tracking for '%s': %llu cameras applied, %llu repeated and %llu out of order ignored"),
+            *m_streamName, uint64(tracking.accepted), uint64(tracking.duplicates), uint64(tracking.outOfOrder));
+
     if (m_streamHandle != 0)
     {
         m_module->RemoveActiveCapture(this);
@@ -569,5 +925,9 @@ TSharedPtr<FMediaCaptureUserData, ESPMode::ThreadSafe> URenderStreamMediaCapture
 {
     TSharedPtr<FRenderStreamUserData, ESPMode::ThreadSafe> newData = MakeShared<FRenderStreamUserData, ESPMode::ThreadSafe>();
     newData->frameData = m_frameResponseData;
+    newData->trace = m_frameTrace;
+    newData->trace.stamp(LatencyTracer::Stage::UserData);
+    newData->frameNumber = GFrameNumber;
+    newData->render = m_renderDecision;
     return newData;
 }
@@ -49,6 +49,7 @@ EPixelFormat URenderStreamMediaOutput::GetRequestedPixelFormat () const
 	{
 	case ERenderStreamMediaOutputFormat::BGRA: 
 	case ERenderStreamMediaOutputFormat::YUV422:
+	case ERenderStreamMediaOutputFormat::YUV422_ALPHA:
         return PF_B8G8R8A8;
 
 	default:
@@ -60,22 +61,49 @@ EMediaCaptureConversionOperation URenderStreamMediaOutput::GetConversionOperatio
 {
 	switch (m_outputFormat)
 	{
-	case ERenderStreamMediaOutputFormat::YUV422: return EMediaCaptureConversionOperation::RGBA8_TO_YUV_8BIT;
+	case ERenderStreamMediaOutputFormat::YUV422:
+		// Premultiplying changes the colour, so it has to happen before the GPU drops alpha
+		return ConvertsOnCPU() ? EMediaCaptureConversionOperation::NONE : EMediaCaptureConversionOperation::RGBA8_TO_YUV_8BIT;
 
 	case ERenderStreamMediaOutputFormat::BGRA:
 	//case ERenderStreamMediaOutputFormat::RGBA:
-		switch (m_alphatype) 
+		if (!ConvertsOnCPU())
 		{
-		case ERenderStreamAlphaType::INVERT: return EMediaCaptureConversionOperation::INVERT_ALPHA;
-		case ERenderStreamAlphaType::SET_ONE: return EMediaCaptureConversionOperation::SET_ALPHA_ONE;
-		default:
-			return EMediaCaptureConversionOperation::NONE;
+			switch (m_alphatype)
+			{
+			case ERenderStreamAlphaType::INVERT: return EMediaCaptureConversionOperation::INVERT_ALPHA;
+			case ERenderStreamAlphaType::SET_ONE: return EMediaCaptureConversionOperation::SET_ALPHA_ONE;
+			default:
+				return EMediaCaptureConversionOperation::NONE;
+			}
 		}
+		// The alpha operation is fused into the CPU pass that copies the readback into a pooled buffer
+		return EMediaCaptureConversionOperation::NONE;
+
+	case ERenderStreamMediaOutputFormat::YUV422_ALPHA:
+		// Read back as BGRA and packed on the CPU, which applies the alpha operation in the same pass
+		return EMediaCaptureConversionOperation::NONE;
+
 	default:
 		return EMediaCaptureConversionOperation::CUSTOM;
 	}
 }
 
+bool URenderStreamMediaOutput::ConvertsOnCPU () const
+{
+	switch (m_outputFormat)
+	{
+	case ERenderStreamMediaOutputFormat::YUV422_ALPHA: return true;
+	case ERenderStreamMediaOutputFormat::BGRA:
+		// Inverting and setting alpha are free on the GPU. They only move to the CPU where the frame is copied out
+		// for the send thread anyway, inline that would add a pass over the frame on the rendering thread.
+		return m_alphatype == ERenderStreamAlphaType::PREMULTIPLY || m_alphatype == ERenderStreamAlphaType::UNPREMULTIPLY
+			|| (m_asyncSend && m_alphatype != ERenderStreamAlphaType::NO_ACTION);
+	case ERenderStreamMediaOutputFormat::YUV422: return m_alphatype == ERenderStreamAlphaType::PREMULTIPLY || m_alphatype == ERenderStreamAlphaType::UNPREMULTIPLY;
+	default: return false;
+	}
+}
+
 
 UMediaCapture* URenderStreamMediaOutput::CreateMediaCaptureImpl ()
 {
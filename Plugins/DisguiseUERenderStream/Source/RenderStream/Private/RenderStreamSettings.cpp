@@ -3,5 +3,18 @@
 URenderStreamSettings::URenderStreamSettings(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
     , bGenerateScenesFromLevels(bGenerateScenesFromLevelsDefault)
+    , bWriteCompiledSchema(bWriteCompiledSchemaDefault)
+    , ConversionThreads(ConversionThreadsDefault)
+    , ConversionAffinityMask(ConversionAffinityMaskDefault)
+    , bFrameLock(bFrameLockDefault)
+    , FrameLockTimeoutMs(FrameLockTimeoutMsDefault)
+    , ParameterInterpolation(ParameterInterpolationDefault)
+    , SceneResidencyBudgetMB(SceneResidencyBudgetMBDefault)
+    , bDynamicResolution(bDynamicResolutionDefault)
+    , DynamicResolutionMinPercent(DynamicResolutionMinPercentDefault)
+    , DynamicResolutionMaxPercent(DynamicResolutionMaxPercentDefault)
+    , DynamicResolutionBudgetPercent(DynamicResolutionBudgetPercentDefault)
+    , DynamicResolutionHysteresisPercent(DynamicResolutionHysteresisPercentDefault)
+    , DynamicResolutionRaiseFrames(DynamicResolutionRaiseFramesDefault)
 {
 }
\ No newline at end of file
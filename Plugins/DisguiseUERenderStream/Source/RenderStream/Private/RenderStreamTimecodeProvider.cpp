@@ -18,7 +18,10 @@ FQualifiedFrameTime URenderStreamTimecodeProvider::GetQualifiedFrameTime() const
 
         const FTimecode timecode(Module->m_frameData.localTime, d3RenderRate, false);
 
-        LastTime = FQualifiedFrameTime(timecode, d3RenderRate);
+        // Between d3's frames, when the engine ticks faster, the part of the next frame the engine is into.
+        const FFrameNumber frame = FQualifiedFrameTime(timecode, d3RenderRate).Time.GetFrame();
+        const float subFrame = FMath::Min(float(Module->SubFrame()), 0.999f);
+        LastTime = FQualifiedFrameTime(FFrameTime(frame, subFrame), d3RenderRate);
     }
 
     // Always return a valid time. If we have dropped a frame, or the d3 server has, we want to stay somewhere
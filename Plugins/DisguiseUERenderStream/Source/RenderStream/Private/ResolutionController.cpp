@@ -0,0 +1,89 @@
+#include "ResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Weight of each new frame in the smoothed cost.
+    const double Smoothing = 0.25;
+
+    // Scales are kept to whole percent, the engine's screen percentage.
+    double quantise(double scale) { return std::round(scale * 100.) / 100.; }
+}
+
+void ResolutionController::configure(const Settings& settings)
+{
+    m_settings = settings;
+    m_settings.maxScale = std::max(m_settings.maxScale, m_settings.minScale);
+    m_scale = std::min(std::max(m_scale, m_settings.minScale), m_settings.maxScale);
+}
+
+void ResolutionController::reset()
+{
+    m_scale = m_settings.maxScale;
+    m_cost = 0.;
+    m_send = 0.;
+    m_load = 0.;
+    m_over = 0;
+    m_under = 0;
+    m_hold = 0;
+    m_sendBound = false;
+}
+
+bool ResolutionController::update(const Sample& sample)
+{
+    if (sample.period <= 0.)
+        return false;
+
+    const double cost = std::max(sample.gpu, sample.renderThread);
+    m_cost = m_cost > 0. ? m_cost + (cost - m_cost) * Smoothing : cost;
+    m_send = m_send > 0. ? m_send + (sample.send - m_send) * Smoothing : sample.send;
+
+    const double budget = m_settings.budget * sample.period;
+    const double lower = std::max(m_settings.budget - m_settings.hysteresis, 0.) * sample.period;
+    m_load = budget > 0. ? m_cost / budget : 0.;
+    m_sendBound = m_send > budget;
+
+    if (m_hold > 0)
+    {
+        --m_hold;
+        return false;
+    }
+
+    // Aims for the middle of the band between raising and lowering.
+    const double target = (budget + lower) / 2.;
+    if (m_cost > budget)
+    {
+        m_under = 0;
+        if (++m_over < m_settings.lowerFrames)
+            return false;
+        m_over = 0;
+        return setScale(m_scale * std::sqrt(target / m_cost));
+    }
+    if (m_cost < lower && m_cost > 0.)
+    {
+        m_over = 0;
+        if (++m_under < m_settings.raiseFrames)
+            return false;
+        m_under = 0;
+        return setScale(std::min(m_scale * std::sqrt(target / m_cost), m_scale + m_settings.maxRaise));
+    }
+    m_over = 0;
+    m_under = 0;
+    return false;
+}
+
+bool ResolutionController::setScale(double scale)
+{
+    const double next = std::min(std::max(quantise(scale), m_settings.minScale), m_settings.maxScale);
+    if (std::fabs(next - m_scale) < 0.005)
+        return false;
+
+    ++(next < m_scale ? m_stats.lowered : m_stats.raised);
+    // Until the GPU time catches up, the cost is what the new scale is expected to give.
+    m_cost *= (next * next) / (m_scale * m_scale);
+    m_scale = next;
+    m_hold = HoldFrames;
+    return true;
+}
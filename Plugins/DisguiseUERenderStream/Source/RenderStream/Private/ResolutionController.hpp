@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+// Keeps the engine's frame inside d3's frame period by scaling the resolution the scene renders at, which the engine
+// then upscales to the fixed stream size. The cost of a frame is the slower of the GPU and the rendering thread, taken
+// to scale with the pixels rendered, so with the square of the scale. Over budget the scale drops straight to where
+// the cost is expected to fit. Well under it, the scale only rises after holding there for a while, and by a limited
+// step, so that it settles rather than oscillates. Times are in seconds.
+class ResolutionController
+{
+public:
+    static constexpr int HoldFrames = 4;        // Samples ignored after a change, the GPU time lags the frame
+
+    struct Settings
+    {
+        double minScale = 0.5;
+        double maxScale = 1.;
+        double budget = 0.9;            // Of d3's frame period the frame may take
+        double hysteresis = 0.15;       // Of the period below the budget before the scale rises
+        int lowerFrames = 3;            // Over budget in a row before the scale drops
+        int raiseFrames = 30;           // Below the band in a row before the scale rises
+        double maxRaise = 0.1;          // Largest rise in one step
+    };
+
+    struct Sample
+    {
+        double period = 0.;             // d3's frame period
+        double gpu = 0.;
+        double renderThread = 0.;
+        double send = 0.;               // From capture until rs_sendFrame returned
+    };
+
+    struct Stats
+    {
+        uint64_t lowered = 0;
+        uint64_t raised = 0;
+    };
+
+    // Keeps the current scale within the new bounds.
+    void configure(const Settings& settings);
+    // Back to the largest scale.
+    void reset();
+
+    // Returns true when the scale changed.
+    bool update(const Sample& sample);
+
+    double scale() const { return m_scale; }
+    // Smoothed cost of a frame over the budget, above 1 when over it.
+    double load() const { return m_load; }
+    // Sending alone takes longer than the budget, which no resolution can help.
+    bool sendBound() const { return m_sendBound; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    bool setScale(double scale);
+
+    Settings m_settings;
+    double m_scale = 1.;
+    double m_cost = 0.;
+    double m_send = 0.;
+    double m_load = 0.;
+    int m_over = 0;
+    int m_under = 0;
+    int m_hold = 0;
+    bool m_sendBound = false;
+    Stats m_stats;
+};
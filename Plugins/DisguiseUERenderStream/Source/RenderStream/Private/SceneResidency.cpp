@@ -0,0 +1,66 @@
+#include "SceneResidency.hpp"
+
+#include <algorithm>
+
+void SceneResidency::setScenes(const std::vector<uint64_t>& costs)
+{
+    m_scenes.resize(costs.size());
+    for (size_t i = 0; i < costs.size(); ++i)
+        m_scenes[i].cost = costs[i];
+    if (m_shown != NoScene && m_shown >= m_scenes.size())
+        m_shown = NoScene;
+    m_dirty = true;
+}
+
+void SceneResidency::touch(size_t scene)
+{
+    if (scene >= m_scenes.size())
+        return;
+    m_scenes[scene].used = ++m_tick;
+    m_dirty = true;
+}
+
+void SceneResidency::show(size_t scene)
+{
+    // Called every frame, only a switch changes the order.
+    if (scene == m_shown)
+        return;
+    m_shown = scene < m_scenes.size() ? scene : NoScene;
+    touch(scene);
+}
+
+void SceneResidency::hint(size_t scene)
+{
+    touch(scene);
+}
+
+bool SceneResidency::update()
+{
+    if (!m_dirty)
+        return false;
+    m_dirty = false;
+
+    m_order.clear();
+    for (size_t i = 0; i < m_scenes.size(); ++i)
+        m_order.push_back(i);
+    std::stable_sort(m_order.begin(), m_order.end(), [this](size_t a, size_t b)
+    {
+        if ((a == m_shown) != (b == m_shown))
+            return a == m_shown;
+        return m_scenes[a].used > m_scenes[b].used;
+    });
+
+    // A scene that does not fit is skipped rather than ending the pass, so smaller ones behind it may still fit.
+    bool changed = false;
+    m_residentCost = 0;
+    for (size_t i : m_order)
+    {
+        Scene& scene = m_scenes[i];
+        const bool resident = i == m_shown || (m_budget > 0 && m_residentCost + scene.cost <= m_budget);
+        if (resident)
+            m_residentCost += scene.cost;
+        changed |= resident != scene.resident;
+        scene.resident = resident;
+    }
+    return changed;
+}
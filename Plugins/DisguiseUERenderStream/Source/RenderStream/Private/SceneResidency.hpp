@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decides which scene levels stay loaded, so that switching scene only has to make a loaded level visible. The scene
+// d3 shows is always resident. The others are kept loaded but hidden in order of when they were last shown or hinted,
+// then in schema order, while their estimated size fits the budget, so the least recently used go first.
+class SceneResidency
+{
+public:
+    static constexpr size_t NoScene = size_t(-1);
+
+    // Indexed like the schema's scenes, cost is the estimated size of each loaded, 0 for scenes without a level of
+    // their own. The history of scenes that keep their index is kept.
+    void setScenes(const std::vector<uint64_t>& costs);
+    void setBudget(uint64_t bytes) { m_budget = bytes; }
+
+    void show(size_t scene);
+    // Makes the scene as recent as the one shown, for a switch that is expected soon.
+    void hint(size_t scene);
+
+    // Recomputes the resident set, true when it changed since the last call.
+    bool update();
+
+    size_t sceneCount() const { return m_scenes.size(); }
+    bool resident(size_t scene) const { return scene < m_scenes.size() && m_scenes[scene].resident; }
+    uint64_t residentCost() const { return m_residentCost; }
+    uint64_t budget() const { return m_budget; }
+
+private:
+    struct Scene
+    {
+        uint64_t cost = 0;
+        uint64_t used = 0;      // Tick last shown or hinted, 0 for never
+        bool resident = false;
+    };
+
+    void touch(size_t scene);
+
+    std::vector<Scene> m_scenes;
+    std::vector<size_t> m_order;    // Reused by update
+    size_t m_shown = NoScene;
+    uint64_t m_tick = 0;
+    uint64_t m_budget = 0;
+    uint64_t m_residentCost = 0;
+    bool m_dirty = true;
+};
@@ -0,0 +1,65 @@
+#include "SceneSwitch.hpp"
+
+void SceneSwitch::setScenes(const std::vector<size_t>& levelOfScene, size_t levelCount)
+{
+    if (m_state != State::Idle && levelOfScene == m_levelOfScene && levelCount == m_levelCount)
+        return;
+
+    m_levelOfScene = levelOfScene;
+    m_levelCount = levelCount;
+    const size_t words = (levelCount + 63) / 64;
+    m_masks.assign(levelOfScene.size(), std::vector<uint64_t>(words, 0));
+    for (size_t i = 0; i < levelOfScene.size(); ++i)
+    {
+        if (levelOfScene[i] < levelCount)
+            setBit(m_masks[i], levelOfScene[i]);
+    }
+
+    m_visible.assign(words, ~uint64_t(0));
+    if (levelCount & 63)
+        m_visible.back() = (uint64_t(1) << (levelCount & 63)) - 1;
+    m_scene = NoScene;
+    m_state = State::Idle;
+}
+
+bool SceneSwitch::select(size_t scene, int64_t now, std::vector<size_t>& hide)
+{
+    hide.clear();
+    if (scene == m_scene || scene >= m_masks.size())
+        return false;
+
+    m_scene = scene;
+    m_switchedAt = now;
+    const std::vector<uint64_t>& target = m_masks[scene];
+    for (size_t word = 0; word < m_visible.size(); ++word)
+    {
+        uint64_t bits = m_visible[word] & ~target[word];
+        m_visible[word] &= target[word];
+        for (; bits; bits &= bits - 1)
+        {
+            unsigned bit = 0;
+            while (!((bits >> bit) & 1))
+                ++bit;
+            hide.push_back(word * 64 + bit);
+        }
+    }
+    m_state = level() == NoLevel ? State::Showing : State::Waiting;
+    return true;
+}
+
+bool SceneSwitch::show()
+{
+    if (m_state != State::Waiting)
+        return false;
+    setBit(m_visible, level());
+    m_state = State::Showing;
+    return true;
+}
+
+int64_t SceneSwitch::shown(int64_t now)
+{
+    if (m_state != State::Showing)
+        return -1;
+    m_state = State::Shown;
+    return now - m_switchedAt;
+}
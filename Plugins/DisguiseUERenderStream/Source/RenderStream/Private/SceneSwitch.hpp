@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Follows d3 switching between scenes, so that streaming levels only change visibility on a switch. Each scene has a
+// precomputed mask over the world's streaming levels with the bit of its own level set, and the levels last asked to
+// be visible are kept as another, so a switch hides exactly the levels that differ.
+//
+//   Idle --select--> Waiting --show--> Showing --shown--> Shown
+//
+// Waiting covers the scene's level loading and its schema being validated. A scene without a level of its own only
+// hides the others, so it goes straight to Showing.
+class SceneSwitch
+{
+public:
+    static constexpr size_t NoScene = size_t(-1);
+    static constexpr size_t NoLevel = size_t(-1);
+
+    enum class State { Idle, Waiting, Showing, Shown };
+
+    // levelOfScene holds the index of each scene's streaming level among levelCount, or NoLevel. Unless they are
+    // unchanged the switch goes back to Idle, and as the visibility of every level is then unknown, the next switch
+    // hides all but the scene's own.
+    void setScenes(const std::vector<size_t>& levelOfScene, size_t levelCount);
+
+    // Starts a switch when scene is not the current one, filling hide with the levels to hide. Returns whether it did.
+    bool select(size_t scene, int64_t now, std::vector<size_t>& hide);
+    // Once the scene's level is loaded and validated, true the first time, when it has to be made visible.
+    bool show();
+    // The level is visible, or there is none. Returns the time the switch took, -1 unless it was Showing.
+    int64_t shown(int64_t now);
+
+    State state() const { return m_state; }
+    size_t scene() const { return m_scene; }
+    size_t level() const { return m_scene < m_levelOfScene.size() ? m_levelOfScene[m_scene] : NoLevel; }
+
+private:
+    static void setBit(std::vector<uint64_t>& mask, size_t bit) { mask[bit >> 6] |= uint64_t(1) << (bit & 63); }
+
+    std::vector<size_t> m_levelOfScene;
+    std::vector<std::vector<uint64_t>> m_masks;    // Per scene
+    std::vector<uint64_t> m_visible;                // Levels last asked to be visible
+    size_t m_levelCount = 0;
+    size_t m_scene = NoScene;
+    State m_state = State::Idle;
+    int64_t m_switchedAt = 0;
+};
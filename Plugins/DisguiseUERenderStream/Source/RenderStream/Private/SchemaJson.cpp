@@ -0,0 +1,567 @@
+#include "SchemaJson.hpp"
+#include "fnv.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    bool equals(const char* value, size_t size, const char* literal)
+    {
+        return std::strlen(literal) == size && std::memcmp(value, literal, size) == 0;
+    }
+
+    void appendUtf8(std::string& out, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += char(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += char(0xc0 | (codePoint >> 6));
+            out += char(0x80 | (codePoint & 0x3f));
+        }
+        else if (codePoint < 0x10000)
+        {
+            out += char(0xe0 | (codePoint >> 12));
+            out += char(0x80 | ((codePoint >> 6) & 0x3f));
+            out += char(0x80 | (codePoint & 0x3f));
+        }
+        else
+        {
+            out += char(0xf0 | (codePoint >> 18));
+            out += char(0x80 | ((codePoint >> 12) & 0x3f));
+            out += char(0x80 | ((codePoint >> 6) & 0x3f));
+            out += char(0x80 | (codePoint & 0x3f));
+        }
+    }
+
+    int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+}
+
+void SchemaWriter::clear()
+{
+    m_text.clear();
+    m_separate = false;
+    m_parameterCount = 0;
+}
+
+void SchemaWriter::separate()
+{
+    if (m_separate)
+        m_text += ',';
+    m_separate = true;
+}
+
+void SchemaWriter::string(const char* value)
+{
+    static const char Hex[] = "0123456789abcdef";
+    m_text += '"';
+    for (const char* p = value; *p; ++p)
+    {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\')
+        {
+            m_text += '\\';
+            m_text += char(c);
+        }
+        else if (c < 0x20)
+        {
+            m_text += "\\u00";
+            m_text += Hex[c >> 4];
+            m_text += Hex[c & 0xf];
+        }
+        else
+        {
+            m_text += char(c);
+        }
+    }
+    m_text += '"';
+}
+
+void SchemaWriter::number(float value)
+{
+    // Nine significant digits read back as the same float. JSON has no infinities or NaNs.
+    char buffer[32];
+    const int length = std::isfinite(value) ? std::snprintf(buffer, sizeof(buffer), "%.9g", double(value)) : std::snprintf(buffer, sizeof(buffer), "0");
+    m_text.append(buffer, size_t(length));
+}
+
+void SchemaWriter::integer(int64_t value)
+{
+    char buffer[24];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+    m_text.append(buffer, size_t(length));
+}
+
+void SchemaWriter::beginSchemas()
+{
+    separate();
+    m_text += '[';
+    m_separate = false;
+}
+
+void SchemaWriter::endSchemas()
+{
+    m_text += ']';
+    m_separate = true;
+}
+
+void SchemaWriter::beginScene(const char* name)
+{
+    separate();
+    m_text += "{\"name\":";
+    string(name);
+    m_text += ",\"parameters\":[";
+    m_separate = false;
+}
+
+void SchemaWriter::parameters(const std::string& written)
+{
+    if (written.empty())
+        return;
+    separate();
+    m_text += written;
+}
+
+void SchemaWriter::endScene(uint32_t nPersistentParameters, uint32_t nLevelParameters)
+{
+    m_text += "],\"nPersistentParameters\":";
+    integer(nPersistentParameters);
+    m_text += ",\"nLevelParameters\":";
+    integer(nLevelParameters);
+    m_text += '}';
+    m_separate = true;
+}
+
+void SchemaWriter::beginParameter(const SchemaParameter& parameter)
+{
+    ++m_parameterCount;
+    separate();
+    m_text += "{\"group\":";
+    string(parameter.group);
+    m_text += ",\"displayName\":";
+    string(parameter.displayName);
+    m_text += ",\"key\":";
+    string(parameter.key);
+    m_text += ",\"min\":";
+    number(parameter.min);
+    m_text += ",\"max\":";
+    number(parameter.max);
+    m_text += ",\"step\":";
+    number(parameter.step);
+    m_text += ",\"defaultValue\":";
+    number(parameter.defaultValue);
+    m_text += ",\"dmxOffset\":";
+    integer(parameter.dmxOffset);
+    m_text += ",\"dmxType\":";
+    integer(parameter.dmxType);
+    m_text += ",\"options\":[";
+    m_separate = false;
+}
+
+void SchemaWriter::option(const char* option)
+{
+    separate();
+    string(option);
+}
+
+void SchemaWriter::endParameter()
+{
+    m_text += "]}";
+    m_separate = true;
+}
+
+bool SchemaReader::fail(const char* error)
+{
+    if (!m_error)
+    {
+        m_error = error;
+        m_errorOffset = size_t(m_p - m_begin);
+    }
+    return false;
+}
+
+void SchemaReader::whitespace()
+{
+    while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+        ++m_p;
+}
+
+bool SchemaReader::consume(char c)
+{
+    whitespace();
+    if (m_p < m_end && *m_p == c)
+    {
+        ++m_p;
+        return true;
+    }
+    return false;
+}
+
+bool SchemaReader::readString(const char*& value, size_t& size)
+{
+    if (!consume('"'))
+        return fail("Expected a string");
+
+    // Strings without escapes, which is all of them in a generated schema, are returned in place.
+    const char* begin = m_p;
+    while (m_p < m_end && *m_p != '"' && *m_p != '\\')
+        ++m_p;
+    if (m_p == m_end)
+        return fail("Unterminated string");
+    if (*m_p == '"')
+    {
+        value = begin;
+        size = size_t(m_p - begin);
+        ++m_p;
+        return true;
+    }
+
+    m_unescaped.assign(begin, size_t(m_p - begin));
+    while (m_p < m_end && *m_p != '"')
+    {
+        if (*m_p != '\\')
+        {
+            m_unescaped += *m_p++;
+            continue;
+        }
+        if (++m_p == m_end)
+            break;
+        const char escape = *m_p++;
+        switch (escape)
+        {
+        case '"': m_unescaped += '"'; break;
+        case '\\': m_unescaped += '\\'; break;
+        case '/': m_unescaped += '/'; break;
+        case 'b': m_unescaped += '\b'; break;
+        case 'f': m_unescaped += '\f'; break;
+        case 'n': m_unescaped += '\n'; break;
+        case 'r': m_unescaped += '\r'; break;
+        case 't': m_unescaped += '\t'; break;
+        case 'u':
+        {
+            uint32_t codePoint = 0;
+            for (int units = 0; units < 2; ++units)
+            {
+                if (m_end - m_p < 4)
+                    return fail("Truncated unicode escape");
+                uint32_t unit = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    const int digit = hexDigit(m_p[i]);
+                    if (digit < 0)
+                        return fail("Invalid unicode escape");
+                    unit = (unit << 4) | uint32_t(digit);
+                }
+                m_p += 4;
+                if (units == 0)
+                {
+                    codePoint = unit;
+                    // A high surrogate is followed by the escaped low surrogate.
+                    if (unit < 0xd800 || unit > 0xdbff)
+                        break;
+                    if (m_end - m_p < 2 || m_p[0] != '\\' || m_p[1] != 'u')
+                        return fail("Unpaired surrogate");
+                    m_p += 2;
+                }
+                else
+                {
+                    if (unit < 0xdc00 || unit > 0xdfff)
+                        return fail("Unpaired surrogate");
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (unit - 0xdc00);
+                }
+            }
+            appendUtf8(m_unescaped, codePoint);
+            break;
+        }
+        default:
+            return fail("Invalid escape");
+        }
+    }
+    if (m_p >= m_end)
+        return fail("Unterminated string");
+    ++m_p;
+    value = m_unescaped.data();
+    size = m_unescaped.size();
+    return true;
+}
+
+bool SchemaReader::scanNumber(double* value)
+{
+    whitespace();
+    const char* p = m_p;
+    const bool negative = p < m_end && *p == '-';
+    if (negative)
+        ++p;
+    if (p == m_end || *p < '0' || *p > '9')
+        return fail("Expected a number");
+
+    double mantissa = 0.;
+    while (p < m_end && *p >= '0' && *p <= '9')
+        mantissa = mantissa * 10. + double(*p++ - '0');
+    int exponent = 0;
+    if (p < m_end && *p == '.')
+    {
+        ++p;
+        if (p == m_end || *p < '0' || *p > '9')
+            return fail("Expected a digit");
+        while (p < m_end && *p >= '0' && *p <= '9')
+        {
+            mantissa = mantissa * 10. + double(*p++ - '0');
+            --exponent;
+        }
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        const bool negativeExponent = p < m_end && *p == '-';
+        if (p < m_end && (*p == '+' || *p == '-'))
+            ++p;
+        if (p == m_end || *p < '0' || *p > '9')
+            return fail("Expected a digit");
+        int e = 0;
+        for (; p < m_end && *p >= '0' && *p <= '9'; ++p)
+        {
+            if (e < 100000)
+                e = e * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    m_p = p;
+
+    // Only counts are read as numbers, which this is exact for. Other numbers are skipped.
+    if (value)
+        *value = (negative ? -mantissa : mantissa) * std::pow(10., double(exponent));
+    return true;
+}
+
+bool SchemaReader::readCount(uint32_t& value)
+{
+    double number;
+    if (!scanNumber(&number))
+        return false;
+    if (!(number >= 0.) || number > double(UINT32_MAX) || number != std::floor(number))
+        return fail("Expected a count");
+    value = uint32_t(number);
+    return true;
+}
+
+bool SchemaReader::skipMemberName()
+{
+    const char* member;
+    size_t memberSize;
+    if (!readString(member, memberSize) || !consume(':'))
+        return fail("Expected a member");
+    return true;
+}
+
+bool SchemaReader::skipValue()
+{
+    // Iterative, so that deeply nested values cannot exhaust the stack. m_open holds the containers still open.
+    m_open.clear();
+    for (;;)
+    {
+        whitespace();
+        if (m_p == m_end)
+            return fail("Unexpected end of schema");
+        const char c = *m_p;
+        if (c == '"')
+        {
+            const char* value;
+            size_t size;
+            if (!readString(value, size))
+                return false;
+        }
+        else if (c == '{' || c == '[')
+        {
+            ++m_p;
+            if (!consume(c == '{' ? '}' : ']'))
+            {
+                m_open += c;
+                if (c == '{' && !skipMemberName())
+                    return false;
+                continue;
+            }
+        }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            if (!scanNumber(nullptr))
+                return false;
+        }
+        else if (m_end - m_p >= 4 && (std::memcmp(m_p, "true", 4) == 0 || std::memcmp(m_p, "null", 4) == 0))
+        {
+            m_p += 4;
+        }
+        else if (m_end - m_p >= 5 && std::memcmp(m_p, "false", 5) == 0)
+        {
+            m_p += 5;
+        }
+        else
+        {
+            return fail(c == '}' || c == ']' || c == ',' || c == ':' ? "Expected a value" : "Unexpected character");
+        }
+
+        // A value is complete. Close the containers it completes, up to one that continues with another value.
+        for (;;)
+        {
+            if (m_open.empty())
+                return true;
+            const bool object = m_open.back() == '{';
+            if (consume(','))
+            {
+                if (object && !skipMemberName())
+                    return false;
+                break;
+            }
+            if (!consume(object ? '}' : ']'))
+                return fail(object ? "Expected , or }" : "Expected , or ]");
+            m_open.pop_back();
+        }
+    }
+}
+
+bool SchemaReader::readParameters(Handler& handler, StreamFNV& fnv)
+{
+    if (!consume('['))
+        return fail("Expected an array of parameters");
+    if (consume(']'))
+        return true;
+    do
+    {
+        if (!consume('{'))
+            return fail("Non-object parameter");
+        bool hasKey = false;
+        if (!consume('}'))
+        {
+            do
+            {
+                const char* member;
+                size_t memberSize;
+                if (!readString(member, memberSize) || !consume(':'))
+                    return fail("Expected a member");
+                if (equals(member, memberSize, "key"))
+                {
+                    const char* key;
+                    size_t keySize;
+                    if (!readString(key, keySize))
+                        return false;
+                    fnv.addData(reinterpret_cast<const unsigned char*>(key), keySize);
+                    handler.key(key, keySize);
+                    hasKey = true;
+                }
+                else if (!skipValue())
+                {
+                    return false;
+                }
+            } while (consume(','));
+            if (!consume('}'))
+                return fail("Expected , or }");
+        }
+        if (!hasKey)
+            return fail("Parameter without a key");
+    } while (consume(','));
+    if (!consume(']'))
+        return fail("Expected , or ]");
+    return true;
+}
+
+bool SchemaReader::readScene(Handler& handler)
+{
+    if (!consume('{'))
+        return fail("Non-object schema");
+
+    handler.beginScene();
+    StreamFNV fnv;
+    m_name.clear();
+    uint32_t nPersistentParameters = 0;
+    uint32_t nLevelParameters = 0;
+    bool hasPersistent = false;
+    bool hasLevel = false;
+    if (!consume('}'))
+    {
+        do
+        {
+            const char* member;
+            size_t memberSize;
+            if (!readString(member, memberSize) || !consume(':'))
+                return fail("Expected a member");
+            if (equals(member, memberSize, "name"))
+            {
+                const char* name;
+                size_t nameSize;
+                if (!readString(name, nameSize))
+                    return false;
+                m_name.assign(name, nameSize);
+            }
+            else if (equals(member, memberSize, "parameters"))
+            {
+                if (!readParameters(handler, fnv))
+                    return false;
+            }
+            else if (equals(member, memberSize, "nPersistentParameters"))
+            {
+                if (!readCount(nPersistentParameters))
+                    return false;
+                hasPersistent = true;
+            }
+            else if (equals(member, memberSize, "nLevelParameters"))
+            {
+                if (!readCount(nLevelParameters))
+                    return false;
+                hasLevel = true;
+            }
+            else if (!skipValue())
+            {
+                return false;
+            }
+        } while (consume(','));
+        if (!consume('}'))
+            return fail("Expected , or }");
+    }
+    if (!hasPersistent || !hasLevel)
+        return fail("Missing supplementary fields in schema.json. Rebuild schema by opening project in Editor.");
+
+    handler.endScene(m_name.data(), m_name.size(), nPersistentParameters, nLevelParameters, fnv.getHash());
+    return true;
+}
+
+bool SchemaReader::read(const char* text, size_t size, Handler& handler)
+{
+    m_begin = text;
+    m_p = text;
+    m_end = text + size;
+    m_error = nullptr;
+    m_errorOffset = 0;
+
+    if (size >= 3 && std::memcmp(text, "\xef\xbb\xbf", 3) == 0)
+        m_p += 3;
+
+    if (!consume('['))
+        return fail("Expected an array of scenes");
+    if (!consume(']'))
+    {
+        do
+        {
+            if (!readScene(handler))
+                return false;
+        } while (consume(','));
+        if (!consume(']'))
+            return fail("Expected , or ]");
+    }
+    whitespace();
+    if (m_p != m_end)
+        return fail("Trailing characters after schema");
+    return true;
+}
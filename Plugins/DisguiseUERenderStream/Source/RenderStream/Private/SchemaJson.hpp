@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared with the editor module, which writes the schema.
+#ifndef RENDERSTREAM_API
+#define RENDERSTREAM_API
+#endif
+
+class StreamFNV;
+
+// Streaming reader and writer for schema.json, an array of scenes:
+//   [{"name": "...", "parameters": [{"group", "displayName", "key", "min", "max", "step", "defaultValue", "options",
+//     "dmxOffset", "dmxType"}, ...], "nPersistentParameters": n, "nLevelParameters": n}, ...]
+// Neither builds a document. The reader hands keys to a handler as views into the text, or into one reused buffer
+// when they contain escapes, and hashes them as it goes. The writer appends UTF-8 to a string reused between schemas.
+
+struct SchemaParameter
+{
+    const char* group = "";
+    const char* displayName = "";
+    const char* key = "";
+    float min = 0.f;
+    float max = 1.f;
+    float step = 1.f;
+    float defaultValue = 0.f;
+    int dmxOffset = -1;
+    int dmxType = 2;    // Dmx16LittleEndian
+};
+
+class RENDERSTREAM_API SchemaWriter
+{
+public:
+    void clear();   // Keeps the capacity
+    const std::string& text() const { return m_text; }
+    uint32_t parameterCount() const { return m_parameterCount; }    // Written by beginParameter since clear
+
+    void beginSchemas();
+    void endSchemas();
+
+    void beginScene(const char* name);
+    // Appends parameters written by another writer that wrote nothing else.
+    void parameters(const std::string& written);
+    void endScene(uint32_t nPersistentParameters, uint32_t nLevelParameters);
+
+    // Options, if any, are written between beginParameter and endParameter.
+    void beginParameter(const SchemaParameter& parameter);
+    void option(const char* option);
+    void endParameter();
+
+private:
+    void separate();
+    void string(const char* value);
+    void number(float value);
+    void integer(int64_t value);
+
+    std::string m_text;
+    bool m_separate = false;    // The next value follows another in the same array or object
+    uint32_t m_parameterCount = 0;
+};
+
+class RENDERSTREAM_API SchemaReader
+{
+public:
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+        virtual void beginScene() = 0;
+        // Each parameter key in order. The view is only valid during the call.
+        virtual void key(const char* key, size_t size) = 0;
+        // hash is StreamFNV of every key of the scene, the schema hash d3 computes when all of them are in use.
+        virtual void endScene(const char* name, size_t nameSize, uint32_t nPersistentParameters, uint32_t nLevelParameters, uint64_t hash) = 0;
+    };
+
+    // False when text is not a schema, with error() and errorOffset() saying why and where. Scenes before the error
+    // have been handed to handler.
+    bool read(const char* text, size_t size, Handler& handler);
+
+    const char* error() const { return m_error; }
+    size_t errorOffset() const { return m_errorOffset; }
+
+private:
+    bool fail(const char* error);
+    void whitespace();
+    bool consume(char c);
+    bool readString(const char*& value, size_t& size);
+    bool readCount(uint32_t& value);
+    bool scanNumber(double* value);
+    bool skipMemberName();
+    bool skipValue();
+    bool readScene(Handler& handler);
+    bool readParameters(Handler& handler, StreamFNV& fnv);
+
+    const char* m_begin = nullptr;
+    const char* m_p = nullptr;
+    const char* m_end = nullptr;
+    std::string m_unescaped;
+    std::string m_open;         // Containers skipValue is inside, innermost last
+    std::string m_name;
+    const char* m_error = nullptr;
+    size_t m_errorOffset = 0;
+};
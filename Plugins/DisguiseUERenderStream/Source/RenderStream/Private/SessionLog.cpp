@@ -0,0 +1,377 @@
+#include "SessionLog.hpp"
+
+#include "NativePlatform.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const char Magic[8] = { 'R', 'S', 'S', 'E', 'S', 'S', 'N', '1' };
+    const uint32_t Version = 1;
+    const uint64_t GrowBytes = 16 * 1024 * 1024;
+    const uint64_t IndexEntryBytes = 16;    // { uint64_t offset, int64_t time }
+
+    const uint32_t FLAG_PARAMETERS_VALID = 1;
+
+    struct SessionLogHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint64_t frameCount;    // Index entries, set on close
+        uint64_t dataEnd;       // End of the last complete record, moved on after every append
+        uint64_t indexOffset;   // 0 until closed
+        uint8_t reserved[24];
+    };
+    static_assert(sizeof(SessionLogHeader) == 64, "Session log header layout changed");
+
+#pragma pack(push, 4)
+    struct RecordHeader
+    {
+        uint32_t bytes;         // Whole record including padding
+        uint32_t nCameras;
+        uint32_t nParameters;
+        uint32_t flags;
+        int64_t time;
+        uint64_t schemaHash;
+        RenderStreamLink::FrameData frameData;
+    };
+#pragma pack(pop)
+
+    uint64_t recordBytes(size_t nCameras, size_t nParameters)
+    {
+        const uint64_t bytes = sizeof(RecordHeader) + nCameras * sizeof(SessionCamera) + nParameters * sizeof(float);
+        return (bytes + 7) & ~uint64_t(7);
+    }
+
+#if defined(_WIN32)
+    std::wstring widen(const std::string& path)
+    {
+        const int n = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+        std::wstring wide(size_t(n > 0 ? n : 1), L'\0');
+        if (n > 0)
+            MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], n);
+        return wide;
+    }
+#endif
+}
+
+// A whole file mapped into memory, writable mappings can be grown and trimmed.
+class SessionMapping
+{
+public:
+    ~SessionMapping()
+    {
+        close(m_size);
+    }
+
+    static std::unique_ptr<SessionMapping> openWrite(const std::string& path, uint64_t bytes)
+    {
+        std::unique_ptr<SessionMapping> mapping(new SessionMapping());
+        mapping->m_writable = true;
+#if defined(_WIN32)
+        mapping->m_file = CreateFileW(widen(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapping->m_file == INVALID_HANDLE_VALUE)
+            return nullptr;
+#else
+        mapping->m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mapping->m_fd < 0)
+            return nullptr;
+#endif
+        if (!mapping->resize(bytes))
+            return nullptr;
+        return mapping;
+    }
+
+    static std::unique_ptr<SessionMapping> openRead(const std::string& path)
+    {
+        std::unique_ptr<SessionMapping> mapping(new SessionMapping());
+#if defined(_WIN32)
+        mapping->m_file = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapping->m_file == INVALID_HANDLE_VALUE)
+            return nullptr;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mapping->m_file, &size) || size.QuadPart == 0)
+            return nullptr;
+        mapping->m_mapping = CreateFileMappingW(mapping->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping->m_mapping)
+            return nullptr;
+        mapping->m_data = static_cast<uint8_t*>(MapViewOfFile(mapping->m_mapping, FILE_MAP_READ, 0, 0, 0));
+        mapping->m_size = uint64_t(size.QuadPart);
+#else
+        mapping->m_fd = ::open(path.c_str(), O_RDONLY);
+        if (mapping->m_fd < 0)
+            return nullptr;
+        struct stat st;
+        if (fstat(mapping->m_fd, &st) != 0 || st.st_size == 0)
+            return nullptr;
+        void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, mapping->m_fd, 0);
+        mapping->m_data = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+        mapping->m_size = uint64_t(st.st_size);
+#endif
+        if (!mapping->m_data)
+            return nullptr;
+        return mapping;
+    }
+
+    // Remaps at the new size, so pointers into data() do not survive.
+    bool resize(uint64_t bytes)
+    {
+        unmap();
+#if defined(_WIN32)
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, DWORD(bytes >> 32), DWORD(bytes), nullptr);
+        if (!m_mapping)
+            return false;
+        m_data = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+#else
+        if (ftruncate(m_fd, off_t(bytes)) != 0)
+            return false;
+        void* data = mmap(nullptr, size_t(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        m_data = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+#endif
+        m_size = m_data ? bytes : 0;
+        return m_data != nullptr;
+    }
+
+    // Unmaps and, for writable mappings, cuts the file to finalBytes.
+    void close(uint64_t finalBytes)
+    {
+        unmap();
+#if defined(_WIN32)
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            if (m_writable)
+            {
+                LARGE_INTEGER end;
+                end.QuadPart = LONGLONG(finalBytes);
+                if (SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN))
+                    SetEndOfFile(m_file);
+            }
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_fd >= 0)
+        {
+            if (m_writable && ftruncate(m_fd, off_t(finalBytes)) != 0) {}
+            ::close(m_fd);
+            m_fd = -1;
+        }
+#endif
+    }
+
+    uint8_t* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+
+private:
+    SessionMapping() = default;
+
+    void unmap()
+    {
+#if defined(_WIN32)
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        if (m_data)
+            munmap(m_data, size_t(m_size));
+#endif
+        m_data = nullptr;
+    }
+
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    bool m_writable = false;
+};
+
+std::unique_ptr<SessionWriter> SessionWriter::create(const std::string& path)
+{
+    std::unique_ptr<SessionMapping> mapping = SessionMapping::openWrite(path, GrowBytes);
+    if (!mapping)
+        return nullptr;
+    return std::unique_ptr<SessionWriter>(new SessionWriter(path, std::move(mapping)));
+}
+
+SessionWriter::SessionWriter(const std::string& path, std::unique_ptr<SessionMapping> mapping)
+    : m_path(path)
+    , m_mapping(std::move(mapping))
+    , m_end(sizeof(SessionLogHeader))
+{
+    SessionLogHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.headerBytes = sizeof(SessionLogHeader);
+    header.dataEnd = m_end;
+    std::memcpy(m_mapping->data(), &header, sizeof(header));
+}
+
+SessionWriter::~SessionWriter()
+{
+    close();
+}
+
+bool SessionWriter::reserve(uint64_t bytes)
+{
+    if (bytes <= m_mapping->size())
+        return true;
+    return m_mapping->resize(std::max(bytes, m_mapping->size() + std::max(m_mapping->size(), GrowBytes)));
+}
+
+bool SessionWriter::append(const SessionFrame& frame)
+{
+    if (!m_mapping)
+        return false;
+
+    const uint64_t bytes = recordBytes(frame.nCameras, frame.nParameters);
+    if (!reserve(m_end + bytes))
+    {
+        // What was written so far stays readable, the header still points at the last complete record.
+        m_mapping->close(m_end);
+        m_mapping.reset();
+        return false;
+    }
+
+    RecordHeader record;
+    record.bytes = uint32_t(bytes);
+    record.nCameras = uint32_t(frame.nCameras);
+    record.nParameters = uint32_t(frame.nParameters);
+    record.flags = frame.parametersValid ? FLAG_PARAMETERS_VALID : 0;
+    record.time = frame.time;
+    record.schemaHash = frame.schemaHash;
+    record.frameData = frame.frameData;
+
+    uint8_t* out = m_mapping->data() + m_end;
+    std::memcpy(out, &record, sizeof(record));
+    out += sizeof(record);
+    if (frame.nCameras)
+        std::memcpy(out, frame.cameras, frame.nCameras * sizeof(SessionCamera));
+    out += frame.nCameras * sizeof(SessionCamera);
+    if (frame.nParameters)
+        std::memcpy(out, frame.parameters, frame.nParameters * sizeof(float));
+
+    m_index.push_back({ m_end, frame.time });
+    m_end += bytes;
+
+    // Only now does the record count as written, a log cut short by a crash ends at the previous one.
+    SessionLogHeader* header = reinterpret_cast<SessionLogHeader*>(m_mapping->data());
+    header->dataEnd = m_end;
+    return true;
+}
+
+void SessionWriter::close()
+{
+    if (!m_mapping)
+        return;
+
+    const uint64_t indexOffset = m_end;
+    const uint64_t indexBytes = m_index.size() * sizeof(IndexEntry);
+    if (reserve(indexOffset + indexBytes))
+    {
+        if (indexBytes)
+            std::memcpy(m_mapping->data() + indexOffset, m_index.data(), size_t(indexBytes));
+        SessionLogHeader* header = reinterpret_cast<SessionLogHeader*>(m_mapping->data());
+        header->frameCount = m_index.size();
+        header->indexOffset = indexOffset;
+        m_mapping->close(indexOffset + indexBytes);
+    }
+    else
+    {
+        m_mapping->close(m_end);
+    }
+    m_mapping.reset();
+}
+
+std::unique_ptr<SessionReader> SessionReader::open(const std::string& path)
+{
+    std::unique_ptr<SessionMapping> mapping = SessionMapping::openRead(path);
+    if (!mapping)
+        return nullptr;
+    std::unique_ptr<SessionReader> reader(new SessionReader(std::move(mapping)));
+    if (!reader->load())
+        return nullptr;
+    return reader;
+}
+
+SessionReader::SessionReader(std::unique_ptr<SessionMapping> mapping)
+    : m_mapping(std::move(mapping))
+{
+}
+
+SessionReader::~SessionReader() = default;
+
+bool SessionReader::load()
+{
+    const uint8_t* data = m_mapping->data();
+    const uint64_t size = m_mapping->size();
+    if (size < sizeof(SessionLogHeader))
+        return false;
+
+    SessionLogHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.headerBytes != sizeof(SessionLogHeader))
+        return false;
+    const uint64_t dataEnd = std::min(header.dataEnd, size);
+
+    if (header.indexOffset != 0 && header.indexOffset + header.frameCount * IndexEntryBytes <= size)
+    {
+        m_offsets.resize(size_t(header.frameCount));
+        for (uint64_t i = 0; i < header.frameCount; ++i)
+            std::memcpy(&m_offsets[size_t(i)], data + header.indexOffset + i * IndexEntryBytes, sizeof(uint64_t));
+        m_indexed = true;
+    }
+    else
+    {
+        // Never closed, walk the records up to the last one known to be complete.
+        uint64_t offset = sizeof(SessionLogHeader);
+        while (offset + sizeof(RecordHeader) <= dataEnd)
+        {
+            RecordHeader record;
+            std::memcpy(&record, data + offset, sizeof(record));
+            if (record.bytes < sizeof(RecordHeader) || record.bytes != recordBytes(record.nCameras, record.nParameters) || offset + record.bytes > dataEnd)
+                break;
+            m_offsets.push_back(offset);
+            offset += record.bytes;
+        }
+    }
+
+    for (uint64_t offset : m_offsets)
+    {
+        if (offset < sizeof(SessionLogHeader) || offset + sizeof(RecordHeader) > dataEnd)
+            return false;
+        RecordHeader record;
+        std::memcpy(&record, data + offset, sizeof(record));
+        if (record.bytes != recordBytes(record.nCameras, record.nParameters) || offset + record.bytes > dataEnd)
+            return false;
+    }
+    return true;
+}
+
+SessionFrame SessionReader::frame(size_t index) const
+{
+    SessionFrame frame;
+    if (index >= m_offsets.size())
+        return frame;
+
+    const uint8_t* data = m_mapping->data() + m_offsets[index];
+    RecordHeader record;
+    std::memcpy(&record, data, sizeof(record));
+    frame.time = record.time;
+    frame.schemaHash = record.schemaHash;
+    frame.frameData = record.frameData;
+    frame.parametersValid = (record.flags & FLAG_PARAMETERS_VALID) != 0;
+    frame.nCameras = record.nCameras;
+    frame.cameras = reinterpret_cast<const SessionCamera*>(data + sizeof(RecordHeader));
+    frame.nParameters = record.nParameters;
+    frame.parameters = reinterpret_cast<const float*>(data + sizeof(RecordHeader) + record.nCameras * sizeof(SessionCamera));
+    return frame;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "RenderStreamLink.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary log of the input d3 sent during a session: frame data, parameters and cameras for every frame, written
+// through a memory mapping that grows as frames are appended. The layout is
+//   SessionLogHeader | record... | index
+// where each record is self-delimiting and the index, one { offset, time } per frame, is written on close. A log
+// that was never closed is still readable, the reader then rebuilds the index from the records.
+
+#pragma pack(push, 4)
+struct SessionCamera
+{
+    RenderStreamLink::StreamHandle stream;
+    uint32_t valid;
+    RenderStreamLink::CameraData data;
+};
+#pragma pack(pop)
+
+// One frame as appended, or as read back with its arrays pointing into the mapped file.
+struct SessionFrame
+{
+    int64_t time = 0;               // Monotonic ns at receipt, only differences are meaningful
+    uint64_t schemaHash = 0;
+    RenderStreamLink::FrameData frameData;
+    bool parametersValid = false;
+    const float* parameters = nullptr;
+    size_t nParameters = 0;
+    const SessionCamera* cameras = nullptr;
+    size_t nCameras = 0;
+};
+
+class SessionMapping;
+
+class SessionWriter
+{
+public:
+    // Null when the file cannot be created.
+    static std::unique_ptr<SessionWriter> create(const std::string& path);
+    ~SessionWriter();
+
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+
+    bool append(const SessionFrame& frame);
+    void close();   // Writes the index and trims the file, also done by the destructor
+
+    uint64_t frames() const { return m_index.size(); }
+    uint64_t bytes() const { return m_end; }
+    const std::string& path() const { return m_path; }
+
+private:
+    struct IndexEntry
+    {
+        uint64_t offset;
+        int64_t time;
+    };
+
+    SessionWriter(const std::string& path, std::unique_ptr<SessionMapping> mapping);
+    bool reserve(uint64_t bytes);
+
+    std::string m_path;
+    std::unique_ptr<SessionMapping> m_mapping;
+    uint64_t m_end = 0;
+    std::vector<IndexEntry> m_index;
+};
+
+class SessionReader
+{
+public:
+    // Null when the file is missing or not a session log.
+    static std::unique_ptr<SessionReader> open(const std::string& path);
+    ~SessionReader();
+
+    SessionReader(const SessionReader&) = delete;
+    SessionReader& operator=(const SessionReader&) = delete;
+
+    size_t frameCount() const { return m_offsets.size(); }
+    SessionFrame frame(size_t index) const;
+    bool indexed() const { return m_indexed; }   // False when the index had to be rebuilt
+
+private:
+    explicit SessionReader(std::unique_ptr<SessionMapping> mapping);
+    bool load();
+
+    std::unique_ptr<SessionMapping> m_mapping;
+    std::vector<uint64_t> m_offsets;
+    bool m_indexed = false;
+};
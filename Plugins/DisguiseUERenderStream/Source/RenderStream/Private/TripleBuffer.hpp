@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single producer, single consumer hand-over of the newest value. The producer fills back() and publishes it, the
+// consumer takes whatever was published last, and neither ever waits for the other. Values published while the
+// consumer was not looking are overwritten, and slots are reused so their allocations survive.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+    {
+        m_middle.store(1, std::memory_order_relaxed);
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side.
+    T& back() { return m_slots[m_back]; }
+
+    // Returns false when the previously published value was never consumed.
+    bool publish()
+    {
+        const uint32_t previous = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel);
+        m_back = previous & Index;
+        return (previous & Fresh) == 0;
+    }
+
+    // Consumer side. Returns false, leaving front() untouched, when nothing was published since the last call.
+    bool consume()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & Fresh) == 0)
+            return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & Index;
+        return true;
+    }
+
+    const T& front() const { return m_slots[m_front]; }
+
+    bool fresh() const { return (m_middle.load(std::memory_order_acquire) & Fresh) != 0; }
+
+private:
+    static constexpr uint32_t Index = 3;
+    static constexpr uint32_t Fresh = 4;
+
+    // Padding rather than alignas, see RingQueue.
+    static constexpr size_t CacheLine = 64;
+
+    T m_slots[3];
+    uint32_t m_back = 0;
+    char m_padding0[CacheLine];
+    std::atomic<uint32_t> m_middle;
+    char m_padding1[CacheLine - sizeof(std::atomic<uint32_t>)];
+    uint32_t m_front = 2;
+};
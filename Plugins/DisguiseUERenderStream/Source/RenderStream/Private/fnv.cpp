@@ -1,6 +1,7 @@
 // fnv.cpp
 #include "fnv.hpp"
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 // quick hash. 
@@ -28,11 +29,13 @@ uint64_t fnvHash(const uint8_t* buffer, size_t nBytes)
             buf++;
         }
 
-        // Last (potentially incomplete) block
+        // Last (potentially incomplete) block, copied so as not to read past the end of the buffer
         const int nBytesOver = nBytes & 7;
         const uint64_t masks[8] = { 0xffffffffffffffff, 0xff, 0xffff, 0xffffff, 0xffffffff, 0xffffffffff, 0xffffffffffff, 0xffffffffffffff };
         const uint64_t pads[8] = { 0x0000000000000000, 0x0100, 0x010000, 0x01000000, 0x0100000000, 0x010000000000, 0x01000000000000, 0x0100000000000000 };
-        const uint64_t u = *buf & masks[nBytesOver] | pads[nBytesOver];
+        uint64_t last = 0;
+        std::memcpy(&last, buf, nBytesOver ? nBytesOver : 8);
+        const uint64_t u = last & masks[nBytesOver] | pads[nBytesOver];
         hash ^= u;
         hash *= FNV_PRIME;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 
 // FNC functions
 uint64_t      fnvHash(const uint8_t* buffer, size_t nBytes);         // quick 64-bit hash on any-sized buffer
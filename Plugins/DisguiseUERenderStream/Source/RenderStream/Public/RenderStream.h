@@ -5,16 +5,27 @@
 #include "Core.h"
 #include "Core/Public/Modules/ModuleInterface.h"
 #include "SlateCore/Public/Styling/SlateColor.h"
-#include "Json/Public/Dom/JsonObject.h"
 #include "Engine/LevelStreaming.h"
+#include <chrono>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "RenderStreamLink.h"
+#include "CompiledSchema.hpp"
+#include "ConvertScheduler.hpp"
+#include "FrameReceiver.hpp"
+#include "LatencyTracer.hpp"
+#include "ParameterInterpolator.hpp"
+#include "ResolutionController.hpp"
+#include "SceneResidency.hpp"
+#include "SceneSwitch.hpp"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogRenderStream, Log, All);
 
 class URenderStreamMediaCapture;
 class AActor;
+class FBoolProperty;
 class StreamFNV;
 
 #define RSSTATUS_RED FSlateColor({ 1.0, 0.0, 0.0 })
@@ -57,22 +68,151 @@ public:
     RenderStreamStatus m_status;
     void LoadSchemas(const UWorld& World);
 
+    // Shared by every capture, rebuilt when the conversion settings change. Rendering thread only.
+    ConvertScheduler& Converter();
+
+    // Stage latencies of every frame sent by any capture, safe to record and query from any thread.
+    LatencyTracer& Latency() { return m_latency; }
+    // Records the stages of a sent frame and sets them as Unreal Insights counters. Any thread.
+    void RecordLatency(const LatencyTracer::Trace& Trace);
+    LatencyTracer::Trace m_frameTrace; // Trace of the frame data last applied, game thread
+    // The newest camera d3 sent for Stream, which may be from a frame the game thread has not taken yet. Any thread.
+    bool LatestCamera(RenderStreamLink::StreamHandle Stream, FrameReceiver::LatestCamera& Out) const;
+    // From d3 switching scene until the scene's level is visible.
+    LatencyHistogram& SceneSwitchTime() { return m_sceneSwitchTime; }
+
+    // Writes every frame received from d3 to a session log that RenderStreamLink can replay later.
+    bool StartRecording(const FString& Path);
+    void StopRecording();
+
+    // Loads the scene's level in the background ahead of d3 switching to it, within the scene residency budget.
+    void HintScene(const FString& Scene);
+
+    // Takes the next frame from d3, waiting for it until Deadline, and applies it. False when none arrived in time.
+    bool AwaitFrame(std::chrono::steady_clock::time_point Deadline);
+    // Set by URenderStreamCustomTimeStep, which then awaits frames in place of the start of frame.
+    void SetTimeStepActive(bool Active) { m_timeStepActive = Active; }
+    bool IsReceiving() const { return m_receiver.IsValid(); }
+    // How far the engine is from the frame last applied towards d3's next, from 0 to 1. 0 on frames that took one.
+    double SubFrame() const { return m_subFrame; }
+
 private:
+    // An exposed property resolved when the schema is validated, so applying a frame walks a flat array rather than
+    // the reflection data of the level script class.
+    struct ParameterBinding
+    {
+        enum class Kind : uint8 { Bool, Byte, Int, Float, Vector, Color, LinearColor };
+        Kind kind = Kind::Float;
+        uint8 components = 1;                           // Parameters consumed
+        int32 offset = 0;                               // Of the value within the root actor
+        const FBoolProperty* boolProperty = nullptr;    // Bools may be bitfields, so are written through their property
+        FName name;
+    };
+
     struct SchemaSpec
     {
-        const ULevelStreaming* streamingLevel = nullptr;
+        ULevelStreaming* streamingLevel = nullptr;
         const AActor* schemaRoot = nullptr;
         const AActor* schemaPersistentRoot = nullptr;
         uint64_t schemaHash = 0;
         size_t nParameters = 0;
+        std::vector<ParameterBinding> persistentBindings;   // Resolved against schemaPersistentRoot
+        std::vector<ParameterBinding> levelBindings;        // Resolved against schemaRoot
+        std::vector<float> appliedParameters;               // As last written, empty until the first frame
+        uint64_t appliedHash = 0;                           // Of appliedParameters
+        ParameterInterpolator interpolator;                 // Over persistentBindings then levelBindings
+        // Guard against reusing the spec for another actor allocated where a validated root used to be.
+        TWeakObjectPtr<const AActor> validatedRoot;
+        TWeakObjectPtr<const AActor> validatedPersistentRoot;
     };
     std::vector<SchemaSpec> m_specs;
 
-    void ValidateSchema(const TSharedPtr<FJsonObject>& JsonSchema, const AActor* Root, const AActor* PersistentRoot, SchemaSpec& spec);
-    size_t ValidateRoot(const AActor* Root, const TArray< TSharedPtr<FJsonValue> >& JsonParameters, SchemaSpec& spec, StreamFNV& fnv) const;
-    size_t ApplyParameters(AActor* schemaRoot, const std::vector<float>& parameters, const size_t offset);
+    // The parameters a level script actor exposes, in schema order.
+    struct RootBindings
+    {
+        std::vector<ParameterBinding> bindings;
+        std::vector<std::string> keys;      // UTF-8, one per parameter
+    };
+
+    // schema.json as last loaded. Kept while the file's size and modification time are unchanged, and when only
+    // those changed but its content hash did not.
+    struct SchemaSource
+    {
+        int64 size = -1;
+        FDateTime modified;
+        uint64_t hash = 0;
+        std::string text;           // UTF-8, sent to d3 by rs_setSchema
+        CompiledSchema compiled;
+        bool parsed = false;        // compiled holds the schema in text
+    };
+    SchemaSource m_schemaSource;
+    uint64_t m_sentSchemaHash = 0;
+    bool m_schemaSent = false;
+
+    // Scene name to streaming level, rebuilt when the world or its streaming levels change.
+    std::map<FString, ULevelStreaming*> m_levelLookup;
+    TWeakObjectPtr<const UWorld> m_levelLookupWorld;
+    TArray<ULevelStreaming*> m_levelLookupLevels;
+
+    // Returns true when the schema changed since the last call.
+    bool RefreshSchemaSource(const FString& SchemaPath);
+    void UpdateLevelLookup(const UWorld& World);
+
+    // Which scene levels are kept loaded, indexed like m_specs.
+    SceneResidency m_residency;
+    TMap<FName, uint64> m_levelCosts;   // Package size on disk of each level
+    std::vector<TWeakObjectPtr<const AActor>> m_residentRoots; // Level script actor of each scene's loaded level, as last seen
+    uint64_t LevelCost(const ULevelStreaming& streamingLevel);
+
+    // Indexed like m_specs, over the levels of m_levelLookupLevels.
+    SceneSwitch m_sceneSwitch;
+    std::vector<size_t> m_levelsToHide;
+    LatencyHistogram m_sceneSwitchTime;
+    // Loads and unloads levels as the resident set changes, and validates levels that finished loading in the background.
+    void UpdateResidency(const UWorld& World, uint32_t scene);
+    static bool IsValidatedFor(const SchemaSpec& spec, const ULevelStreaming* streamingLevel, const AActor* Root, const AActor* PersistentRoot);
+    // The scene's spec when its bindings were resolved against these very roots, after loading the schemas again if
+    // they were not. Null when the schema does not match them, which is retried only once the roots change.
+    SchemaSpec* ValidatedSpec(const UWorld& World, uint32_t scene, const AActor* Root, const AActor* PersistentRoot);
+    uint32_t m_revalidatedScene = UINT32_MAX;
+    TWeakObjectPtr<const AActor> m_revalidatedRoot;
+    TWeakObjectPtr<const AActor> m_revalidatedPersistentRoot;
+    void ValidateSchema(const FString& Scene, const CompiledSchema::Scene& schema, const AActor* Root, const AActor* PersistentRoot, const RootBindings& persistent, SchemaSpec& spec);
+    static void BindRoot(const AActor* Root, RootBindings& out);
+    // Writes the parameters that differ from those last applied for the schema and raises change events for them.
+    void ApplyParameters(SchemaSpec& spec, AActor* persistentRoot, AActor* levelRoot, const std::vector<float>& parameters);
+    // Writes the bindings whose parameters are set in changed, all of them when it is null, adding their names to
+    // changedNames when given. first is the index of parameters[0] in changed. Returns the number of parameters consumed.
+    static size_t ApplyBindings(AActor* Root, const std::vector<ParameterBinding>& bindings, const float* parameters, const uint64_t* changed, size_t first, TArray<FName>* changedNames);
+    // The parameters to write for the frame just received, after passing them through the spec's interpolator.
+    const std::vector<float>& SampleParameters(SchemaSpec& spec, const std::vector<float>& parameters);
+    static std::vector<uint8_t> ContinuousParameters(const SchemaSpec& spec);
+    std::vector<uint64_t> m_changedMask;
+    TArray<FName> m_changedParameters;
+
+    TUniquePtr<ConvertScheduler> m_converter;
+
+    // Waits on d3 off the game thread, exists while the asset does.
+    TUniquePtr<FrameReceiver> m_receiver;
+    LatencyTracer m_latency;
+    void UpdateReceiverStreams();
+
+    bool m_timeStepActive = false;
 
     FDelegateHandle OnBeginFrameHandle;
     void OnBeginFrame();
+    void ApplyFrame();
+    // On engine frames without a new frame from d3, moves interpolated parameters on towards d3's newest.
+    void InterpolateFrame();
+    int64_t m_frameAppliedAt = 0;
+    double m_subFrame = 0.;
+    // Lets each capture decide whether to render this frame, before the engine draws it.
+    void DecideRenders();
+
+    // Scales r.ScreenPercentage to keep frames within d3's frame period.
+    ResolutionController m_resolution;
+    float m_screenPercentageBefore = -1.f;  // Restored when the controller lets go, negative until it takes over
+    bool m_sendBound = false;
+    void UpdateResolution();
    
 };
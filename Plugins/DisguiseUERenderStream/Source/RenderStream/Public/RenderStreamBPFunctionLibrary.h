@@ -55,4 +55,15 @@ class URenderStreamBPFunctionLibrary : public UBlueprintFunctionLibrary
     */
     UFUNCTION(BlueprintCallable, Category = "DisguiseRenderStream")
     static void StopCapture(URenderStreamMediaCapture* MediaCapture);
+
+    //~~~~~~~~~~~~~~~~~~
+    // 	Prefetch Scene
+    //~~~~~~~~~~~~~~~~~~
+    /**  Loads the level of a schema scene in the background, hidden, so that d3 switching to it only makes it visible
+    *
+    * The scene counts as recently shown for the Scene Residency Budget, which has to be above 0
+    * @param Scene - Name of the scene in the schema, as shown in d3
+    */
+    UFUNCTION(BlueprintCallable, Category = "DisguiseRenderStream")
+    static void PrefetchScene(const FString& Scene);
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Engine/EngineCustomTimeStep.h"
+
+#include "FrameClock.hpp"
+
+#include "RenderStreamCustomTimeStep.generated.h"
+
+/**
+ * Genlock the engine to the frames d3 sends. Each engine frame waits for d3's next frame, for at most a little past
+ * when it is due, and steps engine time by d3's frame time.
+ */
+UCLASS(EditInlineNew, Blueprintable, meta = (DisplayName = "RenderStream Genlock"))
+class RENDERSTREAM_API URenderStreamCustomTimeStep : public UEngineCustomTimeStep
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	//~ UEngineCustomTimeStep interface
+	virtual bool Initialize(class UEngine* InEngine) override;
+	virtual void Shutdown(class UEngine* InEngine) override;
+	virtual bool UpdateTimeStep(class UEngine* InEngine) override;
+	virtual ECustomTimeStepSynchronizationState GetSynchronizationState() const override;
+
+	// Longest wait for a frame before d3's cadence has been measured, and whenever d3 stops sending
+	UPROPERTY(EditAnywhere, Category = "Genlock", meta = (ClampMin = "1", ClampMax = "1000", DisplayName = "Max Wait (ms)"))
+	int32 MaxWaitMs;
+
+	// Step engine time by d3's frame time rather than the time that passed, keeping it on d3's timeline
+	UPROPERTY(EditAnywhere, Category = "Genlock", meta = (DisplayName = "Step By d3 Frame Time"))
+	bool bStepByFrameTime;
+
+	const FrameClock& Clock() const { return m_clock; }
+
+private:
+	FrameClock m_clock;
+	FrameClock::State m_reportedState = FrameClock::State::Closed;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "RenderStreamEvents.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FRenderStreamParameterChanged, FName, Parameter);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FRenderStreamParametersChanged, const TArray<FName>&, Parameters);
+
+/**
+* Notifies Blueprints of changes d3 makes to exposed parameters, so they can react without polling on Tick.
+*
+* Raised from the start of the frame in which the new values were written to the level script actors. Parameters are
+* named after their properties, and only properties whose value differs from the last one d3 sent are written, so
+* a property changed locally keeps its value until d3 changes it.
+*/
+UCLASS()
+class RENDERSTREAM_API URenderStreamEvents : public UEngineSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Once per changed parameter.
+    UPROPERTY(BlueprintAssignable, Category = "DisguiseRenderStream")
+    FRenderStreamParameterChanged OnParameterChanged;
+
+    // Once per frame in which any parameter changed, with all of them.
+    UPROPERTY(BlueprintAssignable, Category = "DisguiseRenderStream")
+    FRenderStreamParametersChanged OnParametersChanged;
+
+    bool HasParameterListeners() const { return OnParameterChanged.IsBound() || OnParametersChanged.IsBound(); }
+    void BroadcastParametersChanged(const TArray<FName>& Parameters);
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+#include "Math/UnitConversion.h"
+
+#include "RenderStreamLink.h"
+#include "CameraFilter.hpp"
+#include "CameraPredictor.hpp"
+#include "LatencyTracer.hpp"
+
+#include <atomic>
+
+class FRenderStreamModule;
+class USceneComponent;
+class UCameraComponent;
+
+// Moves the view of a capture to the newest camera d3 sent, on the rendering thread just before the view is set up.
+// The game thread applied the camera the view was built from a frame or more earlier. Only the pose is latched, the
+// lens stays as the game thread applied it, and the camera sent back to d3 with the frame is patched to match.
+class FRenderStreamLateLatch : public FSceneViewExtensionBase
+{
+public:
+    struct Config
+    {
+        RenderStreamLink::StreamHandle stream = 0;
+        TWeakObjectPtr<USceneComponent> locationReceiver;
+        TWeakObjectPtr<USceneComponent> rotationReceiver;
+        TWeakObjectPtr<UCameraComponent> camera;
+        EUnit unitScale = EUnit::Centimeters;
+        // Latched cameras go through their own filter and predictor, set up like those of the game thread.
+        CameraFilter::Settings filter;
+        CameraPredictor::Model prediction = CameraPredictor::Model::None;
+        double horizon = 0.;
+    };
+
+    struct Stats
+    {
+        uint64 views = 0;       // Views of the capture rendered
+        uint64 latched = 0;     // Of which moved to a camera newer than the game thread applied
+    };
+
+    FRenderStreamLateLatch(const FAutoRegister& AutoRegister, FRenderStreamModule* Module);
+
+    // Game thread.
+    void Configure(const Config& config);
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+    bool IsEnabled() const { return m_enabled; }
+    // The camera the game thread applied and the receive sequence of its frame, taken with the next view family.
+    void SetApplied(const RenderStreamLink::CameraResponseData& response, uint64 sequence);
+    Stats GetStats() const;
+
+    // Rendering thread. Replaces the camera and trace of a frame captured on game frame FrameNumber with the latched
+    // ones, when its view was latched.
+    void Patch(uint32 FrameNumber, RenderStreamLink::CameraResponseData& response, LatencyTracer::Trace& trace) const;
+
+    //~ ISceneViewExtension interface
+    virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+    virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override;
+    virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override {}
+    virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override;
+    virtual bool IsActiveThisFrame(class FViewport* InViewport) const override { return m_enabled; }
+
+private:
+    // A receiver the view moves with: its transform relative to its parent, set from the camera, and its parent's.
+    struct Step
+    {
+        FTransform local;
+        FTransform parent;
+        bool location = false;
+        bool rotation = false;
+    };
+
+    // What the game thread built a view family from.
+    struct Family
+    {
+        uint32 frameNumber = 0;                 // GFrameNumber it was built on
+        const AActor* viewActor = nullptr;      // Compared, never dereferenced
+        RenderStreamLink::StreamHandle stream = 0;
+        EUnit unitScale = EUnit::Centimeters;
+        RenderStreamLink::CameraResponseData applied;
+        uint64 sequence = 0;
+        Step steps[2];                          // Nearest the camera first
+        int32 nSteps = 0;
+    };
+
+    struct Latch
+    {
+        uint32 frameNumber = 0;
+        bool valid = false;
+        RenderStreamLink::CameraResponseData response;
+        uint64 sequence = 0;
+        int64 receivedAt = 0;
+    };
+
+    // Frames are captured a few frames after they are rendered.
+    static constexpr uint32 LatchFrames = 8;
+
+    FRenderStreamModule* m_module;
+
+    // Game thread.
+    Config m_config;
+    RenderStreamLink::CameraResponseData m_applied;
+    uint64 m_appliedSequence = 0;
+    bool m_enabled = false;
+
+    // Rendering thread.
+    Family m_family;
+    Latch m_latches[LatchFrames];
+    CameraFilter m_filter;
+    CameraPredictor m_predictor;
+    uint64 m_lastSequence = 0;
+    RenderStreamLink::CameraData m_lastPose;
+
+    std::atomic<uint64> m_views;
+    std::atomic<uint64> m_latched;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 class RenderStreamLink
@@ -117,8 +118,6 @@ private:
 private:
     typedef void rs_getVersionFn(int* versionMajor, int* versionMinor);
 
-    typedef void (*logger_t)(const char*);
-
     typedef void rs_registerLoggingFuncFn(logger_t);
     typedef void rs_registerErrorLoggingFuncFn(logger_t);
     typedef void rs_registerVerboseLoggingFuncFn(logger_t);
@@ -146,6 +145,13 @@ public:
     bool loadExplicit();
     bool unloadExplicit();
 
+    // Serves rs_awaitFrameData, rs_getFrameParameters and rs_getFrameCamera from a session recorded by FrameReceiver
+    // (see SessionLog.hpp) instead of d3, everything else still goes to the loaded library. speed scales the recorded
+    // timing, 0 hands frames out as fast as they are awaited. Only while nothing is waiting on frame data.
+    bool startReplay(const char* path, AssetHandle asset, double speed, bool loop);
+    void stopReplay();
+    bool isReplaying() const { return m_liveAwaitFrameData != nullptr; }
+
 public: // d3renderstream.h API, but loaded dynamically.
     rs_getVersionFn* rs_getVersion = nullptr;
 
@@ -173,4 +179,9 @@ public: // d3renderstream.h API, but loaded dynamically.
 private:
     bool m_loaded = false;
     void* m_dll = nullptr;
+
+    // The library's own entry points while replaying.
+    rs_awaitFrameDataFn* m_liveAwaitFrameData = nullptr;
+    rs_getFrameParametersFn* m_liveGetFrameParameters = nullptr;
+    rs_getFrameCameraFn* m_liveGetFrameCamera = nullptr;
 };
@@ -3,6 +3,7 @@
 #pragma once
 
 
+#if PLATFORM_WINDOWS
 // These macros are set in the DX12 and NVAftermath third party Unreal modules, which don't seem to be accessible to third-party plugins.
 #ifndef NV_AFTERMATH
 #define NV_AFTERMATH 0
@@ -13,6 +14,7 @@
 #endif
 
 #include "D3D12RHIPrivate.h"
+#endif
 
 #include "CoreMinimal.h"
 #include "MediaIOCore/Public/MediaCapture.h"
@@ -21,12 +23,22 @@
 
 #include "RenderStream.h"
 #include "RenderStreamLink.h"
+#include "FrameSender.hpp"
+#include "PixelConvert.hpp"
+#include "CameraFilter.hpp"
+#include "CameraPredictor.hpp"
+#include "RenderOnDemand.hpp"
 
+#if PLATFORM_WINDOWS
 #include "Windows/MinWindows.h"
 #include <d3d12.h>
+#endif
 
 #include "RenderStreamMediaCapture.generated.h"
 
+class FRenderStreamLateLatch;
+class UGameViewportClient;
+
 /**
  * 
  */
@@ -40,7 +52,15 @@ public:
     void SetReceivingComponentsCamera(class USceneComponent* LocationComponent, class USceneComponent* RotationComponent, class UCameraComponent* Camera);
 
     RenderStreamLink::StreamHandle streamHandle() const { return m_streamHandle; }
-    void ApplyCameraData(const RenderStreamLink::FrameData& frameData, const RenderStreamLink::CameraData& cameraData);
+    void ApplyCameraData(const RenderStreamLink::FrameData& frameData, const RenderStreamLink::CameraData& trackedData, const LatencyTracer::Trace& trace);
+
+    // Transforms of the receiving components for a camera from d3, relative to their parents.
+    static FVector TrackedLocation(const RenderStreamLink::CameraData& cameraData, EUnit unitScale);
+    static FQuat TrackedRotation(const RenderStreamLink::CameraData& cameraData);
+
+    // Game thread, before the frame is drawn. inputs fingerprints the scene and parameters applied.
+    void DecideRender(uint64_t inputs, bool receiving);
+    bool IsRendering() const { return m_renderDecision.action == RenderOnDemand::Action::Render; }
 
     UWorld* SchemaWorld() const;
     UFUNCTION(BlueprintCallable, Category = "Callback")
@@ -54,13 +74,35 @@ private:
     FString m_streamName;
     RenderStreamLink::StreamHandle m_streamHandle = 0;
 	RenderStreamLink::SenderPixelFormat m_fmt;
+    PixelConvert::AlphaOp m_alphaOp = PixelConvert::AlphaOp::None; // Applied by ConvertFrame, or by the copy shader for UC streams
+    bool m_cpuConvert = false; // Host memory frames are read back untouched and go through ConvertFrame
 
     EUnit m_unitScale;
+    CameraFilter m_filter;
+    CameraPredictor m_predictor;
+    // Registered the first time a capture late latches, then kept as the rendering thread may still be using it.
+    TSharedPtr<FRenderStreamLateLatch, ESPMode::ThreadSafe> m_lateLatch;
 
     RenderStreamLink::CameraResponseData m_frameResponseData;
+    LatencyTracer::Trace m_frameTrace;
 
     FTextureRHIRef m_bufTexture;
 
+    RenderOnDemand m_onDemand;
+    RenderOnDemand::Decision m_renderDecision;
+    TWeakObjectPtr<UGameViewportClient> m_gameViewport; // Only set when capturing the game viewport
+    bool m_worldRenderingDisabled = false;
+    // The frame repeated while inputs are unchanged, as sent. Rendering thread only.
+    TArray<uint8> m_keptFrame;
+    int32 m_keptWidth = 0;
+    int32 m_keptHeight = 0;
+    bool m_keptValid = false;
+
+    TUniquePtr<FrameSender> m_sender; // Only set when host memory frames are sent from a worker thread
+    std::shared_ptr<FrameBufferPool> m_hostBuffers; // Frames waiting for m_sender, only touched on the rendering thread once capturing
+    uint32_t m_hostBufferFlags = FrameBufferPool::FLAG_NONE;
+    TArray<uint8> m_convertBuffer; // CPU converted frames when sending from the rendering thread
+
     bool m_printSuccess = false;
 
     bool m_useUC = false;
@@ -69,14 +111,23 @@ private:
 
 private:
     bool CreateSenderHandle ();
+    bool EnsureHostBuffers (size_t FrameBytes);
+    void ConvertFrame (const void* InBuffer, int32 Width, int32 Height, uint8* OutBuffer) const;
+    void KeepFrame (const void* Frame, size_t FrameBytes, int32 Width, int32 Height);
 
     // Begin UMediaCapture
 protected:
     struct FRenderStreamUserData : FMediaCaptureUserData
     {
         RenderStreamLink::CameraResponseData frameData;
+        LatencyTracer::Trace trace;
+        uint32 frameNumber = 0; // GFrameNumber the frame was rendered on
+        RenderOnDemand::Decision render;
     };
 
+    // Rendering thread. Brings the frame's camera up to date with a late latched view.
+    void LateLatch(FRenderStreamUserData& userData) const;
+
     void OnCustomCapture_RenderingThread(FRHICommandListImmediate & RHICmdList, const FCaptureBaseData & InBaseData, TSharedPtr < FMediaCaptureUserData , ESPMode::ThreadSafe > InUserData, FTexture2DRHIRef InSourceTexture, FTextureRHIRef TargetableTexture, FResolveParams & ResolveParams, FVector2D CropU, FVector2D CropV) override;
     void OnRHITextureCaptured_RenderingThread(const FCaptureBaseData & InBaseData, TSharedPtr < FMediaCaptureUserData , ESPMode::ThreadSafe > InUserData, FTextureRHIRef InTexture) override;
     void OnFrameCaptured_RenderingThread(const FCaptureBaseData& InBaseData, TSharedPtr<FMediaCaptureUserData, ESPMode::ThreadSafe> InUserData, void* InBuffer, int32 Width, int32 Height) override;
@@ -18,6 +18,7 @@ enum class ERenderStreamMediaOutputFormat
 	//RGBA	UMETA(DisplayName = "RGBA 8bit"),
 	BGRA	UMETA(DisplayName = "BGRA 8bit (NDI)"),
 	YUV422	UMETA(DisplayName = "YUV 4:2:2 8bit (NDI)"),
+	YUV422_ALPHA	UMETA(DisplayName = "YUV 4:2:2 8bit + Alpha (NDI)"),
 
 	YUV422_10b	UMETA(DisplayName = "YUV 4:2:2 10bit (UC)"),
 	YUV422_12b	UMETA(DisplayName = "YUV 4:2:2 12bit (UC)"),
@@ -33,6 +34,33 @@ enum class ERenderStreamAlphaType
 	NO_ACTION	UMETA(Display = "No Action"),
 	SET_ONE		UMETA(DisplayName = "Set to 1"),
 	INVERT		UMETA(DisplayName = "Invert Alpha"),
+	PREMULTIPLY	UMETA(DisplayName = "Premultiply"),
+	UNPREMULTIPLY	UMETA(DisplayName = "Unpremultiply"),
+};
+
+UENUM()
+enum class ERenderStreamSendPolicy
+{
+	BLOCK			UMETA(DisplayName = "Block"),
+	DROP_OLDEST		UMETA(DisplayName = "Drop Oldest"),
+	LATEST_WINS		UMETA(DisplayName = "Latest Wins"),
+};
+
+UENUM()
+enum class ERenderStreamCameraPrediction
+{
+	NONE					UMETA(DisplayName = "None"),
+	CONSTANT_VELOCITY		UMETA(DisplayName = "Constant Velocity"),
+	CONSTANT_ACCELERATION	UMETA(DisplayName = "Constant Acceleration"),
+	KALMAN					UMETA(DisplayName = "Kalman Filter"),
+};
+
+UENUM()
+enum class ERenderStreamRenderPolicy
+{
+	ALWAYS		UMETA(DisplayName = "Always Render"),
+	RESEND		UMETA(DisplayName = "Resend Last Frame"),
+	SUPPRESS	UMETA(DisplayName = "Send Nothing"),
 };
 
 /**
@@ -71,12 +99,75 @@ public:
 	UPROPERTY(EditAnywhere, Category = "RenderStream Uncompressed", meta = (DisplayName = "UC Use OpenCL"))
 	bool m_opencl = false;
 
+	// Hand captured host memory frames to a dedicated thread instead of sending them on the rendering thread
+	UPROPERTY(EditAnywhere, Category = "RenderStream Sending", meta = (DisplayName = "Send On Worker Thread"))
+	bool m_asyncSend = true;
+
+	// Frames that may wait for the sender thread, rounded up to a power of two
+	UPROPERTY(EditAnywhere, Category = "RenderStream Sending", meta = (EditCondition = "m_asyncSend", DisplayName = "Send Queue Depth", ClampMin = "1", ClampMax = "16"))
+	int32 m_sendQueueDepth = 2;
+
+	// What to do when the send queue is full
+	UPROPERTY(EditAnywhere, Category = "RenderStream Sending", meta = (EditCondition = "m_asyncSend", DisplayName = "Send Queue Policy"))
+	ERenderStreamSendPolicy m_sendPolicy = ERenderStreamSendPolicy::LATEST_WINS;
+
+	// Back the host frame buffers with large pages, needs the "Lock pages in memory" privilege on Windows or reserved huge pages on Linux
+	UPROPERTY(EditAnywhere, Category = "RenderStream Sending", meta = (EditCondition = "m_asyncSend", DisplayName = "Host Buffers Use Large Pages"))
+	bool m_hostBufferLargePages = false;
+
+	// Pin the host frame buffers in physical memory
+	UPROPERTY(EditAnywhere, Category = "RenderStream Sending", meta = (EditCondition = "m_asyncSend", DisplayName = "Host Buffers Locked"))
+	bool m_hostBufferLocked = false;
+
+	// Extrapolate the tracked camera from d3 to when the frame is expected on screen. The pose used is the one reported back to d3
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (DisplayName = "Camera Prediction"))
+	ERenderStreamCameraPrediction m_cameraPrediction = ERenderStreamCameraPrediction::NONE;
+
+	// How far past the tracked time the camera is predicted, typically the time from tracking to the LED wall
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (EditCondition = "m_cameraPrediction != ERenderStreamCameraPrediction::NONE", DisplayName = "Prediction Horizon (ms)", ClampMin = "0", ClampMax = "200"))
+	float m_predictionHorizonMs = 33.f;
+
+	// Move the view to the newest tracked camera on the rendering thread, just before it is drawn, saving up to a frame of tracking latency. Lower the prediction horizon to match
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (DisplayName = "Late Latch Camera"))
+	bool m_lateLatchCamera = false;
+
+	// Ignore tracked cameras that repeat the last pose or arrive older than it, keeping the last camera applied
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (DisplayName = "Reject Stale Tracking"))
+	bool m_rejectStaleTracking = true;
+
+	// Smooth tracking jitter with a One Euro filter before prediction, trading a little latency for a steadier camera
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (DisplayName = "Smooth Tracking"))
+	bool m_smoothTracking = false;
+
+	// Cutoff of the filter while the camera is still, lower is steadier
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (EditCondition = "m_smoothTracking", DisplayName = "Smoothing Min Cutoff (Hz)", ClampMin = "0.01", ClampMax = "30"))
+	float m_trackingMinCutoff = 1.f;
+
+	// How fast the cutoff rises with camera speed, higher lags less when moving. Each unit of speed is 10 cm/s or 10 degrees/s
+	UPROPERTY(EditAnywhere, Category = "RenderStream Tracking", meta = (EditCondition = "m_smoothTracking", DisplayName = "Smoothing Speed Coefficient", ClampMin = "0", ClampMax = "100"))
+	float m_trackingBeta = 1.f;
+
+	// What to do while the camera, scene and parameters from d3 are unchanged. Unless always rendering, the game viewport stops drawing the world, so only for scenes that do not animate by themselves
+	UPROPERTY(EditAnywhere, Category = "RenderStream On Demand", meta = (DisplayName = "Unchanged Frames"))
+	ERenderStreamRenderPolicy m_renderPolicy = ERenderStreamRenderPolicy::ALWAYS;
+
+	// Frames still rendered after the inputs last changed, for temporal anti-aliasing and eye adaptation to settle
+	UPROPERTY(EditAnywhere, Category = "RenderStream On Demand", meta = (EditCondition = "m_renderPolicy != ERenderStreamRenderPolicy::ALWAYS", DisplayName = "Settle Frames", ClampMin = "0", ClampMax = "120"))
+	int32 m_renderSettleFrames = 8;
+
+	// Frames rendered and sent per second while nothing is received from d3, 0 for every frame
+	UPROPERTY(EditAnywhere, Category = "RenderStream On Demand", meta = (DisplayName = "Idle Frame Rate", ClampMin = "0", ClampMax = "60"))
+	float m_idleFrameRate = 0.f;
 
 public:
 	URenderStreamMediaOutput ();
 
 	ERenderStreamMediaOutputFormat OutputFormat () { return m_outputFormat; }
 
+	// True when frames are read back untouched and the format packing and alpha operation happen in one CPU pass,
+	// only where the frame is copied on the CPU anyway or the GPU has no equivalent operation
+	bool ConvertsOnCPU () const;
+
 	// Begin UMediaOutput
 	bool Validate (FString& OutFailureReason) const override;
 	FIntPoint GetRequestedSize () const override;
@@ -6,6 +6,14 @@
 #include "Engine/EngineTypes.h"
 #include "RenderStreamSettings.generated.h"
 
+UENUM()
+enum class ERenderStreamParameterInterpolation
+{
+    STEP    UMETA(DisplayName = "Step"),
+    LINEAR  UMETA(DisplayName = "Linear"),
+    CUBIC   UMETA(DisplayName = "Cubic"),
+};
+
 /**
 * Implements the settings for the RenderStream plugin.
 */
@@ -17,4 +25,79 @@ class RENDERSTREAM_API URenderStreamSettings : public UObject
     UPROPERTY(EditAnywhere, config, Category = Settings)
     bool bGenerateScenesFromLevels;
     static const bool bGenerateScenesFromLevelsDefault = true;
+
+    // Save the parsed schema as schema.bin next to schema.json, loaded instead of parsing the JSON while it matches.
+    // Stage it with schema.json for packaged builds to start without parsing the JSON.
+    UPROPERTY(EditAnywhere, config, Category = Settings, meta = (DisplayName = "Write Compiled Schema"))
+    bool bWriteCompiledSchema;
+    static const bool bWriteCompiledSchemaDefault = true;
+
+    // Load d3renderstream from here instead of the installed d3, read at startup. -RenderStreamLibrary= on the command
+    // line and the RENDERSTREAM_LIBRARY environment variable take precedence.
+    UPROPERTY(EditAnywhere, config, Category = Settings, meta = (DisplayName = "RenderStream Library Path"))
+    FString LibraryPath;
+
+    // Threads converting host memory frames, including the rendering thread. 0 uses half the hardware threads, up to 16.
+    UPROPERTY(EditAnywhere, config, Category = Conversion, meta = (ClampMin = "0", ClampMax = "64", DisplayName = "Conversion Threads"))
+    int32 ConversionThreads;
+    static const int32 ConversionThreadsDefault = 0;
+
+    // Bit n lets conversion workers run on logical processor n, 0 leaves placement to the OS.
+    UPROPERTY(EditAnywhere, config, Category = Conversion, meta = (DisplayName = "Conversion Affinity Mask"))
+    int64 ConversionAffinityMask;
+    static const int64 ConversionAffinityMaskDefault = 0;
+
+    // Hold the game thread until d3's next frame arrives, at most Frame Lock Timeout, instead of ticking with the newest
+    // frame received so far. Only while a capture is active, and not with the RenderStream Genlock custom time step,
+    // which waits on d3's measured cadence instead.
+    UPROPERTY(EditAnywhere, config, Category = Receive, meta = (DisplayName = "Frame Lock"))
+    bool bFrameLock;
+    static const bool bFrameLockDefault = false;
+
+    UPROPERTY(EditAnywhere, config, Category = Receive, meta = (ClampMin = "1", ClampMax = "1000", EditCondition = "bFrameLock", DisplayName = "Frame Lock Timeout (ms)"))
+    int32 FrameLockTimeoutMs;
+    static const int32 FrameLockTimeoutMsDefault = 100;
+
+    // How float, vector and colour parameters move on engine frames between d3's frames, when the engine ticks faster
+    // than d3 sends. Interpolated parameters run one d3 frame behind, booleans and integers switch as they arrive.
+    UPROPERTY(EditAnywhere, config, Category = Receive, meta = (DisplayName = "Parameter Interpolation"))
+    ERenderStreamParameterInterpolation ParameterInterpolation;
+    static const ERenderStreamParameterInterpolation ParameterInterpolationDefault = ERenderStreamParameterInterpolation::STEP;
+
+    // Keep the levels of other scenes in the schema loaded but hidden, so that d3 switching scene only shows a level
+    // that is already loaded. Measured against the size of the level packages on disk, least recently shown scenes are
+    // unloaded first. 0 loads a scene's level when d3 first switches to it.
+    UPROPERTY(EditAnywhere, config, Category = Scenes, meta = (ClampMin = "0", DisplayName = "Scene Residency Budget (MB)"))
+    int32 SceneResidencyBudgetMB;
+    static const int32 SceneResidencyBudgetMBDefault = 2048;
+
+    // Lower the resolution the scene renders at while frames take longer than d3's frame period allows, and raise it
+    // again once they fit, so that frames keep pace with d3 instead of dropping. The engine upscales to the stream size.
+    // Drives r.ScreenPercentage while a capture is active, and puts it back after.
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (DisplayName = "Dynamic Resolution"))
+    bool bDynamicResolution;
+    static const bool bDynamicResolutionDefault = false;
+
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (ClampMin = "10", ClampMax = "100", EditCondition = "bDynamicResolution", DisplayName = "Min Screen Percentage"))
+    int32 DynamicResolutionMinPercent;
+    static const int32 DynamicResolutionMinPercentDefault = 50;
+
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (ClampMin = "10", ClampMax = "100", EditCondition = "bDynamicResolution", DisplayName = "Max Screen Percentage"))
+    int32 DynamicResolutionMaxPercent;
+    static const int32 DynamicResolutionMaxPercentDefault = 100;
+
+    // Of d3's frame period that the GPU or the rendering thread may take for a frame before the resolution drops.
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (ClampMin = "10", ClampMax = "100", EditCondition = "bDynamicResolution", DisplayName = "Frame Budget (%)"))
+    int32 DynamicResolutionBudgetPercent;
+    static const int32 DynamicResolutionBudgetPercentDefault = 90;
+
+    // How far below the budget, in percent of d3's frame period, frames have to stay for Raise Frames before the
+    // resolution rises again.
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (ClampMin = "1", ClampMax = "50", EditCondition = "bDynamicResolution", DisplayName = "Hysteresis (%)"))
+    int32 DynamicResolutionHysteresisPercent;
+    static const int32 DynamicResolutionHysteresisPercentDefault = 15;
+
+    UPROPERTY(EditAnywhere, config, Category = DynamicResolution, meta = (ClampMin = "1", ClampMax = "600", EditCondition = "bDynamicResolution", DisplayName = "Raise Frames"))
+    int32 DynamicResolutionRaiseFrames;
+    static const int32 DynamicResolutionRaiseFramesDefault = 30;
 };
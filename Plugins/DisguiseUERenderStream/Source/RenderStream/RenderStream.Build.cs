@@ -10,13 +10,25 @@ public class RenderStream : ModuleRules
 	{
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
 
-        PublicIncludePaths.AddRange (new string [] { "RenderStream/Private", 
-			Path.Combine(EngineDirectory, "Source/Runtime/D3D12RHI/Private"), 
-			Path.Combine(EngineDirectory, "Source/Runtime/D3D12RHI/Public"),
-			Path.Combine(EngineDirectory, "Source/ThirdParty/Windows/D3DX12/Include") }); 
+        PublicIncludePaths.AddRange (new string [] { "RenderStream/Private" });
 		
 		PublicDependencyModuleNames.AddRange (new string[] { "Core", "Sockets", "Networking", "MediaIOCore", "MediaUtils", "InputCore", "UMG" });
-		PrivateDependencyModuleNames.AddRange (new string[] { "CoreUObject", "Engine", "Slate", "SlateCore", "CinematicCamera", "RHI", "D3D11RHI", "D3D12RHI", "RenderCore", "Projects", "Json", "JsonUtilities" });
+		PrivateDependencyModuleNames.AddRange (new string[] { "CoreUObject", "Engine", "Slate", "SlateCore", "CinematicCamera", "RHI", "RenderCore", "Projects" });
+
+		// Uncompressed streams share D3D textures with d3. Elsewhere only host memory streams are available, sent
+		// through a d3renderstream stand-in such as Tools/Loopback.
+		if (Target.Platform == UnrealTargetPlatform.Win64)
+		{
+			PublicIncludePaths.AddRange (new string [] { 
+				Path.Combine(EngineDirectory, "Source/Runtime/D3D12RHI/Private"), 
+				Path.Combine(EngineDirectory, "Source/Runtime/D3D12RHI/Public"),
+				Path.Combine(EngineDirectory, "Source/ThirdParty/Windows/D3DX12/Include") }); 
+			PrivateDependencyModuleNames.AddRange (new string[] { "D3D11RHI", "D3D12RHI" });
+		}
+		else if (Target.Platform == UnrealTargetPlatform.Linux)
+		{
+			PublicSystemLibraries.Add("dl");
+		}
 		
 		DynamicallyLoadedModuleNames.AddRange (new string[] {});
 	}
@@ -9,10 +9,12 @@
 #include "PropertyEditorDelegates.h"
 #include "PropertyEditorModule.h"
 #include "UObject/UObjectBase.h"
-#include "Json/Public/Serialization/JsonSerializer.h"
 #include "Engine/LevelStreaming.h"
 #include "Engine/LevelScriptActor.h"
 #include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
 
 #include "ISettingsModule.h"
 #include "RenderStreamSettings.h"
@@ -38,6 +40,7 @@ void FRenderStreamEditorModule::StartupModule()
     FWorldDelegates::LevelAddedToWorld.AddRaw(this, &FRenderStreamEditorModule::OnSchemasChanged);
     FWorldDelegates::LevelRemovedFromWorld.AddRaw(this, &FRenderStreamEditorModule::OnSchemasChanged);
     FWorldDelegates::OnPostWorldInitialization.AddRaw(this, &FRenderStreamEditorModule::OnSchemasChanged);
+    FEditorDelegates::PreBeginPIE.AddRaw(this, &FRenderStreamEditorModule::OnPreBeginPIE);
     if (GEditor)
     {
         GEditor->OnBlueprintCompiled().AddRaw(this, &FRenderStreamEditorModule::OnSchemasChanged);
@@ -48,9 +51,17 @@ void FRenderStreamEditorModule::ShutdownModule()
 {
     FWorldDelegates::LevelAddedToWorld.RemoveAll(this);
     FWorldDelegates::LevelRemovedFromWorld.RemoveAll(this);
+    FWorldDelegates::OnPostWorldInitialization.RemoveAll(this);
+    FEditorDelegates::PreBeginPIE.RemoveAll(this);
     if (GEditor)
         GEditor->OnBlueprintCompiled().RemoveAll(this);
 
+    if (SchemasTicker.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(SchemasTicker);
+        SchemasTicker.Reset();
+    }
+
     // unregister settings
     ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings");
 
@@ -60,7 +71,7 @@ void FRenderStreamEditorModule::ShutdownModule()
     }
 }
 
-TSharedPtr< FJsonObject > createField(FString group, FString displayName_, FString suffix, FString key_, FString undecoratedSuffix, float min, float max, float step, float defaultValue, TArray<FString> options = {})
+void writeField(SchemaWriter& Writer, FString group, FString displayName_, FString suffix, FString key_, FString undecoratedSuffix, float min, float max, float step, float defaultValue, const TArray<FString>& options = {})
 {
     FString key = key_ + (undecoratedSuffix.IsEmpty() ? "" : "_" + undecoratedSuffix);
     FString displayName = displayName_ + (suffix.IsEmpty() ? "" : " " + suffix);
@@ -72,22 +83,23 @@ TSharedPtr< FJsonObject > createField(FString group, FString displayName_, FStri
         step = 1;
     }
 
-    TSharedPtr< FJsonObject > JsonParameter = MakeShareable(new FJsonObject);
-    JsonParameter->SetStringField("group", group);
-    JsonParameter->SetStringField("displayName", displayName);
-    JsonParameter->SetStringField("key", key);
-    JsonParameter->SetNumberField("min", min);
-    JsonParameter->SetNumberField("max", max);
-    JsonParameter->SetNumberField("step", step);
-    JsonParameter->SetNumberField("defaultValue", defaultValue);
-    TArray< TSharedPtr<FJsonValue> > JsonParameterOptions;
+    // The conversions live until the parameter has been written.
+    const FTCHARToUTF8 Group(*group);
+    const FTCHARToUTF8 DisplayName(*displayName);
+    const FTCHARToUTF8 Key(*key);
+    SchemaParameter Parameter;
+    Parameter.group = Group.Get();
+    Parameter.displayName = DisplayName.Get();
+    Parameter.key = Key.Get();
+    Parameter.min = min;
+    Parameter.max = max;
+    Parameter.step = step;
+    Parameter.defaultValue = defaultValue;
+
+    Writer.beginParameter(Parameter);
     for (const FString& option : options)
-        JsonParameterOptions.Add(MakeShareable(new FJsonValueString(option)));
-    JsonParameter->SetArrayField("options", JsonParameterOptions);
-    JsonParameter->SetNumberField("dmxOffset", -1);
-    JsonParameter->SetNumberField("dmxType", 2); // Dmx16LittleEndian
-
-    return JsonParameter;
+        Writer.option(FTCHARToUTF8(*option).Get());
+    Writer.endParameter();
 }
 
 TArray<FString> EnumOptions(const FNumericProperty* NumericProperty)
@@ -106,29 +118,92 @@ TArray<FString> EnumOptions(const FNumericProperty* NumericProperty)
     return Options;
 }
 
-TSharedPtr<FJsonObject> FRenderStreamEditorModule::GenerateSchema(FString Scene, const AActor* Root, const AActor* PersistentRoot)
+struct FParameterHasher
 {
-    TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+    uint64 Hash = 0;
 
-    TArray< TSharedPtr<FJsonValue> > JsonParameters = GenerateJSONParameters(PersistentRoot);
-    const int32 nPersistentParameters = JsonParameters.Num();
+    void Add(const void* Data, int32 Size) { Hash = CityHash64WithSeed(static_cast<const char*>(Data), uint32(Size), Hash); }
+    void Add(const FString& String)
+    {
+        const int32 Len = String.Len();
+        Add(&Len, sizeof(Len));
+        Add(*String, Len * sizeof(TCHAR));
+    }
+};
+
+// Hashes everything GenerateSchemaParameters reads from Root: the name, type, metadata, enum options and value of each
+// exposed property. This walks the same properties without logging or writing JSON.
+uint64 HashExposedProperties(const AActor* Root)
+{
+    FParameterHasher Hasher;
+    if (!Root)
+        return Hasher.Hash;
+    for (TFieldIterator<FProperty> PropIt(Root->GetClass(), EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
+    {
+        const FProperty* Property = *PropIt;
+        if (!Property->HasAllPropertyFlags(CPF_Edit | CPF_BlueprintVisible) || Property->HasAllPropertyFlags(CPF_DisableEditOnInstance))
+            continue;
+
+        Hasher.Add(Property->GetName());
+        Hasher.Add(Property->GetClass()->GetName());
+        Hasher.Add(Property->GetMetaData("Category"));
+        const bool HasLimits = Property->HasMetaData("ClampMin") && Property->HasMetaData("ClampMax");
+        Hasher.Add(&HasLimits, sizeof(HasLimits));
+        if (HasLimits)
+        {
+            Hasher.Add(Property->GetMetaData("ClampMin"));
+            Hasher.Add(Property->GetMetaData("ClampMax"));
+        }
 
-    JsonParameters.Append(GenerateJSONParameters(Root));
-    const int32 nLevelParameters = JsonParameters.Num() - nPersistentParameters;
+        if (const FBoolProperty* BoolProperty = CastField<const FBoolProperty>(Property))
+        {
+            const bool v = BoolProperty->GetPropertyValue_InContainer(Root);
+            Hasher.Add(&v, sizeof(v));
+        }
+        else if (CastField<const FByteProperty>(Property) || CastField<const FIntProperty>(Property) || CastField<const FFloatProperty>(Property))
+        {
+            for (const FString& Option : EnumOptions(CastFieldChecked<const FNumericProperty>(Property)))
+                Hasher.Add(Option);
+            Hasher.Add(Property->ContainerPtrToValuePtr<void>(Root), Property->ElementSize);
+        }
+        else if (const FStructProperty* StructProperty = CastField<const FStructProperty>(Property))
+        {
+            Hasher.Add(StructProperty->Struct->GetPathName());
+            if (StructProperty->Struct == TBaseStructure<FVector>::Get() ||
+                StructProperty->Struct == TBaseStructure<FColor>::Get() ||
+                StructProperty->Struct == TBaseStructure<FLinearColor>::Get())
+            {
+                Hasher.Add(StructProperty->ContainerPtrToValuePtr<void>(Root), StructProperty->ElementSize);
+            }
+        }
+    }
+    return Hasher.Hash;
+}
 
-    JsonObject->SetStringField("name", Scene);
-    JsonObject->SetArrayField("parameters", JsonParameters);
-    JsonObject->SetNumberField("nPersistentParameters", nPersistentParameters);
-    JsonObject->SetNumberField("nLevelParameters", nLevelParameters);
+const FRenderStreamEditorModule::FSchemaParameters& FRenderStreamEditorModule::CachedSchemaParameters(const AActor* Root, TSet<uint64>& Used)
+{
+    const uint64 Hash = HashExposedProperties(Root);
+    Used.Add(Hash);
+    auto It = ParameterCache.find(Hash);
+    if (It != ParameterCache.end())
+        return It->second;
+    return ParameterCache.emplace(Hash, GenerateSchemaParameters(Root)).first->second;
+}
 
-    return JsonObject;
+void FRenderStreamEditorModule::WriteScene(const FString& Scene, const FSchemaParameters& Parameters, const FSchemaParameters& PersistentParameters)
+{
+    Schema.beginScene(FTCHARToUTF8(*Scene).Get());
+    Schema.parameters(PersistentParameters.Json);
+    Schema.parameters(Parameters.Json);
+    Schema.endScene(PersistentParameters.Count, Parameters.Count);
 }
 
-TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameters(const AActor* Root)
+FRenderStreamEditorModule::FSchemaParameters FRenderStreamEditorModule::GenerateSchemaParameters(const AActor* Root)
 {
-    TArray< TSharedPtr<FJsonValue> > JsonParameters;
+    FSchemaParameters Parameters;
     if (!Root)
-        return JsonParameters;
+        return Parameters;
+    SchemaWriter Writer;
     for (TFieldIterator<FProperty> PropIt(Root->GetClass(), EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
     {
         const FProperty* Property = *PropIt;
@@ -142,7 +217,7 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
         {
             const bool v = BoolProperty->GetPropertyValue_InContainer(Root);
             UE_LOG(LogRenderStreamEditor, Log, TEXT("Exposed bool property: %s is %d"), *Name, v);
-            JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "", Name, "", 0.f, 1.f, 1.f, v ? 1.f : 0.f, { "Off", "On" }))));
+            writeField(Writer, Category, Name, "", Name, "", 0.f, 1.f, 1.f, v ? 1.f : 0.f, { "Off", "On" });
         }
         else if (const FByteProperty* ByteProperty = CastField<const FByteProperty>(Property))
         {
@@ -152,7 +227,7 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
             const bool HasLimits = Property->HasMetaData("ClampMin") && Property->HasMetaData("ClampMax");
             const float Min = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMin")) : 0;
             const float Max = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMax")) : 255;
-            JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "", Name, "", Min, Max, 1.f, float(v), Options))));
+            writeField(Writer, Category, Name, "", Name, "", Min, Max, 1.f, float(v), Options);
         }
         else if (const FIntProperty* IntProperty = CastField<const FIntProperty>(Property))
         {
@@ -162,7 +237,7 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
             const bool HasLimits = Property->HasMetaData("ClampMin") && Property->HasMetaData("ClampMax");
             const float Min = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMin")) : -1000;
             const float Max = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMax")) : +1000;
-            JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "", Name, "", Min, Max, 1.f, float(v), Options))));
+            writeField(Writer, Category, Name, "", Name, "", Min, Max, 1.f, float(v), Options);
         }
         else if (const FFloatProperty* FloatProperty = CastField<const FFloatProperty>(Property))
         {
@@ -171,7 +246,7 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
             const bool HasLimits = Property->HasMetaData("ClampMin") && Property->HasMetaData("ClampMax");
             const float Min = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMin")) : -1;
             const float Max = HasLimits ? FCString::Atof(*Property->GetMetaData("ClampMax")) : +1;
-            JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "", Name, "", Min, Max, 0.001f, v))));
+            writeField(Writer, Category, Name, "", Name, "", Min, Max, 0.001f, v);
         }
         else if (const FStructProperty* StructProperty = CastField<const FStructProperty>(Property))
         {
@@ -181,29 +256,29 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
                 FVector v;
                 StructProperty->CopyCompleteValue(&v, StructAddress);
                 UE_LOG(LogRenderStreamEditor, Log, TEXT("Exposed vector property: %s is <%f, %f, %f>"), *Name, v.X, v.Y, v.Z);
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "x", Name, "x", -1.f, +1.f, 0.001f, v.X))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "y", Name, "y", -1.f, +1.f, 0.001f, v.Y))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "z", Name, "z", -1.f, +1.f, 0.001f, v.Z))));
+                writeField(Writer, Category, Name, "x", Name, "x", -1.f, +1.f, 0.001f, v.X);
+                writeField(Writer, Category, Name, "y", Name, "y", -1.f, +1.f, 0.001f, v.Y);
+                writeField(Writer, Category, Name, "z", Name, "z", -1.f, +1.f, 0.001f, v.Z);
             }
             else if (StructProperty->Struct == TBaseStructure<FColor>::Get())
             {
                 FColor v;
                 StructProperty->CopyCompleteValue(&v, StructAddress);
                 UE_LOG(LogRenderStreamEditor, Log, TEXT("Exposed colour property: %s is <%d, %d, %d, %d>"), *Name, v.R, v.G, v.B, v.A);
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "r", Name, "r", 0.f, 1.f, 0.0001f, v.R / 255.f))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "g", Name, "g", 0.f, 1.f, 0.0001f, v.G / 255.f))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "b", Name, "b", 0.f, 1.f, 0.0001f, v.B / 255.f))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "a", Name, "a", 0.f, 1.f, 0.0001f, v.A / 255.f))));
+                writeField(Writer, Category, Name, "r", Name, "r", 0.f, 1.f, 0.0001f, v.R / 255.f);
+                writeField(Writer, Category, Name, "g", Name, "g", 0.f, 1.f, 0.0001f, v.G / 255.f);
+                writeField(Writer, Category, Name, "b", Name, "b", 0.f, 1.f, 0.0001f, v.B / 255.f);
+                writeField(Writer, Category, Name, "a", Name, "a", 0.f, 1.f, 0.0001f, v.A / 255.f);
             }
             else if (StructProperty->Struct == TBaseStructure<FLinearColor>::Get())
             {
                 FLinearColor v;
                 StructProperty->CopyCompleteValue(&v, StructAddress);
                 UE_LOG(LogRenderStreamEditor, Log, TEXT("Exposed linear colour property: %s is <%f, %f, %f, %f>"), *Name, v.R, v.G, v.B, v.A);
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "r", Name, "r", 0.f, 1.f, 0.0001f, v.R))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "g", Name, "g", 0.f, 1.f, 0.0001f, v.G))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "b", Name, "b", 0.f, 1.f, 0.0001f, v.B))));
-                JsonParameters.Add(MakeShareable(new FJsonValueObject(createField(Category, Name, "a", Name, "a", 0.f, 1.f, 0.0001f, v.A))));
+                writeField(Writer, Category, Name, "r", Name, "r", 0.f, 1.f, 0.0001f, v.R);
+                writeField(Writer, Category, Name, "g", Name, "g", 0.f, 1.f, 0.0001f, v.G);
+                writeField(Writer, Category, Name, "b", Name, "b", 0.f, 1.f, 0.0001f, v.B);
+                writeField(Writer, Category, Name, "a", Name, "a", 0.f, 1.f, 0.0001f, v.A);
             }
             else
             {
@@ -217,18 +292,24 @@ TArray< TSharedPtr<FJsonValue> >FRenderStreamEditorModule::GenerateJSONParameter
     }
     UE_LOG(LogRenderStreamEditor, Log, TEXT("Generated schema"));
 
-    return JsonParameters;
+    Parameters.Json = Writer.text();
+    Parameters.Count = Writer.parameterCount();
+    return Parameters;
 }
 
 
 void FRenderStreamEditorModule::GenerateSchemas(const UWorld& World)
 {
-    TArray< TSharedPtr<FJsonValue> > JsonSchemas;
+    TSet<uint64> Used;
+    Schema.clear();
+    Schema.beginSchemas();
 
     const AActor* persistentActor = World.PersistentLevel->GetLevelScriptActor();
+    const FSchemaParameters NoParameters;
+    const FSchemaParameters& PersistentParameters = CachedSchemaParameters(persistentActor, Used);
 
     FString Scene = "Persistent Level";
-    JsonSchemas.Add(MakeShareable(new FJsonValueObject(GenerateSchema(Scene, nullptr, persistentActor))));
+    WriteScene(Scene, NoParameters, PersistentParameters);
 
     const URenderStreamSettings* settings = GetDefault<URenderStreamSettings>();
     if (settings ? settings->bGenerateScenesFromLevels : URenderStreamSettings::bGenerateScenesFromLevelsDefault)
@@ -240,43 +321,99 @@ void FRenderStreamEditorModule::GenerateSchemas(const UWorld& World)
             Scene = FPackageName::GetLongPackageAssetName(streamingLevel->GetWorldAssetPackageName());
             if (streamingLevel->GetWorld())
                 Scene.RemoveFromStart(streamingLevel->GetWorld()->StreamingLevelsPrefix);
-            JsonSchemas.Add(MakeShareable(new FJsonValueObject(GenerateSchema(Scene, streamingLevel->GetLevelScriptActor(), persistentActor))));
+            WriteScene(Scene, CachedSchemaParameters(streamingLevel->GetLevelScriptActor(), Used), PersistentParameters);
         }
     }
+    Schema.endSchemas();
 
-    FString Schema;
-    TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Schema);
-    FJsonSerializer::Serialize(JsonSchemas, Writer);
+    // Levels that are gone or have changed since. Entries are never moved, so PersistentParameters is still valid.
+    for (auto It = ParameterCache.begin(); It != ParameterCache.end();)
+    {
+        if (Used.Contains(It->first))
+            ++It;
+        else
+            It = ParameterCache.erase(It);
+    }
 
+    // Rewriting an unchanged file would only make the runtime and anything watching the file look at it again.
     FString SchemaPath = FPaths::Combine(*FPaths::ProjectContentDir(), *FString("DisguiseRenderStream"), *FString("schema.json"));
-    FFileHelper::SaveStringToFile(Schema, *SchemaPath);
+    const std::string& Text = Schema.text();
+    if (WrittenSchema.empty())
+    {
+        TArray<uint8> Bytes;
+        if (FFileHelper::LoadFileToArray(Bytes, *SchemaPath, FILEREAD_Silent))
+            WrittenSchema.assign(reinterpret_cast<const char*>(Bytes.GetData()), size_t(Bytes.Num()));
+    }
+    if (Text == WrittenSchema)
+        return;
+
+    // UTF-8 without a BOM, which the runtime passes to d3 as it is.
+    if (FFileHelper::SaveArrayToFile(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Text.data()), int32(Text.size())), *SchemaPath))
+    {
+        UE_LOG(LogRenderStreamEditor, Log, TEXT("Wrote schema %s"), *SchemaPath);
+        WrittenSchema = Text;
+    }
 }
 
-void FRenderStreamEditorModule::OnSchemasChanged()
+void FRenderStreamEditorModule::ScheduleSchemas()
+{
+    LastSchemasChange = FPlatformTime::Seconds();
+    if (!SchemasTicker.IsValid())
+        SchemasTicker = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRenderStreamEditorModule::OnSchemasTicker));
+}
+
+bool FRenderStreamEditorModule::OnSchemasTicker(float /* DeltaTime */)
 {
+    if (FPlatformTime::Seconds() - LastSchemasChange < SchemaDebounceSeconds)
+        return true;
+
+    SchemasTicker.Reset();
     if (GameWorld.IsValid())
         GenerateSchemas(*GameWorld.Get());
+    return false;
+}
+
+void FRenderStreamEditorModule::FlushSchemas()
+{
+    if (SchemasTicker.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(SchemasTicker);
+        SchemasTicker.Reset();
+    }
+    if (GameWorld.IsValid())
+        GenerateSchemas(*GameWorld.Get());
+}
+
+void FRenderStreamEditorModule::OnPreBeginPIE(const bool /* bIsSimulating */)
+{
+    // The game reads the schema as soon as it starts capturing, it cannot wait for the debounce.
+    if (SchemasTicker.IsValid())
+        FlushSchemas();
+}
+
+void FRenderStreamEditorModule::OnSchemasChanged()
+{
+    ScheduleSchemas();
 }
 
 void FRenderStreamEditorModule::OnSchemasChanged(ULevel*, UWorld* World)
 {  
     GameWorld = TWeakObjectPtr<UWorld>(World);
-    if (World)
-        GenerateSchemas(*World);
+    ScheduleSchemas();
 }
 
 void FRenderStreamEditorModule::OnSchemasChanged(UWorld* World)
 {
     GameWorld = TWeakObjectPtr<UWorld>(World);
-    if (World)
-        GenerateSchemas(*World);
+    ScheduleSchemas();
 }
 
 void FRenderStreamEditorModule::OnSchemasChanged(UWorld* World, const UWorld::InitializationValues /* IV */)
 {
+    // A new world is generated right away, as before, so that a game starting in it finds its schema in place.
     GameWorld = TWeakObjectPtr<UWorld>(World);
     if (World)
-        GenerateSchemas(*World);
+        FlushSchemas();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -2,7 +2,9 @@
 
 #include "Core.h"
 #include "Modules/ModuleInterface.h"
-#include "Json/Public/Dom/JsonObject.h"
+#include "SchemaJson.hpp"
+#include <map>
+#include <string>
 
 class ULevel;
 class UWorld;
@@ -17,14 +19,39 @@ public:
     virtual void ShutdownModule() override;
 
 private:
+    // Events arrive in bursts, a level load adds every streaming level and a blueprint compile may touch many
+    // blueprints, so the schema is generated once they have been quiet for this long.
+    static constexpr double SchemaDebounceSeconds = 0.5;
+
     void OnSchemasChanged();
     void OnSchemasChanged(UWorld* World);
     void OnSchemasChanged(ULevel* Level, UWorld* World);
     void OnSchemasChanged(UWorld* World, const UWorld::InitializationValues IV);
+    void OnPreBeginPIE(const bool bIsSimulating);
+    void ScheduleSchemas();
+    bool OnSchemasTicker(float DeltaTime);
+    void FlushSchemas();
     void GenerateSchemas(const UWorld& World);
 
     TWeakObjectPtr<UWorld> GameWorld;
+    FDelegateHandle SchemasTicker;
+    double LastSchemasChange = 0.;
+
+    // Parameters of a level script actor, already written as schema JSON.
+    struct FSchemaParameters
+    {
+        std::string Json;
+        uint32 Count = 0;
+    };
+
+    // Generated parameters of each level script actor, keyed by the hash of everything they are generated from, so
+    // only levels whose exposed properties changed are generated again.
+    std::map<uint64, FSchemaParameters> ParameterCache;
+    SchemaWriter Schema;
+    std::string WrittenSchema;
+
+    const FSchemaParameters& CachedSchemaParameters(const AActor* Root, TSet<uint64>& Used);
 
-    TSharedPtr<FJsonObject> GenerateSchema(FString Scene, const AActor* Root, const AActor* PersistentRoot);
-    TArray< TSharedPtr<FJsonValue> > GenerateJSONParameters(const AActor* Root);
+    void WriteScene(const FString& Scene, const FSchemaParameters& Parameters, const FSchemaParameters& PersistentParameters);
+    FSchemaParameters GenerateSchemaParameters(const AActor* Root);
 };
@@ -7,8 +7,8 @@ public class RenderStreamEditor : ModuleRules
 	public RenderStreamEditor(ReadOnlyTargetRules Target) : base(Target)
     {
         PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
-        PrivateIncludePaths.AddRange(new string[] {"RenderStreamEditor/Private"});
+        PrivateIncludePaths.AddRange(new string[] {"RenderStreamEditor/Private", "RenderStream/Private"});
         PublicDependencyModuleNames.AddRange(new string[] { "Core" });
-        PrivateDependencyModuleNames.AddRange (new string[] { "CoreUObject", "Engine", "UnrealEd", "RenderStream", "Json", "JsonUtilities"});
+        PrivateDependencyModuleNames.AddRange (new string[] { "CoreUObject", "Engine", "UnrealEd", "RenderStream"});
     }
 }
@@ -0,0 +1,171 @@
+#pragma once
+
+// What the standalone benchmarks share: the timing loop, the options every one of them takes, and results written as
+// JSON with one result object per line, which is what lets --compare read an earlier run back without a JSON parser.
+// Each benchmark formats its own result lines and prints its own comparison.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BenchmarkHarness
+{
+    struct Options
+    {
+        double minSeconds = 0.25;   // Per case, after one warm-up run
+        int minIterations = 5;
+        std::string label;
+        std::string out;
+        std::string compare;
+    };
+
+    struct Timing
+    {
+        int iterations = 0;
+        double medianSeconds = 0.;
+        double bestSeconds = 0.;
+    };
+
+    inline bool matches(const std::string& filter, const std::string& value)
+    {
+        return filter.empty() || value.find(filter) != std::string::npos;
+    }
+
+    // Runs fn once to warm up, calls started, then runs fn until both minimums are met.
+    template <typename Fn, typename Started>
+    Timing measure(const Options& options, Fn fn, Started started)
+    {
+        typedef std::chrono::steady_clock Clock;
+        fn();
+        started();
+
+        std::vector<double> times;
+        const Clock::time_point start = Clock::now();
+        do
+        {
+            const Clock::time_point begin = Clock::now();
+            fn();
+            times.push_back(std::chrono::duration<double>(Clock::now() - begin).count());
+        } while (int(times.size()) < options.minIterations || std::chrono::duration<double>(Clock::now() - start).count() < options.minSeconds);
+
+        std::sort(times.begin(), times.end());
+        Timing timing;
+        timing.iterations = int(times.size());
+        timing.medianSeconds = times[times.size() / 2];
+        timing.bestSeconds = times.front();
+        return timing;
+    }
+
+    template <typename Fn>
+    Timing measure(const Options& options, Fn fn)
+    {
+        return measure(options, fn, [] {});
+    }
+
+    // Takes the options every benchmark has. False when the argument is not one of them.
+    inline bool parseOption(Options& options, const std::string& arg, const char* value)
+    {
+        if (arg == "--label") options.label = value;
+        else if (arg == "--out") options.out = value;
+        else if (arg == "--compare") options.compare = value;
+        else return false;
+        return true;
+    }
+
+    // Every option takes a value. parse handles the benchmark's own and returns false for unknown ones. Returns the
+    // exit code when the benchmark should stop, after printing usage, or -1 to run.
+    template <typename Parse, typename Usage>
+    int parseArguments(int argc, char** argv, Options& options, Parse parse, Usage usage)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (arg == "--help" || arg == "-h" || !value)
+            {
+                usage();
+                return arg == "--help" || arg == "-h" ? 0 : 1;
+            }
+            ++i;
+            if (!parseOption(options, arg, value) && !parse(arg, value))
+            {
+                usage();
+                return 1;
+            }
+        }
+        return -1;
+    }
+
+    // Usage lines of the options parseOption takes, comparing by what.
+    inline void printCommonUsage(const char* what)
+    {
+        std::printf(
+            "  --label TEXT       stored in the output, e.g. a commit id\n"
+            "  --out FILE         write JSON to FILE instead of stdout\n"
+            "  --compare FILE     print %s against an earlier --out file\n", what);
+    }
+
+    // Header fields are written before the results as they are, so strings come with their quotes.
+    inline void writeJson(std::ostream& out, const Options& options, const std::vector<std::pair<std::string, std::string>>& fields, const std::vector<std::string>& lines)
+    {
+        out << "{\n";
+        out << "\"label\": \"" << options.label << "\",\n";
+        for (const std::pair<std::string, std::string>& field : fields)
+            out << "\"" << field.first << "\": " << field.second << ",\n";
+        out << "\"results\": [\n";
+        for (size_t i = 0; i < lines.size(); ++i)
+            out << lines[i] << (i + 1 < lines.size() ? ",\n" : "\n");
+        out << "]\n}\n";
+    }
+
+    // To --out, or stdout without it.
+    inline void writeResults(const Options& options, const std::vector<std::pair<std::string, std::string>>& fields, const std::vector<std::string>& lines)
+    {
+        if (options.out.empty())
+        {
+            writeJson(std::cout, options, fields, lines);
+        }
+        else
+        {
+            std::ofstream out(options.out);
+            writeJson(out, options, fields, lines);
+        }
+    }
+
+    // Reads back the files writeJson produces, one result per line. Not a general JSON parser. Each key maps to the
+    // numbers of the given fields in order, lines missing any of them are skipped.
+    inline std::map<std::string, std::vector<double>> readBaseline(const std::string& path, const std::vector<std::string>& fields)
+    {
+        std::map<std::string, std::vector<double>> baseline;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const size_t key = line.find("\"key\": \"");
+            if (key == std::string::npos)
+                continue;
+            std::vector<double> values;
+            for (const std::string& field : fields)
+            {
+                const std::string name = "\"" + field + "\": ";
+                const size_t at = line.find(name);
+                if (at == std::string::npos)
+                    break;
+                values.push_back(std::atof(line.c_str() + at + name.size()));
+            }
+            if (values.size() != fields.size())
+                continue;
+            const size_t keyStart = key + 8;
+            baseline[line.substr(keyStart, line.find('"', keyStart) - keyStart)] = std::move(values);
+        }
+        return baseline;
+    }
+}
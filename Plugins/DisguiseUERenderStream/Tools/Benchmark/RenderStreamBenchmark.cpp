@@ -0,0 +1,383 @@
+// Standalone throughput benchmark for the engine-independent parts of the send path: pixel conversion for every
+// SenderPixelFormat and alpha operation, fnvHash/StreamFNV, and conversion followed by a stubbed rs_sendFrame,
+// both inline and through FrameSender. Needs neither Unreal nor a GPU.
+//
+// Build from this directory on Linux (bash):
+//   SRC=../../Source/RenderStream
+//   g++ -std=c++14 -O2 -pthread -I$SRC/Private -I$SRC/Public -o RenderStreamBenchmark RenderStreamBenchmark.cpp
+//       $SRC/Private/{PixelConvert,PixelConvertSSE4,PixelConvertAVX2,PixelConvertAVX512,PixelConvertNEON}.cpp
+//       $SRC/Private/{ConvertScheduler,FrameSender,FrameBufferPool,fnv}.cpp
+// (one command, split here for width)
+//
+// Results are written as JSON, one result object per line, so two runs can be compared with --compare:
+//   ./RenderStreamBenchmark --out before.json
+//   ./RenderStreamBenchmark --out after.json --compare before.json
+
+#include "BenchmarkHarness.hpp"
+#include "ConvertScheduler.hpp"
+#include "FrameBufferPool.hpp"
+#include "FrameSender.hpp"
+#include "PixelConvert.hpp"
+#include "RenderStreamLink.h"
+#include "fnv.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef RenderStreamLink RSL;
+    using BenchmarkHarness::matches;
+
+    struct Size
+    {
+        const char* name;
+        int width;
+        int height;
+    };
+
+    // Double-width sizes are the front/back plate layout, two outputs side by side.
+    const Size Sizes[] = {
+        { "1080p", 1920, 1080 },
+        { "1080p_double", 3840, 1080 },
+        { "4k", 3840, 2160 },
+        { "4k_double", 7680, 2160 },
+        { "8k", 7680, 4320 },
+    };
+
+    struct Options : BenchmarkHarness::Options
+    {
+        size_t threads = 1;         // Conversion threads, 0 picks like the plugin does
+        std::string isa;
+        std::string sizeFilter;
+        std::string formatFilter;
+        std::string group;
+    };
+
+    struct Result
+    {
+        std::string group;
+        std::string name;
+        const Size* size = nullptr;
+        size_t bytes = 0;           // Read plus written per iteration
+        BenchmarkHarness::Timing timing;
+
+        std::string key() const { return group + "/" + name + "/" + size->name; }
+        double nsPerPixel() const { return timing.medianSeconds * 1e9 / (double(size->width) * double(size->height)); }
+        double gigabytesPerSecond() const { return double(bytes) / timing.medianSeconds * 1e-9; }
+    };
+
+    template <typename Fn>
+    Result measure(const Options& options, const std::string& group, const std::string& name, const Size& size, size_t bytes, Fn fn)
+    {
+        Result result;
+        result.group = group;
+        result.name = name;
+        result.size = &size;
+        result.bytes = bytes;
+        result.timing = BenchmarkHarness::measure(options, fn);
+        return result;
+    }
+
+    std::vector<uint8_t> makeSource(PixelConvert::SourceFormat format, const Size& size)
+    {
+        std::vector<uint8_t> data(PixelConvert::sourceBytesPerPixel(format) * size_t(size.width) * size_t(size.height));
+        std::mt19937 rng(1);
+        if (format == PixelConvert::SourceFormat::RGBA16F)
+        {
+            // Halves in [0, 1) so that no kernel takes a saturation shortcut
+            for (size_t i = 0; i + 1 < data.size(); i += 2)
+            {
+                const uint16_t half = uint16_t(0x3000 + rng() % 0x0c00);
+                std::memcpy(&data[i], &half, 2);
+            }
+        }
+        else if (format == PixelConvert::SourceFormat::RGBA32F)
+        {
+            std::uniform_real_distribution<float> value(0.f, 1.f);
+            for (size_t i = 0; i + 3 < data.size(); i += 4)
+            {
+                const float f = value(rng);
+                std::memcpy(&data[i], &f, 4);
+            }
+        }
+        else
+        {
+            for (uint8_t& b : data)
+                b = uint8_t(rng());
+        }
+        return data;
+    }
+
+    // Stands in for the d3 library: reads every cache line of the frame, as the NDI or Rivermax send would.
+    volatile uint64_t g_sink = 0;
+
+    RSL::RS_ERROR stubSendFrame(RSL::AssetHandle, RSL::StreamHandle, RSL::SenderFrameType, void* data, int width, int height, RSL::SenderPixelFormat format, void*)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        // height counts the NDI alpha lines, which are half the size of the colour lines
+        const size_t size = PixelConvert::rowBytes(format, width) * size_t(height);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < size; i += 64)
+            sum += bytes[i];
+        g_sink = g_sink + sum;
+        return RSL::RS_ERROR_SUCCESS;
+    }
+
+    PixelConvert::Image makeImage(const std::vector<uint8_t>& src, PixelConvert::SourceFormat srcFormat, uint8_t* dst, RSL::SenderPixelFormat format, const Size& size)
+    {
+        PixelConvert::Image image;
+        image.src = src.data();
+        image.srcPitch = PixelConvert::sourceBytesPerPixel(srcFormat) * size_t(size.width);
+        image.srcFormat = srcFormat;
+        image.dst = dst;
+        image.dstPitch = PixelConvert::rowBytes(format, size.width);
+        image.dstFormat = format;
+        image.width = size.width;
+        image.height = size.height;
+        return image;
+    }
+
+    // Sources the plugin actually produces: 8-bit readbacks for NDI, float render targets for UC.
+    std::vector<PixelConvert::SourceFormat> sourcesFor(RSL::SenderPixelFormat format)
+    {
+        if (format >= RSL::FMT_UC_YUV422_10BIT)
+            return { PixelConvert::SourceFormat::BGRA8, PixelConvert::SourceFormat::RGBA16F, PixelConvert::SourceFormat::RGBA32F };
+        return { PixelConvert::SourceFormat::BGRA8, PixelConvert::SourceFormat::RGBA16F };
+    }
+
+    void runConvert(const Options& options, ConvertScheduler& scheduler, std::vector<Result>& results)
+    {
+        for (const Size& size : Sizes)
+        {
+            if (!matches(options.sizeFilter, size.name))
+                continue;
+            for (uint32_t f = RSL::FMT_BGRA; f <= RSL::FMT_UC_RGBA_12BIT; ++f)
+            {
+                const RSL::SenderPixelFormat format = RSL::SenderPixelFormat(f);
+                if (!matches(options.formatFilter, PixelConvert::formatName(format)))
+                    continue;
+                std::vector<uint8_t> dst(PixelConvert::frameBytes(format, size.width, size.height));
+                for (PixelConvert::SourceFormat source : sourcesFor(format))
+                {
+                    const std::vector<uint8_t> src = makeSource(source, size);
+                    const PixelConvert::Image image = makeImage(src, source, dst.data(), format, size);
+                    const std::string name = std::string(PixelConvert::sourceFormatName(source)) + "_to_" + PixelConvert::formatName(format);
+                    results.push_back(measure(options, "convert", name, size, src.size() + dst.size(), [&] { scheduler.convert(image); }));
+                }
+            }
+        }
+    }
+
+    void runAlpha(const Options& options, ConvertScheduler& scheduler, std::vector<Result>& results)
+    {
+        const RSL::SenderPixelFormat formats[] = { RSL::FMT_BGRA, RSL::FMT_UYVY_422, RSL::FMT_NDI_UYVY_422_A, RSL::FMT_UC_RGBA_10BIT };
+        for (const Size& size : Sizes)
+        {
+            if (!matches(options.sizeFilter, size.name))
+                continue;
+            const std::vector<uint8_t> bytes = makeSource(PixelConvert::SourceFormat::BGRA8, size);
+            const std::vector<uint8_t> halves = makeSource(PixelConvert::SourceFormat::RGBA16F, size);
+            for (RSL::SenderPixelFormat format : formats)
+            {
+                if (!matches(options.formatFilter, PixelConvert::formatName(format)))
+                    continue;
+                // UC formats see float render targets, the rest 8-bit readbacks
+                const bool uc = format >= RSL::FMT_UC_YUV422_10BIT;
+                const PixelConvert::SourceFormat source = uc ? PixelConvert::SourceFormat::RGBA16F : PixelConvert::SourceFormat::BGRA8;
+                const std::vector<uint8_t>& src = uc ? halves : bytes;
+                std::vector<uint8_t> dst(PixelConvert::frameBytes(format, size.width, size.height));
+                for (uint32_t op = 0; op < uint32_t(PixelConvert::AlphaOp::Count); ++op)
+                {
+                    PixelConvert::Image image = makeImage(src, source, dst.data(), format, size);
+                    image.alphaOp = PixelConvert::AlphaOp(op);
+                    const std::string name = std::string(PixelConvert::formatName(format)) + "_" + PixelConvert::alphaOpName(image.alphaOp);
+                    results.push_back(measure(options, "alpha", name, size, src.size() + dst.size(), [&] { scheduler.convert(image); }));
+                }
+            }
+        }
+    }
+
+    void runHash(const Options& options, std::vector<Result>& results)
+    {
+        for (const Size& size : Sizes)
+        {
+            if (!matches(options.sizeFilter, size.name))
+                continue;
+            const std::vector<uint8_t> src = makeSource(PixelConvert::SourceFormat::BGRA8, size);
+            results.push_back(measure(options, "hash", "fnvHash", size, src.size(), [&] { g_sink = g_sink + fnvHash(src.data(), src.size()); }));
+
+            // Row sized chunks, the way a frame or schema arrives in pieces
+            const size_t chunk = size_t(size.width) * 4;
+            results.push_back(measure(options, "hash", "StreamFNV", size, src.size(), [&]
+            {
+                StreamFNV fnv;
+                for (size_t offset = 0; offset < src.size(); offset += chunk)
+                    fnv.addData(src.data() + offset, std::min(chunk, src.size() - offset));
+                g_sink = g_sink + fnv.getHash();
+            }));
+        }
+    }
+
+    void runSend(const Options& options, ConvertScheduler& scheduler, std::vector<Result>& results)
+    {
+        const RSL::SenderPixelFormat formats[] = { RSL::FMT_BGRA, RSL::FMT_NDI_UYVY_422_A, RSL::FMT_UC_YUV422_10BIT };
+        // Called through a pointer, as the plugin calls the loaded library
+        RSL::RS_ERROR (*sendFrame)(RSL::AssetHandle, RSL::StreamHandle, RSL::SenderFrameType, void*, int, int, RSL::SenderPixelFormat, void*) = &stubSendFrame;
+        for (const Size& size : Sizes)
+        {
+            if (!matches(options.sizeFilter, size.name))
+                continue;
+            const std::vector<uint8_t> src = makeSource(PixelConvert::SourceFormat::BGRA8, size);
+            for (RSL::SenderPixelFormat format : formats)
+            {
+                if (!matches(options.formatFilter, PixelConvert::formatName(format)))
+                    continue;
+                const size_t frameBytes = PixelConvert::frameBytes(format, size.width, size.height);
+                const int width = size.width;
+                const int height = int(frameBytes / PixelConvert::rowBytes(format, size.width));
+
+                // Convert and send on the calling thread, as the plugin does without asynchronous sending
+                std::vector<uint8_t> dst(frameBytes);
+                const PixelConvert::Image image = makeImage(src, PixelConvert::SourceFormat::BGRA8, dst.data(), format, size);
+                results.push_back(measure(options, "send", std::string("inline_") + PixelConvert::formatName(format), size, src.size() + 2 * frameBytes, [&]
+                {
+                    scheduler.convert(image);
+                    sendFrame(0, 0, RSL::RS_FRAMETYPE_HOST_MEMORY, dst.data(), width, height, format, nullptr);
+                }));
+
+                // Convert into a pooled buffer and hand it to the sender thread. Block keeps every frame, so the
+                // time covers the slower of the two threads.
+                FrameSender sender([sendFrame](FrameSender::Frame& frame)
+                {
+                    return sendFrame(0, 0, frame.frameType, frame.data, frame.width, frame.height, frame.format, &frame.response);
+                }, 3, FrameSender::Policy::Block);
+                std::shared_ptr<FrameBufferPool> pool = FrameBufferPool::create(sender.capacity() + 2, frameBytes, FrameBufferPool::FLAG_NONE);
+                results.push_back(measure(options, "send", std::string("async_") + PixelConvert::formatName(format), size, src.size() + 2 * frameBytes, [&]
+                {
+                    FrameBufferPool::Buffer buffer = pool->acquire();
+                    while (!buffer)
+                    {
+                        std::this_thread::yield();
+                        buffer = pool->acquire();
+                    }
+                    PixelConvert::Image pooled = image;
+                    pooled.dst = buffer.data();
+                    scheduler.convert(pooled);
+
+                    FrameSender::Frame frame;
+                    frame.data = buffer.data();
+                    frame.buffer = std::move(buffer);
+                    frame.width = width;
+                    frame.height = height;
+                    frame.format = format;
+                    sender.enqueue(std::move(frame));
+                }));
+                sender.stop(true);
+            }
+        }
+    }
+
+    std::string resultJson(const Result& result)
+    {
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "{\"key\": \"%s\", \"group\": \"%s\", \"name\": \"%s\", \"size\": \"%s\", \"width\": %d, \"height\": %d, "
+            "\"bytes\": %llu, \"iterations\": %d, \"median_ms\": %.4f, \"best_ms\": %.4f, \"ns_per_pixel\": %.4f, \"gb_per_s\": %.3f}",
+            result.key().c_str(), result.group.c_str(), result.name.c_str(), result.size->name, result.size->width, result.size->height,
+            (unsigned long long)result.bytes, result.timing.iterations, result.timing.medianSeconds * 1e3, result.timing.bestSeconds * 1e3, result.nsPerPixel(), result.gigabytesPerSecond());
+        return line;
+    }
+
+    void usage()
+    {
+        std::printf(
+            "RenderStreamBenchmark [options]\n"
+            "  --group NAME       convert, alpha, hash or send (default all)\n"
+            "  --size FILTER      only sizes containing FILTER, e.g. 4k\n"
+            "  --format FILTER    only sender formats containing FILTER, e.g. uyvy\n"
+            "  --isa NAME         scalar, sse4, avx2, avx512 or neon (default best supported)\n"
+            "  --threads N        conversion threads, 0 picks like the plugin (default 1)\n"
+            "  --seconds S        minimum time per case (default 0.25)\n");
+        BenchmarkHarness::printCommonUsage("ns/pixel");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    const int exitCode = BenchmarkHarness::parseArguments(argc, argv, options, [&](const std::string& arg, const char* value)
+    {
+        if (arg == "--group") options.group = value;
+        else if (arg == "--size") options.sizeFilter = value;
+        else if (arg == "--format") options.formatFilter = value;
+        else if (arg == "--isa") options.isa = value;
+        else if (arg == "--threads") options.threads = size_t(std::atoi(value));
+        else if (arg == "--seconds") options.minSeconds = std::atof(value);
+        else return false;
+        return true;
+    }, usage);
+    if (exitCode >= 0)
+        return exitCode;
+
+    if (!options.isa.empty())
+    {
+        bool found = false;
+        for (uint32_t isa = 0; isa < uint32_t(PixelConvert::Isa::Count); ++isa)
+        {
+            if (options.isa == PixelConvert::isaName(PixelConvert::Isa(isa)))
+            {
+                found = PixelConvert::isSupported(PixelConvert::Isa(isa));
+                PixelConvert::setActiveIsa(PixelConvert::Isa(isa));
+            }
+        }
+        if (!found)
+        {
+            std::fprintf(stderr, "Instruction set '%s' is not supported here\n", options.isa.c_str());
+            return 1;
+        }
+    }
+
+    ConvertScheduler scheduler(options.threads, 0);
+    std::fprintf(stderr, "isa %s, %zu conversion threads\n", PixelConvert::isaName(PixelConvert::activeIsa()), scheduler.threadCount());
+
+    std::vector<Result> results;
+    if (matches(options.group, "convert"))
+        runConvert(options, scheduler, results);
+    if (matches(options.group, "alpha"))
+        runAlpha(options, scheduler, results);
+    if (matches(options.group, "hash"))
+        runHash(options, results);
+    if (matches(options.group, "send"))
+        runSend(options, scheduler, results);
+
+    std::vector<std::string> lines;
+    for (const Result& result : results)
+        lines.push_back(resultJson(result));
+    BenchmarkHarness::writeResults(options, {
+        { "isa", std::string("\"") + PixelConvert::isaName(PixelConvert::activeIsa()) + "\"" },
+        { "threads", std::to_string(scheduler.threadCount()) },
+    }, lines);
+
+    if (!options.compare.empty())
+    {
+        const std::map<std::string, std::vector<double>> baseline = BenchmarkHarness::readBaseline(options.compare, { "ns_per_pixel" });
+        for (const Result& result : results)
+        {
+            const std::map<std::string, std::vector<double>>::const_iterator before = baseline.find(result.key());
+            if (before == baseline.end() || before->second[0] <= 0.)
+                continue;
+            const double change = (result.nsPerPixel() / before->second[0] - 1.) * 100.;
+            std::fprintf(stderr, "%-50s %9.4f -> %9.4f ns/pixel %+7.1f%%\n", result.key().c_str(), before->second[0], result.nsPerPixel(), change);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,321 @@
+// Standalone benchmark for schema.json handling: writing it with SchemaWriter, reading it with SchemaReader and
+// CompiledSchema::parse, and loading the compiled schema.bin instead. Needs neither Unreal nor d3.
+//
+// Build from this directory on Linux (bash):
+//   SRC=../../Source/RenderStream
+//   g++ -std=c++14 -O2 -I$SRC/Private -o SchemaBenchmark SchemaBenchmark.cpp
+//       $SRC/Private/{SchemaJson,CompiledSchema,fnv}.cpp
+// (one command, split here for width)
+//
+// Results are written as JSON, one result object per line, so two runs can be compared with --compare:
+//   ./SchemaBenchmark --out before.json
+//   ./SchemaBenchmark --out after.json --compare before.json
+
+#include "BenchmarkHarness.hpp"
+#include "CompiledSchema.hpp"
+#include "SchemaJson.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+// Counts every allocation, so that the results show how many each operation makes per parameter.
+namespace
+{
+    std::atomic<size_t> g_allocations(0);
+}
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using BenchmarkHarness::matches;
+
+    struct Size
+    {
+        const char* name;
+        uint32_t scenes;
+        uint32_t persistentParameters;
+        uint32_t levelParameters;   // Per scene
+
+        uint32_t parameters() const { return scenes * (persistentParameters + levelParameters); }
+    };
+
+    // Every scene repeats the persistent parameters, as the editor writes them.
+    const Size Sizes[] = {
+        { "1k", 10, 20, 80 },
+        { "10k", 40, 50, 200 },
+        { "100k", 100, 100, 900 },
+    };
+
+    struct Options : BenchmarkHarness::Options
+    {
+        std::string sizeFilter;
+        std::string group;
+    };
+
+    struct Result
+    {
+        std::string group;
+        std::string name;
+        const Size* size = nullptr;
+        size_t bytes = 0;           // Schema text per iteration
+        BenchmarkHarness::Timing timing;
+        double allocations = 0.;    // Per iteration, after the warm-up
+
+        std::string key() const { return group + "/" + name + "/" + size->name; }
+        double nsPerParameter() const { return timing.medianSeconds * 1e9 / double(size->parameters()); }
+        double megabytesPerSecond() const { return double(bytes) / timing.medianSeconds * 1e-6; }
+    };
+
+    template <typename Fn>
+    Result measure(const Options& options, const std::string& group, const std::string& name, const Size& size, size_t bytes, Fn fn)
+    {
+        Result result;
+        result.group = group;
+        result.name = name;
+        result.size = &size;
+        result.bytes = bytes;
+        size_t allocations = 0;
+        result.timing = BenchmarkHarness::measure(options, fn, [&] { allocations = g_allocations.load(); });
+        // The timing vector grows as it goes, a few allocations in total.
+        result.allocations = double(g_allocations.load() - allocations) / double(result.timing.iterations);
+        return result;
+    }
+
+    // Keys and names shaped like the ones the editor generates.
+    struct Parameter
+    {
+        std::string group;
+        std::string displayName;
+        std::string key;
+    };
+
+    std::vector<Parameter> makeParameters(const char* prefix, uint32_t count)
+    {
+        static const char* const Suffixes[] = { "x", "y", "z" };
+        std::vector<Parameter> parameters(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const std::string name = std::string(prefix) + "Property" + std::to_string(i / 3);
+            parameters[i].group = "Category " + std::to_string(i / 30);
+            parameters[i].displayName = name + " " + Suffixes[i % 3];
+            parameters[i].key = name + "_" + Suffixes[i % 3];
+        }
+        return parameters;
+    }
+
+    void writeParameters(SchemaWriter& writer, const std::vector<Parameter>& parameters)
+    {
+        for (const Parameter& source : parameters)
+        {
+            SchemaParameter parameter;
+            parameter.group = source.group.c_str();
+            parameter.displayName = source.displayName.c_str();
+            parameter.key = source.key.c_str();
+            parameter.min = -1.f;
+            parameter.max = 1.f;
+            parameter.step = 0.001f;
+            parameter.defaultValue = 0.25f;
+            writer.beginParameter(parameter);
+            writer.endParameter();
+        }
+    }
+
+    struct Schema
+    {
+        std::string persistent;
+        std::vector<std::string> levels;
+        uint32_t nPersistent = 0;
+        uint32_t nLevel = 0;
+    };
+
+    // Parameters are written once per level and the scenes assembled from them, as the editor does.
+    Schema makeSchema(const Size& size)
+    {
+        Schema schema;
+        SchemaWriter writer;
+        writeParameters(writer, makeParameters("Persistent", size.persistentParameters));
+        schema.persistent = writer.text();
+        schema.nPersistent = size.persistentParameters;
+        for (uint32_t scene = 0; scene < size.scenes; ++scene)
+        {
+            writer.clear();
+            writeParameters(writer, makeParameters(("Level" + std::to_string(scene)).c_str(), size.levelParameters));
+            schema.levels.push_back(writer.text());
+        }
+        schema.nLevel = size.levelParameters;
+        return schema;
+    }
+
+    void assemble(SchemaWriter& writer, const Schema& schema)
+    {
+        writer.clear();
+        writer.beginSchemas();
+        for (size_t scene = 0; scene < schema.levels.size(); ++scene)
+        {
+            writer.beginScene(("Scene " + std::to_string(scene)).c_str());
+            writer.parameters(schema.persistent);
+            writer.parameters(schema.levels[scene]);
+            writer.endScene(schema.nPersistent, schema.nLevel);
+        }
+        writer.endSchemas();
+    }
+
+    // Counts keys without keeping them, the floor for anything built on the reader.
+    class CountingHandler : public SchemaReader::Handler
+    {
+    public:
+        void beginScene() override {}
+        void key(const char*, size_t size) override { m_bytes += size; }
+        void endScene(const char*, size_t, uint32_t, uint32_t, uint64_t hash) override { m_hash ^= hash; }
+
+        size_t m_bytes = 0;
+        uint64_t m_hash = 0;
+    };
+
+    volatile uint64_t g_sink = 0;
+
+    void runSize(const Options& options, const Size& size, std::vector<Result>& results)
+    {
+        const Schema schema = makeSchema(size);
+        SchemaWriter writer;
+        assemble(writer, schema);
+        const std::string text = writer.text();
+
+        std::string error;
+        CompiledSchema compiled;
+        if (!compiled.parse(text.data(), text.size(), error))
+        {
+            std::fprintf(stderr, "Generated schema does not parse: %s\n", error.c_str());
+            std::exit(1);
+        }
+        const std::vector<uint8_t> binary = compiled.serialise();
+
+        if (matches(options.group, "write"))
+        {
+            // The editor's path once every level is cached.
+            results.push_back(measure(options, "write", "assemble", size, text.size(), [&] { assemble(writer, schema); g_sink = g_sink + writer.text().size(); }));
+            // And the first time, when every level's parameters are written.
+            const std::vector<Parameter> level = makeParameters("Level", size.levelParameters);
+            size_t levelBytes = 0;
+            for (const std::string& written : schema.levels)
+                levelBytes += written.size();
+            SchemaWriter levels;
+            results.push_back(measure(options, "write", "parameters", size, levelBytes, [&]
+            {
+                for (size_t scene = 0; scene < schema.levels.size(); ++scene)
+                {
+                    levels.clear();
+                    writeParameters(levels, level);
+                    g_sink = g_sink + levels.text().size();
+                }
+            }));
+        }
+        if (matches(options.group, "read"))
+        {
+            SchemaReader reader;
+            results.push_back(measure(options, "read", "reader", size, text.size(), [&]
+            {
+                CountingHandler handler;
+                reader.read(text.data(), text.size(), handler);
+                g_sink = g_sink + handler.m_hash;
+            }));
+            results.push_back(measure(options, "read", "compile", size, text.size(), [&]
+            {
+                CompiledSchema parsed;
+                parsed.parse(text.data(), text.size(), error);
+                g_sink = g_sink + parsed.scenes.size();
+            }));
+            results.push_back(measure(options, "read", "deserialise", size, text.size(), [&]
+            {
+                CompiledSchema loaded;
+                loaded.deserialise(binary.data(), binary.size());
+                g_sink = g_sink + loaded.scenes.size();
+            }));
+        }
+    }
+
+    std::string resultJson(const Result& result)
+    {
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "{\"key\": \"%s\", \"group\": \"%s\", \"name\": \"%s\", \"size\": \"%s\", \"parameters\": %u, "
+            "\"bytes\": %llu, \"iterations\": %d, \"median_ms\": %.4f, \"best_ms\": %.4f, \"ns_per_parameter\": %.4f, \"mb_per_s\": %.1f, \"allocations\": %.1f}",
+            result.key().c_str(), result.group.c_str(), result.name.c_str(), result.size->name, result.size->parameters(),
+            (unsigned long long)result.bytes, result.timing.iterations, result.timing.medianSeconds * 1e3, result.timing.bestSeconds * 1e3, result.nsPerParameter(),
+            result.megabytesPerSecond(), result.allocations);
+        return line;
+    }
+
+    void usage()
+    {
+        std::printf(
+            "SchemaBenchmark [options]\n"
+            "  --group NAME       write or read (default both)\n"
+            "  --size FILTER      only sizes containing FILTER: 1k, 10k or 100k parameters\n"
+            "  --seconds S        minimum time per case (default 0.25)\n");
+        BenchmarkHarness::printCommonUsage("ns/parameter");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    const int exitCode = BenchmarkHarness::parseArguments(argc, argv, options, [&](const std::string& arg, const char* value)
+    {
+        if (arg == "--group") options.group = value;
+        else if (arg == "--size") options.sizeFilter = value;
+        else if (arg == "--seconds") options.minSeconds = std::atof(value);
+        else return false;
+        return true;
+    }, usage);
+    if (exitCode >= 0)
+        return exitCode;
+
+    std::vector<Result> results;
+    for (const Size& size : Sizes)
+    {
+        if (matches(options.sizeFilter, size.name))
+            runSize(options, size, results);
+    }
+
+    std::vector<std::string> lines;
+    for (const Result& result : results)
+        lines.push_back(resultJson(result));
+    BenchmarkHarness::writeResults(options, {}, lines);
+
+    if (!options.compare.empty())
+    {
+        const std::map<std::string, std::vector<double>> baseline = BenchmarkHarness::readBaseline(options.compare, { "ns_per_parameter" });
+        for (const Result& result : results)
+        {
+            const std::map<std::string, std::vector<double>>::const_iterator before = baseline.find(result.key());
+            if (before == baseline.end() || before->second[0] <= 0.)
+                continue;
+            const double change = (result.nsPerParameter() / before->second[0] - 1.) * 100.;
+            std::fprintf(stderr, "%-40s %9.2f -> %9.2f ns/parameter %+7.1f%%\n", result.key().c_str(), before->second[0], result.nsPerParameter(), change);
+        }
+    }
+    return 0;
+}
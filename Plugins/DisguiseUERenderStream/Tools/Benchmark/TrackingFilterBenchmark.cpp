@@ -0,0 +1,378 @@
+// Offline harness for CameraFilter: replays a camera track through a grid of filter settings and reports, for each,
+// how much jitter it removes against how much latency it adds. The track is either a camera from a session log
+// recorded with RenderStream.Record, or a synthetic camera move with tracking noise, repeated and swapped samples
+// added, for which the error against the true move is reported too. Needs neither Unreal nor d3.
+//
+// Build from this directory on Linux (bash):
+//   SRC=../../Source/RenderStream
+//   g++ -std=c++14 -O2 -I$SRC/Private -I$SRC/Public -o TrackingFilterBenchmark TrackingFilterBenchmark.cpp
+//       $SRC/Private/{CameraFilter,SessionLog}.cpp
+// (one command, split here for width)
+//
+// Jitter is the RMS distance of each filtered sample from the midpoint of its neighbours, which a smooth move keeps
+// near 0. Added latency is the delay that best lines up the filtered positions with the tracked ones. Results are
+// written as JSON, one result object per line, so two runs can be compared with --compare:
+//   ./TrackingFilterBenchmark --log session.rslog --out before.json
+//   ./TrackingFilterBenchmark --log session.rslog --out after.json --compare before.json
+
+#include "BenchmarkHarness.hpp"
+#include "CameraFilter.hpp"
+#include "SessionLog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+
+    // Replays rather than times, so the harness's timing options go unused.
+    struct Options : BenchmarkHarness::Options
+    {
+        std::string log;
+        size_t stream = 0;              // Index among the cameras of each frame in the log
+        double seconds = 60.;           // Of the synthetic track
+        double rate = 60.;
+        double noiseMm = 1.;
+        double noiseDegrees = 0.05;
+        double duplicates = 0.02;       // Fraction of synthetic samples repeated
+        double swaps = 0.01;            // Fraction of synthetic samples swapped with the next
+    };
+
+    struct Sample
+    {
+        double t = 0.;
+        double frameDelta = 0.;
+        RenderStreamLink::CameraData camera = {};
+        RenderStreamLink::CameraData truth = {};    // Synthetic tracks only
+    };
+
+    struct Track
+    {
+        std::string name;
+        bool synthetic = false;
+        std::vector<Sample> samples;
+    };
+
+    struct Config
+    {
+        std::string name;
+        CameraFilter::Settings settings;
+    };
+
+    struct Result
+    {
+        std::string name;
+        double jitterMm = 0.;
+        double jitterDegrees = 0.;
+        double reductionDb = 0.;        // Of position jitter against the tracked camera
+        double latencyMs = 0.;
+        double errorMm = -1.;           // RMS against the true move, synthetic tracks only
+        CameraFilter::Stats stats;
+    };
+
+    RenderStreamLink::CameraData cameraAt(double t)
+    {
+        RenderStreamLink::CameraData camera = {};
+        camera.cameraHandle = 1;
+        camera.x = float(1.5 * std::sin(2. * Pi * t / 8.));
+        camera.y = float(1.7 + 0.1 * std::sin(2. * Pi * t / 3.));
+        camera.z = float(0.8 * std::sin(2. * Pi * t / 5. + 1.));
+        camera.rx = float(5. * std::sin(2. * Pi * t / 7.));
+        camera.ry = float(std::remainder(170. + 40. * std::sin(2. * Pi * t / 8.), 360.));
+        camera.rz = 0.f;
+        camera.focalLength = float(35. + 10. * std::sin(2. * Pi * t / 11.));
+        camera.sensorX = 36.f;
+        camera.sensorY = 24.f;
+        camera.nearZ = 0.1f;
+        camera.farZ = 1000.f;
+        return camera;
+    }
+
+    Track syntheticTrack(const Options& options)
+    {
+        Track track;
+        track.name = "synthetic";
+        track.synthetic = true;
+        std::mt19937 random(1);
+        std::normal_distribution<double> noise(0., 1.);
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        const size_t count = size_t(options.seconds * options.rate);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Sample sample;
+            sample.t = double(i) / options.rate;
+            sample.frameDelta = 1. / options.rate;
+            sample.truth = cameraAt(sample.t);
+            sample.camera = sample.truth;
+            sample.camera.x += float(noise(random) * options.noiseMm / 1000.);
+            sample.camera.y += float(noise(random) * options.noiseMm / 1000.);
+            sample.camera.z += float(noise(random) * options.noiseMm / 1000.);
+            sample.camera.rx += float(noise(random) * options.noiseDegrees);
+            sample.camera.ry += float(noise(random) * options.noiseDegrees);
+            sample.camera.rz += float(noise(random) * options.noiseDegrees);
+            track.samples.push_back(sample);
+            if (uniform(random) < options.duplicates)
+                track.samples.push_back(sample);
+        }
+        for (size_t i = 0; i + 1 < track.samples.size(); ++i)
+        {
+            if (uniform(random) < options.swaps)
+            {
+                std::swap(track.samples[i], track.samples[i + 1]);
+                ++i;
+            }
+        }
+        return track;
+    }
+
+    bool loadTrack(const Options& options, Track& track)
+    {
+        std::unique_ptr<SessionReader> reader = SessionReader::open(options.log);
+        if (!reader)
+        {
+            std::fprintf(stderr, "Unable to open session log %s\n", options.log.c_str());
+            return false;
+        }
+        track.name = options.log;
+        for (size_t i = 0; i < reader->frameCount(); ++i)
+        {
+            const SessionFrame frame = reader->frame(i);
+            if (options.stream >= frame.nCameras || !frame.cameras[options.stream].valid)
+                continue;
+            Sample sample;
+            sample.t = frame.frameData.tTracked;
+            sample.frameDelta = frame.frameData.localTimeDelta;
+            sample.camera = frame.cameras[options.stream].data;
+            track.samples.push_back(sample);
+        }
+        if (track.samples.size() < 16)
+        {
+            std::fprintf(stderr, "Too few frames with camera %llu in %s\n", (unsigned long long)options.stream, options.log.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    const float& position(const RenderStreamLink::CameraData& camera, size_t axis)
+    {
+        return axis == 0 ? camera.x : axis == 1 ? camera.y : camera.z;
+    }
+
+    const float& rotation(const RenderStreamLink::CameraData& camera, size_t axis)
+    {
+        return axis == 0 ? camera.rx : axis == 1 ? camera.ry : camera.rz;
+    }
+
+    // RMS distance of each sample from the midpoint of its neighbours, rotations taken the short way round.
+    double jitter(const std::vector<RenderStreamLink::CameraData>& cameras, bool rotations)
+    {
+        double sum = 0.;
+        size_t count = 0;
+        for (size_t i = 1; i + 1 < cameras.size(); ++i)
+        {
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                double d;
+                if (rotations)
+                {
+                    const double centre = rotation(cameras[i], axis);
+                    d = 0.5 * (std::remainder(rotation(cameras[i - 1], axis) - centre, 360.) + std::remainder(rotation(cameras[i + 1], axis) - centre, 360.));
+                }
+                else
+                {
+                    d = 0.5 * (position(cameras[i - 1], axis) + position(cameras[i + 1], axis)) - position(cameras[i], axis);
+                }
+                sum += d * d;
+            }
+            ++count;
+        }
+        return count ? std::sqrt(sum / double(count)) : 0.;
+    }
+
+    // Samples of delay that best line the delayed track up with the reference one, by mean squared distance between
+    // positions, refined to a fraction of a sample with a parabola through the minimum. Positions rather than
+    // velocities, as tracking noise swamps the difference between neighbouring samples.
+    double lagSamples(const std::vector<RenderStreamLink::CameraData>& reference, const std::vector<RenderStreamLink::CameraData>& delayed)
+    {
+        const size_t maxLag = 60;
+        std::vector<double> distance(maxLag + 1, 0.);
+        for (size_t lag = 0; lag <= maxLag && lag < reference.size(); ++lag)
+        {
+            double sum = 0.;
+            for (size_t i = 0; i + lag < reference.size(); ++i)
+            {
+                for (size_t axis = 0; axis < 3; ++axis)
+                {
+                    const double d = position(delayed[i + lag], axis) - position(reference[i], axis);
+                    sum += d * d;
+                }
+            }
+            distance[lag] = sum / double(reference.size() - lag);
+        }
+        const size_t peak = size_t(std::min_element(distance.begin(), distance.end()) - distance.begin());
+        if (peak == 0 || peak == maxLag)
+            return double(peak);
+        const double l = distance[peak - 1], c = distance[peak], r = distance[peak + 1];
+        const double denominator = l - 2. * c + r;
+        return denominator > 0. ? double(peak) + 0.5 * (l - r) / denominator : double(peak);
+    }
+
+    Result run(const Track& track, const Config& config, double tracked)
+    {
+        CameraFilter filter;
+        filter.configure(config.settings);
+
+        // Only samples the filter accepted count, as the rest only repeat an earlier output.
+        std::vector<RenderStreamLink::CameraData> input, output, truth;
+        for (const Sample& sample : track.samples)
+        {
+            RenderStreamLink::CameraData camera = sample.camera;
+            if (filter.filter(sample.t, sample.frameDelta, camera) != CameraFilter::Result::Accepted)
+                continue;
+            input.push_back(sample.camera);
+            output.push_back(camera);
+            truth.push_back(sample.truth);
+        }
+
+        Result result;
+        result.name = config.name;
+        result.stats = filter.stats();
+        result.jitterMm = jitter(output, false) * 1000.;
+        result.jitterDegrees = jitter(output, true);
+        result.reductionDb = tracked > 0. && result.jitterMm > 0. ? 20. * std::log10(tracked / result.jitterMm) : 0.;
+
+        double interval = 0.;
+        if (track.samples.size() > 1)
+            interval = (track.samples.back().t - track.samples.front().t) / double(track.samples.size() - 1);
+        result.latencyMs = lagSamples(input, output) * interval * 1000.;
+
+        if (track.synthetic)
+        {
+            double sum = 0.;
+            for (size_t i = 0; i < output.size(); ++i)
+            {
+                for (size_t axis = 0; axis < 3; ++axis)
+                {
+                    const double d = position(output[i], axis) - position(truth[i], axis);
+                    sum += d * d;
+                }
+            }
+            result.errorMm = output.empty() ? 0. : std::sqrt(sum / double(output.size())) * 1000.;
+        }
+        return result;
+    }
+
+    std::vector<Config> configs()
+    {
+        std::vector<Config> out;
+        Config reject;
+        reject.name = "reject-only";
+        reject.settings.rejectStale = true;
+        reject.settings.smooth = false;
+        out.push_back(reject);
+        for (double minCutoff : { 0.5, 1., 2., 5. })
+        {
+            for (double beta : { 0., 0.2, 1., 4. })
+            {
+                Config config;
+                char name[64];
+                std::snprintf(name, sizeof(name), "one-euro/%.1fHz/beta%.1f", minCutoff, beta);
+                config.name = name;
+                config.settings.smooth = true;
+                config.settings.minCutoff = minCutoff;
+                config.settings.beta = beta;
+                out.push_back(config);
+            }
+        }
+        return out;
+    }
+
+    std::string resultJson(const Track& track, const Result& result)
+    {
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "{\"key\": \"%s\", \"track\": \"%s\", \"jitter_mm\": %.4f, \"jitter_deg\": %.4f, \"reduction_db\": %.2f, "
+            "\"latency_ms\": %.2f, \"error_mm\": %.4f, \"accepted\": %llu, \"duplicates\": %llu, \"out_of_order\": %llu}",
+            result.name.c_str(), track.name.c_str(), result.jitterMm, result.jitterDegrees, result.reductionDb, result.latencyMs, result.errorMm,
+            (unsigned long long)result.stats.accepted, (unsigned long long)result.stats.duplicates, (unsigned long long)result.stats.outOfOrder);
+        return line;
+    }
+
+    void usage()
+    {
+        std::printf(
+            "TrackingFilterBenchmark [options]\n"
+            "  --log FILE         replay a camera from a session log instead of the synthetic track\n"
+            "  --stream N         camera of each logged frame to replay (default 0)\n"
+            "  --seconds S        length of the synthetic track (default 60)\n"
+            "  --noise-mm MM      position noise of the synthetic track (default 1)\n");
+        BenchmarkHarness::printCommonUsage("jitter and latency");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    const int exitCode = BenchmarkHarness::parseArguments(argc, argv, options, [&](const std::string& arg, const char* value)
+    {
+        if (arg == "--log") options.log = value;
+        else if (arg == "--stream") options.stream = size_t(std::atoi(value));
+        else if (arg == "--seconds") options.seconds = std::atof(value);
+        else if (arg == "--noise-mm") options.noiseMm = std::atof(value);
+        else return false;
+        return true;
+    }, usage);
+    if (exitCode >= 0)
+        return exitCode;
+
+    Track track;
+    if (options.log.empty())
+        track = syntheticTrack(options);
+    else if (!loadTrack(options, track))
+        return 1;
+
+    // Jitter of the tracked camera itself, what each filter is measured against.
+    std::vector<RenderStreamLink::CameraData> tracked;
+    for (const Sample& sample : track.samples)
+        tracked.push_back(sample.camera);
+    const double trackedJitter = jitter(tracked, false) * 1000.;
+    std::fprintf(stderr, "%s: %llu samples, tracked jitter %.4f mm %.4f deg\n", track.name.c_str(), (unsigned long long)track.samples.size(), trackedJitter, jitter(tracked, true));
+
+    std::vector<Result> results;
+    for (const Config& config : configs())
+    {
+        results.push_back(run(track, config, trackedJitter));
+        const Result& r = results.back();
+        std::fprintf(stderr, "%-28s jitter %8.4f mm %8.4f deg  %+6.1f dB  latency %6.2f ms", r.name.c_str(), r.jitterMm, r.jitterDegrees, r.reductionDb, r.latencyMs);
+        if (r.errorMm >= 0.)
+            std::fprintf(stderr, "  error %8.4f mm", r.errorMm);
+        std::fprintf(stderr, "\n");
+    }
+
+    std::vector<std::string> lines;
+    for (const Result& result : results)
+        lines.push_back(resultJson(track, result));
+    BenchmarkHarness::writeResults(options, {}, lines);
+
+    if (!options.compare.empty())
+    {
+        const std::map<std::string, std::vector<double>> baseline = BenchmarkHarness::readBaseline(options.compare, { "jitter_mm", "latency_ms" });
+        for (const Result& result : results)
+        {
+            const auto before = baseline.find(result.name);
+            if (before == baseline.end())
+                continue;
+            std::fprintf(stderr, "%-28s jitter %8.4f -> %8.4f mm  latency %6.2f -> %6.2f ms\n", result.name.c_str(),
+                before->second[0], result.jitterMm, before->second[1], result.latencyMs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,542 @@
+// Stand-in for d3renderstream that implements the whole rs_* table without d3, so the plugin's receive, apply,
+// capture and send loop can run headless. Frame data is produced at a fixed rate, parameters come from a script or
+// a generator, cameras orbit the origin, and every host memory frame passed to rs_sendFrame is checksummed and
+// optionally written to disk.
+//
+// Build on Linux, from this directory (one command):
+//   g++ -std=c++14 -O2 -shared -fPIC -fvisibility=hidden -pthread -I../../Source/RenderStream/Public
+//       -I../../Source/RenderStream/Private RenderStreamLoopback.cpp ../../Source/RenderStream/Private/fnv.cpp
+//       -o libd3renderstream.so
+// then point the plugin at it with -RenderStreamLibrary=/path/to/libd3renderstream.so or RENDERSTREAM_LIBRARY.
+//
+// Configured through environment variables, read by rs_init:
+//   RS_LOOPBACK_RATE          frame rate as "60" or "60000/1001", default 60
+//   RS_LOOPBACK_SCENE         scene index reported in FrameData, default 0
+//   RS_LOOPBACK_PARAMETERS    text file, one frame of parameter values per line, replayed in a loop. Missing
+//                             values are generated, lines starting with # are ignored
+//   RS_LOOPBACK_CAMERA        "orbit" (default) or "static"
+//   RS_LOOPBACK_RECORD        directory that receives the first frames of every stream as raw files, plus
+//                             frames.csv with the checksum of every frame
+//   RS_LOOPBACK_RECORD_LIMIT  frames written per stream, default 16
+//   RS_LOOPBACK_STATS         file that receives a JSON summary on rs_shutdown, stderr when unset
+
+#include "RenderStreamLink.h"
+#include "fnv.hpp"
+
+#include <chrono>
+#include <cstdarg>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define LOOPBACK_API extern "C" __declspec(dllexport)
+#else
+#define LOOPBACK_API extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace
+{
+    typedef RenderStreamLink RSL;
+    typedef std::chrono::steady_clock Clock;
+
+    const double Pi = 3.14159265358979323846;
+
+    struct Stream
+    {
+        std::string name;
+        int width = 0;
+        int height = 0;
+        RSL::SenderPixelFormat format = RSL::FMT_BGRA;
+        bool uncompressed = false;
+
+        uint64_t frames = 0;
+        uint64_t textureFrames = 0;
+        uint64_t bytes = 0;
+        uint64_t lastHash = 0;
+        uint64_t combinedHash = 0;  // fnvHash of every frame hash in order, one value for the whole run
+        uint64_t recorded = 0;
+    };
+
+    struct State
+    {
+        std::mutex mutex;
+        bool initialised = false;
+
+        RSL::logger_t log = nullptr;
+        RSL::logger_t errorLog = nullptr;
+        RSL::logger_t verboseLog = nullptr;
+
+        RSL::AssetHandle nextAsset = 1;
+        std::map<RSL::AssetHandle, std::string> assets;
+        std::map<RSL::AssetHandle, std::string> schemas;
+
+        RSL::StreamHandle nextStream = 1;
+        std::map<RSL::StreamHandle, Stream> streams;
+
+        // Configuration
+        unsigned int rateNumerator = 60;
+        unsigned int rateDenominator = 1;
+        uint32_t scene = 0;
+        bool orbit = true;
+        std::vector<std::vector<float>> script;
+        std::string recordDirectory;
+        uint64_t recordLimit = 16;
+        std::string statsPath;
+
+        // Frame clock
+        Clock::time_point start;
+        uint64_t frame = 0;         // Next frame number to hand out
+        uint64_t delivered = 0;
+        uint64_t skipped = 0;       // Frames the caller was too slow to collect
+        uint64_t timeouts = 0;
+        double localTime = 0.;
+        std::FILE* frameLog = nullptr;
+    };
+
+    State& state()
+    {
+        static State s;
+        return s;
+    }
+
+    void logf(RSL::logger_t logger, const char* format, ...)
+    {
+        if (!logger)
+            return;
+        char text[512];
+        va_list args;
+        va_start(args, format);
+        std::vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        logger(text);
+    }
+
+    std::string environment(const char* name)
+    {
+        const char* value = std::getenv(name);
+        return value ? value : "";
+    }
+
+    double framePeriod(const State& s)
+    {
+        return double(s.rateDenominator) / double(s.rateNumerator);
+    }
+
+    void readScript(State& s, const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            logf(s.errorLog, "Loopback: cannot read parameter script %s", path.c_str());
+            return;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            for (char& c : line)
+                if (c == ',')
+                    c = ' ';
+            std::istringstream values(line);
+            std::vector<float> row;
+            float value;
+            while (values >> value)
+                row.push_back(value);
+            s.script.push_back(row);
+        }
+        logf(s.log, "Loopback: %u scripted parameter frames from %s", unsigned(s.script.size()), path.c_str());
+    }
+
+    void configure(State& s)
+    {
+        const std::string rate = environment("RS_LOOPBACK_RATE");
+        if (!rate.empty())
+        {
+            unsigned int numerator = 0, denominator = 1;
+            if (std::sscanf(rate.c_str(), "%u/%u", &numerator, &denominator) >= 1 && numerator > 0 && denominator > 0)
+            {
+                s.rateNumerator = numerator;
+                s.rateDenominator = denominator;
+            }
+        }
+        const std::string scene = environment("RS_LOOPBACK_SCENE");
+        if (!scene.empty())
+            s.scene = uint32_t(std::strtoul(scene.c_str(), nullptr, 10));
+        s.orbit = environment("RS_LOOPBACK_CAMERA") != "static";
+
+        s.script.clear();
+        const std::string script = environment("RS_LOOPBACK_PARAMETERS");
+        if (!script.empty())
+            readScript(s, script);
+
+        s.recordDirectory = environment("RS_LOOPBACK_RECORD");
+        const std::string limit = environment("RS_LOOPBACK_RECORD_LIMIT");
+        if (!limit.empty())
+            s.recordLimit = std::strtoull(limit.c_str(), nullptr, 10);
+        s.statsPath = environment("RS_LOOPBACK_STATS");
+
+        if (!s.recordDirectory.empty())
+        {
+            const std::string path = s.recordDirectory + "/frames.csv";
+            s.frameLog = std::fopen(path.c_str(), "w");
+            if (s.frameLog)
+                std::fprintf(s.frameLog, "stream,frame,width,height,format,bytes,hash\n");
+            else
+                logf(s.errorLog, "Loopback: cannot write %s", path.c_str());
+        }
+
+        logf(s.log, "Loopback: frame data at %u/%u Hz, scene %u", s.rateNumerator, s.rateDenominator, s.scene);
+    }
+
+    // Bytes of a host memory frame as rs_sendFrame receives it. For FMT_NDI_UYVY_422_A the height already includes
+    // the alpha lines.
+    uint64_t frameBytes(RSL::SenderPixelFormat format, int width, int height)
+    {
+        uint64_t bitsPerPixel;
+        switch (format)
+        {
+        case RSL::FMT_UYVY_422:
+        case RSL::FMT_NDI_UYVY_422_A: bitsPerPixel = 16; break;
+        case RSL::FMT_UC_YUV422_10BIT: bitsPerPixel = 20; break;
+        case RSL::FMT_UC_YUV422_12BIT: bitsPerPixel = 24; break;
+        case RSL::FMT_UC_RGB_10BIT: bitsPerPixel = 30; break;
+        case RSL::FMT_UC_RGB_12BIT: bitsPerPixel = 36; break;
+        case RSL::FMT_UC_RGBA_10BIT: bitsPerPixel = 40; break;
+        case RSL::FMT_UC_RGBA_12BIT: bitsPerPixel = 48; break;
+        default: bitsPerPixel = 32; break;
+        }
+        return (uint64_t(width) * uint64_t(height) * bitsPerPixel + 7) / 8;
+    }
+
+    void record(State& s, RSL::StreamHandle handle, Stream& stream, const void* data, uint64_t bytes, int width, int height, RSL::SenderPixelFormat format)
+    {
+        if (s.frameLog)
+            std::fprintf(s.frameLog, "%s,%llu,%d,%d,%u,%llu,%016llx\n", stream.name.c_str(), (unsigned long long)stream.frames, width, height,
+                unsigned(format), (unsigned long long)bytes, (unsigned long long)stream.lastHash);
+
+        if (s.recordDirectory.empty() || stream.recorded >= s.recordLimit)
+            return;
+        char name[64];
+        std::snprintf(name, sizeof(name), "/stream%llu_%06llu.raw", (unsigned long long)handle, (unsigned long long)stream.frames);
+        std::FILE* file = std::fopen((s.recordDirectory + name).c_str(), "wb");
+        if (!file)
+            return;
+        std::fwrite(data, 1, size_t(bytes), file);
+        std::fclose(file);
+        ++stream.recorded;
+    }
+
+    void writeStats(State& s)
+    {
+        std::ostringstream out;
+        out << "{\n";
+        out << "\"frames_delivered\": " << s.delivered << ",\n";
+        out << "\"frames_skipped\": " << s.skipped << ",\n";
+        out << "\"timeouts\": " << s.timeouts << ",\n";
+        out << "\"streams\": [\n";
+        size_t i = 0;
+        for (const auto& entry : s.streams)
+        {
+            const Stream& stream = entry.second;
+            char hashes[64];
+            std::snprintf(hashes, sizeof(hashes), "\"%016llx\", \"combined_hash\": \"%016llx\"", (unsigned long long)stream.lastHash, (unsigned long long)stream.combinedHash);
+            out << "{\"handle\": " << entry.first << ", \"name\": \"" << stream.name << "\", \"width\": " << stream.width << ", \"height\": " << stream.height
+                << ", \"format\": " << unsigned(stream.format) << ", \"uncompressed\": " << (stream.uncompressed ? "true" : "false")
+                << ", \"frames\": " << stream.frames << ", \"texture_frames\": " << stream.textureFrames << ", \"bytes\": " << stream.bytes
+                << ", \"last_hash\": " << hashes << "}" << (++i < s.streams.size() ? ",\n" : "\n");
+        }
+        out << "]\n}\n";
+
+        if (s.statsPath.empty())
+        {
+            std::fputs(out.str().c_str(), stderr);
+            return;
+        }
+        std::ofstream file(s.statsPath);
+        file << out.str();
+    }
+
+    float generatedParameter(uint64_t frame, size_t index)
+    {
+        // Slow sine per parameter, each at its own frequency, always inside [0, 1]
+        const double t = double(frame) / 60.;
+        return float(0.5 + 0.5 * std::sin(2. * Pi * t * (0.1 + 0.05 * double(index))));
+    }
+}
+
+LOOPBACK_API void rs_getVersion(int* versionMajor, int* versionMinor)
+{
+    *versionMajor = RENDER_STREAM_VERSION_MAJOR;
+    *versionMinor = RENDER_STREAM_VERSION_MINOR;
+}
+
+LOOPBACK_API void rs_registerLoggingFunc(RSL::logger_t logger) { std::lock_guard<std::mutex> lock(state().mutex); state().log = logger; }
+LOOPBACK_API void rs_registerErrorLoggingFunc(RSL::logger_t logger) { std::lock_guard<std::mutex> lock(state().mutex); state().errorLog = logger; }
+LOOPBACK_API void rs_registerVerboseLoggingFunc(RSL::logger_t logger) { std::lock_guard<std::mutex> lock(state().mutex); state().verboseLog = logger; }
+
+LOOPBACK_API void rs_unregisterLoggingFunc() { std::lock_guard<std::mutex> lock(state().mutex); state().log = nullptr; }
+LOOPBACK_API void rs_unregisterErrorLoggingFunc() { std::lock_guard<std::mutex> lock(state().mutex); state().errorLog = nullptr; }
+LOOPBACK_API void rs_unregisterVerboseLoggingFunc() { std::lock_guard<std::mutex> lock(state().mutex); state().verboseLog = nullptr; }
+
+LOOPBACK_API RSL::RS_ERROR rs_init()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.initialised)
+        return RSL::RS_ERROR_ALREADYINITIALISED;
+    configure(s);
+    s.start = Clock::now();
+    s.frame = 0;
+    s.delivered = 0;
+    s.skipped = 0;
+    s.timeouts = 0;
+    s.initialised = true;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_shutdown()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.initialised)
+        return RSL::RS_NOT_INITIALISED;
+    writeStats(s);
+    if (s.frameLog)
+        std::fclose(s.frameLog);
+    s.frameLog = nullptr;
+    s.streams.clear();
+    s.assets.clear();
+    s.schemas.clear();
+    s.initialised = false;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_createAsset(const char* name, RSL::AssetHandle* assetHandle)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.initialised)
+        return RSL::RS_NOT_INITIALISED;
+    *assetHandle = s.nextAsset++;
+    s.assets[*assetHandle] = name ? name : "";
+    logf(s.log, "Loopback: created asset '%s'", name ? name : "");
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_destroyAsset(RSL::AssetHandle* assetHandle)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.erase(*assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    s.schemas.erase(*assetHandle);
+    *assetHandle = 0;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_setSchema(RSL::AssetHandle assetHandle, const char* jsonSchema)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.count(assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    s.schemas[assetHandle] = jsonSchema ? jsonSchema : "";
+    logf(s.verboseLog, "Loopback: schema of %u bytes", unsigned(s.schemas[assetHandle].size()));
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_createStream(RSL::AssetHandle assetHandle, const char* name, RSL::StreamHandle* handle)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.count(assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    *handle = s.nextStream++;
+    s.streams[*handle].name = name ? name : "";
+    logf(s.log, "Loopback: created stream '%s'", name ? name : "");
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_createUCStream(RSL::AssetHandle assetHandle, const char* name, int width, int height, RSL::SenderPixelFormat senderFmt,
+    int framerateNumerator, int framerateDenominator, void* pDeviceD3D11, bool opencl, RSL::StreamHandle* handle)
+{
+    (void)framerateNumerator;
+    (void)framerateDenominator;
+    (void)pDeviceD3D11;
+    (void)opencl;
+
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.count(assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    *handle = s.nextStream++;
+    Stream& stream = s.streams[*handle];
+    stream.name = name ? name : "";
+    stream.width = width;
+    stream.height = height;
+    stream.format = senderFmt;
+    stream.uncompressed = true;
+    logf(s.log, "Loopback: created uncompressed stream '%s' %dx%d", stream.name.c_str(), width, height);
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_destroyStream(RSL::AssetHandle assetHandle, RSL::StreamHandle* handle)
+{
+    (void)assetHandle;
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    // Streams are kept for the shutdown summary, only the handle is invalidated.
+    if (!s.streams.count(*handle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    *handle = 0;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_sendFrame(RSL::AssetHandle assetHandle, RSL::StreamHandle handle, RSL::SenderFrameType frameType, void* data,
+    int width, int height, RSL::SenderPixelFormat senderFmt, void* metaData)
+{
+    (void)assetHandle;
+    (void)metaData;
+
+    State& s = state();
+    if (frameType != RSL::RS_FRAMETYPE_HOST_MEMORY)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const auto it = s.streams.find(handle);
+        if (it == s.streams.end())
+            return RSL::RS_ERROR_INVALIDHANDLE;
+        ++it->second.textureFrames;
+        return RSL::RS_ERROR_SUCCESS;
+    }
+    if (!data || width <= 0 || height <= 0)
+        return RSL::RS_ERROR_UNSPECIFIED;
+
+    // Hash outside the lock, frames from several sender threads can then be checked in parallel.
+    const uint64_t bytes = frameBytes(senderFmt, width, height);
+    const uint64_t hash = fnvHash(static_cast<const uint8_t*>(data), size_t(bytes));
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const auto it = s.streams.find(handle);
+    if (it == s.streams.end())
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    Stream& stream = it->second;
+    stream.width = width;
+    stream.height = height;
+    stream.format = senderFmt;
+    stream.bytes += bytes;
+    stream.lastHash = hash;
+    const uint64_t chain[2] = { stream.combinedHash, hash };
+    stream.combinedHash = fnvHash(reinterpret_cast<const uint8_t*>(chain), sizeof(chain));
+    record(s, handle, stream, data, bytes, width, height, senderFmt);
+    ++stream.frames;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_awaitFrameData(RSL::AssetHandle* assetHandle, int timeoutMs, RSL::FrameData* data)
+{
+    State& s = state();
+    Clock::time_point due;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.initialised)
+            return RSL::RS_NOT_INITIALISED;
+        due = s.start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(double(s.frame) * framePeriod(s)));
+    }
+
+    // Block like d3 does until the next frame is due, or give up at the timeout.
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0);
+    if (due > deadline)
+    {
+        std::this_thread::sleep_until(deadline);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        ++s.timeouts;
+        return RSL::RS_ERROR_UNSPECIFIED;
+    }
+    std::this_thread::sleep_until(due);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const double period = framePeriod(s);
+    // A caller slower than the rate gets the newest frame, the ones in between are dropped as d3 would.
+    const uint64_t latest = uint64_t(std::chrono::duration<double>(Clock::now() - s.start).count() / period);
+    const uint64_t frame = latest > s.frame ? latest : s.frame;
+    s.skipped += frame - s.frame;
+
+    const double localTime = double(frame) * period;
+    data->tTracked = localTime;
+    data->localTime = localTime;
+    data->localTimeDelta = s.delivered == 0 ? period : localTime - s.localTime;
+    data->frameRateNumerator = s.rateNumerator;
+    data->frameRateDenominator = s.rateDenominator;
+    data->flags = s.delivered == 0 ? RSL::FRAMEDATA_RESET : RSL::FRAMEDATA_NO_FLAGS;
+    data->scene = s.scene;
+
+    s.localTime = localTime;
+    s.frame = frame + 1;
+    ++s.delivered;
+    *assetHandle = s.assets.empty() ? 0 : s.assets.begin()->first;
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_getFrameParameters(RSL::AssetHandle assetHandle, uint64_t schemaHash, void* outParameterData, size_t outParameterDataSize)
+{
+    (void)schemaHash;
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.count(assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    if (outParameterDataSize % sizeof(float) != 0)
+        return RSL::RS_ERROR_INCORRECTSCHEMA;
+
+    // Parameters belong to the frame handed out by the last rs_awaitFrameData.
+    const uint64_t frame = s.frame > 0 ? s.frame - 1 : 0;
+    const size_t count = outParameterDataSize / sizeof(float);
+    const std::vector<float>* row = s.script.empty() ? nullptr : &s.script[size_t(frame % s.script.size())];
+    float* out = static_cast<float*>(outParameterData);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = row && i < row->size() ? (*row)[i] : generatedParameter(frame, i);
+    return RSL::RS_ERROR_SUCCESS;
+}
+
+LOOPBACK_API RSL::RS_ERROR rs_getFrameCamera(RSL::AssetHandle assetHandle, RSL::StreamHandle streamHandle, RSL::CameraData* outCameraData)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.assets.count(assetHandle))
+        return RSL::RS_ERROR_INVALIDHANDLE;
+    if (!s.streams.count(streamHandle))
+        return RSL::RS_ERROR_NOTFOUND;
+
+    // One turn every 10 seconds on a 5m circle at eye height, looking at the origin. Streams are spread around it.
+    const double t = s.localTime;
+    const double angle = s.orbit ? 2. * Pi * t / 10. : 0.;
+    const double offset = 2. * Pi * double(streamHandle - 1) / 8.;
+    const double yaw = angle + offset;
+
+    RSL::CameraData& camera = *outCameraData;
+    camera.id = streamHandle;
+    camera.cameraHandle = streamHandle;
+    camera.x = float(-5. * std::sin(yaw));
+    camera.y = 1.7f;
+    camera.z = float(-5. * std::cos(yaw));
+    camera.rx = 0.f;
+    camera.ry = float(yaw * 180. / Pi);
+    camera.rz = 0.f;
+    camera.focalLength = 30.f;
+    camera.sensorX = 36.f;
+    camera.sensorY = 20.25f;
+    camera.cx = 0.f;
+    camera.cy = 0.f;
+    camera.nearZ = 0.1f;
+    camera.farZ = 1000.f;
+    return RSL::RS_ERROR_SUCCESS;
+}
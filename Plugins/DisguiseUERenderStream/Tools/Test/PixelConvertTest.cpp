@@ -0,0 +1,218 @@
+// Standalone test that every SIMD pixel conversion produces exactly the bytes of the scalar reference. Each source
+// format, SenderPixelFormat and alpha operation is converted with every instruction set this build and CPU support,
+// over widths around the vector and chunk sizes, odd widths and heights, and float sources holding NaN, infinities,
+// negative and out of range values. Needs neither Unreal nor a GPU.
+//
+// Build from this directory on Linux (bash):
+//   SRC=../../Source/RenderStream
+//   g++ -std=c++14 -O2 -I$SRC/Private -I$SRC/Public -o PixelConvertTest PixelConvertTest.cpp
+//       $SRC/Private/{PixelConvert,PixelConvertSSE4,PixelConvertAVX2,PixelConvertAVX512,PixelConvertNEON}.cpp
+// (one command, split here for width)
+//
+// Exits with 0 when every case matches, 1 otherwise. --verbose lists each case as it passes.
+
+#include "PixelConvert.hpp"
+#include "RenderStreamLink.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef RenderStreamLink RSL;
+
+    const RSL::SenderPixelFormat Formats[] = {
+        RSL::FMT_BGRA, RSL::FMT_RGBA, RSL::FMT_BGRX, RSL::FMT_RGBX, RSL::FMT_UYVY_422, RSL::FMT_NDI_UYVY_422_A,
+        RSL::FMT_UC_YUV422_10BIT, RSL::FMT_UC_YUV422_12BIT, RSL::FMT_UC_RGB_10BIT, RSL::FMT_UC_RGB_12BIT,
+        RSL::FMT_UC_RGBA_10BIT, RSL::FMT_UC_RGBA_12BIT,
+    };
+
+    const int Heights[] = { 1, 2, 3, 5 };
+
+    // Guard bytes after each destination, which no conversion may touch.
+    const size_t GuardBytes = 64;
+    const uint8_t Fill = 0xcd;
+
+    // Every width up to past one vector, then either side of the chunk size and of a few multiples of it.
+    std::vector<int> widths()
+    {
+        std::vector<int> out;
+        for (int width = 1; width <= 40; ++width)
+            out.push_back(width);
+        for (int width : { 63, 64, 65, 127, 128, 129, 255, 256, 257, 383, 1921 })
+            out.push_back(width);
+        return out;
+    }
+
+    uint16_t toHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+        const uint32_t mantissa = bits & 0x7fffffu;
+        if (((bits >> 23) & 0xff) == 0xff)
+            return uint16_t(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+        if (exponent >= 31)
+            return uint16_t(sign | 0x7c00u);
+        if (exponent <= 0)
+            return uint16_t(sign | (exponent < -10 ? 0u : ((mantissa | 0x800000u) >> (14 - exponent))));
+        return uint16_t(sign | (uint32_t(exponent) << 10) | (mantissa >> 13));
+    }
+
+    // One in four float components is a special value, the rest mostly in range with some either side of it.
+    float randomFloat(std::mt19937& rng)
+    {
+        static const float specials[] = {
+            std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(),
+            std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+            -1.f, -0.f, 0.f, 1.f, 1.0001f, 2.f, 65504.f, 1e30f, -1e30f, 1e-40f, 0.5f, 0.99999f,
+        };
+        std::uniform_int_distribution<int> pick(0, 3);
+        if (pick(rng) == 0)
+            return specials[std::uniform_int_distribution<size_t>(0, sizeof(specials) / sizeof(specials[0]) - 1)(rng)];
+        return std::uniform_real_distribution<float>(-0.25f, 1.25f)(rng);
+    }
+
+    std::vector<uint8_t> makeSource(PixelConvert::SourceFormat format, int width, int height, size_t pitch, std::mt19937& rng)
+    {
+        std::vector<uint8_t> src(pitch * size_t(height), Fill);
+        for (int y = 0; y < height; ++y)
+        {
+            uint8_t* row = src.data() + pitch * size_t(y);
+            for (int x = 0; x < width * 4; ++x)
+            {
+                switch (format)
+                {
+                case PixelConvert::SourceFormat::RGBA16F:
+                {
+                    const uint16_t half = toHalf(randomFloat(rng));
+                    std::memcpy(row + size_t(x) * 2, &half, 2);
+                    break;
+                }
+                case PixelConvert::SourceFormat::RGBA32F:
+                {
+                    const float value = randomFloat(rng);
+                    std::memcpy(row + size_t(x) * 4, &value, 4);
+                    break;
+                }
+                default:
+                    // Weighted to the ends, where alpha operations and rounding differ most.
+                    static const uint8_t ends[] = { 0, 1, 127, 128, 254, 255 };
+                    row[x] = std::uniform_int_distribution<int>(0, 2)(rng) == 0 ?
+                        ends[std::uniform_int_distribution<int>(0, 5)(rng)] : uint8_t(std::uniform_int_distribution<int>(0, 255)(rng));
+                    break;
+                }
+            }
+        }
+        return src;
+    }
+
+    std::vector<uint8_t> convert(PixelConvert::Isa isa, const PixelConvert::Image& base, size_t frameBytes)
+    {
+        std::vector<uint8_t> dst(frameBytes + GuardBytes, Fill);
+        PixelConvert::Image image = base;
+        image.dst = dst.data();
+        PixelConvert::setActiveIsa(isa);
+        PixelConvert::convert(image);
+        return dst;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool verbose = argc > 1 && std::string(argv[1]) == "--verbose";
+
+    std::vector<PixelConvert::Isa> isas;
+    for (uint32_t isa = uint32_t(PixelConvert::Isa::Scalar) + 1; isa < uint32_t(PixelConvert::Isa::Count); ++isa)
+    {
+        if (PixelConvert::isSupported(PixelConvert::Isa(isa)))
+            isas.push_back(PixelConvert::Isa(isa));
+    }
+    std::printf("Comparing against scalar:");
+    for (PixelConvert::Isa isa : isas)
+        std::printf(" %s", PixelConvert::isaName(isa));
+    std::printf("\n");
+    if (isas.empty())
+        std::printf("No SIMD instruction set is supported here, only the scalar path is checked for overruns\n");
+
+    std::mt19937 rng(20240611);
+    const std::vector<int> allWidths = widths();
+    uint64_t cases = 0;
+    uint64_t failures = 0;
+    for (uint32_t source = 0; source < uint32_t(PixelConvert::SourceFormat::Count); ++source)
+    {
+        const PixelConvert::SourceFormat srcFormat = PixelConvert::SourceFormat(source);
+        for (int height : Heights)
+        {
+            for (int width : allWidths)
+            {
+                // A pitch past the row, so that kernels reading beyond it would pick up the fill.
+                const size_t srcPitch = size_t(width) * PixelConvert::sourceBytesPerPixel(srcFormat) + 12;
+                const std::vector<uint8_t> src = makeSource(srcFormat, width, height, srcPitch, rng);
+
+                for (RSL::SenderPixelFormat format : Formats)
+                {
+                    for (uint32_t op = 0; op < uint32_t(PixelConvert::AlphaOp::Count); ++op)
+                    {
+                        PixelConvert::Image image;
+                        image.src = src.data();
+                        image.srcPitch = srcPitch;
+                        image.srcFormat = srcFormat;
+                        image.dstPitch = PixelConvert::rowBytes(format, width);
+                        image.dstFormat = format;
+                        image.alphaOp = PixelConvert::AlphaOp(op);
+                        image.width = width;
+                        image.height = height;
+                        const size_t frameBytes = PixelConvert::frameBytes(format, width, height);
+
+                        const std::vector<uint8_t> reference = convert(PixelConvert::Isa::Scalar, image, frameBytes);
+                        ++cases;
+                        for (size_t i = frameBytes; i < reference.size(); ++i)
+                        {
+                            if (reference[i] != Fill)
+                            {
+                                std::printf("FAIL scalar %s -> %s %s %dx%d: wrote past the frame at byte %zu\n",
+                                    PixelConvert::sourceFormatName(srcFormat), PixelConvert::formatName(format),
+                                    PixelConvert::alphaOpName(image.alphaOp), width, height, i);
+                                ++failures;
+                                break;
+                            }
+                        }
+
+                        for (PixelConvert::Isa isa : isas)
+                        {
+                            const std::vector<uint8_t> result = convert(isa, image, frameBytes);
+                            ++cases;
+                            if (std::memcmp(result.data(), reference.data(), result.size()) == 0)
+                            {
+                                if (verbose)
+                                    std::printf("ok %s %s -> %s %s %dx%d\n", PixelConvert::isaName(isa), PixelConvert::sourceFormatName(srcFormat),
+                                        PixelConvert::formatName(format), PixelConvert::alphaOpName(image.alphaOp), width, height);
+                                continue;
+                            }
+
+                            size_t first = 0;
+                            while (result[first] == reference[first])
+                                ++first;
+                            std::printf("FAIL %s %s -> %s %s %dx%d: byte %zu of %zu is %02x, scalar gives %02x\n",
+                                PixelConvert::isaName(isa), PixelConvert::sourceFormatName(srcFormat), PixelConvert::formatName(format),
+                                PixelConvert::alphaOpName(image.alphaOp), width, height, first, frameBytes, result[first], reference[first]);
+                            ++failures;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    PixelConvert::setActiveIsa(PixelConvert::detectIsa());
+    std::printf("%llu cases, %llu failed\n", (unsigned long long)cases, (unsigned long long)failures);
+    return failures == 0 ? 0 : 1;
+}
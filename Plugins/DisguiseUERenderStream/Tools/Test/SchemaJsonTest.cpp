@@ -0,0 +1,482 @@
+// Standalone test of schema.json handling: that what SchemaWriter writes SchemaReader and CompiledSchema::parse read
+// back exactly, keys with escapes and non-ASCII characters included, that truncated and malformed schemas are rejected,
+// that scene hashes are the StreamFNV over each key's ANSI bytes that validation computed before the reader existed,
+// and that CompiledSchema::deserialise rejects short and damaged files. Needs neither Unreal nor d3.
+//
+// Build from this directory on Linux (bash):
+//   SRC=../../Source/RenderStream
+//   g++ -std=c++14 -O2 -I$SRC/Private -o SchemaJsonTest SchemaJsonTest.cpp
+//       $SRC/Private/{SchemaJson,CompiledSchema,fnv}.cpp
+// (one command, split here for width)
+//
+// Exits with 0 when every case passes, 1 otherwise. --verbose lists each case as it passes.
+
+#include "CompiledSchema.hpp"
+#include "SchemaJson.hpp"
+#include "fnv.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool g_verbose = false;
+    uint64_t g_cases = 0;
+    uint64_t g_failures = 0;
+
+    bool check(bool passed, const std::string& what)
+    {
+        ++g_cases;
+        if (!passed)
+        {
+            std::printf("FAIL %s\n", what.c_str());
+            ++g_failures;
+        }
+        else if (g_verbose)
+        {
+            std::printf("ok %s\n", what.c_str());
+        }
+        return passed;
+    }
+
+    struct Scene
+    {
+        std::string name;
+        std::vector<std::string> keys;
+        uint32_t nPersistentParameters = 0;
+        uint32_t nLevelParameters = 0;
+        uint64_t hash = 0;
+    };
+
+    // Keeps everything the reader hands over, copied out of its views.
+    class RecordingHandler : public SchemaReader::Handler
+    {
+    public:
+        void beginScene() override { scenes.emplace_back(); }
+        void key(const char* key, size_t size) override { scenes.back().keys.emplace_back(key, size); }
+        void endScene(const char* name, size_t nameSize, uint32_t nPersistentParameters, uint32_t nLevelParameters, uint64_t hash) override
+        {
+            Scene& scene = scenes.back();
+            scene.name.assign(name, nameSize);
+            scene.nPersistentParameters = nPersistentParameters;
+            scene.nLevelParameters = nLevelParameters;
+            scene.hash = hash;
+        }
+
+        std::vector<Scene> scenes;
+    };
+
+    // As validation hashed keys before the reader: each key converted to ANSI and added to one StreamFNV in order. For
+    // ASCII keys the ANSI bytes are the UTF-8 bytes.
+    uint64_t ansiHash(const std::vector<std::string>& keys, size_t count)
+    {
+        StreamFNV fnv;
+        for (size_t i = 0; i < count; ++i)
+            fnv.addData(reinterpret_cast<const unsigned char*>(keys[i].data()), keys[i].size());
+        return fnv.getHash();
+    }
+
+    std::string writeSchema(const std::vector<Scene>& scenes)
+    {
+        SchemaWriter writer;
+        writer.beginSchemas();
+        for (const Scene& scene : scenes)
+        {
+            writer.beginScene(scene.name.c_str());
+            for (const std::string& key : scene.keys)
+            {
+                SchemaParameter parameter;
+                parameter.group = "Gr\"oup\\";
+                parameter.displayName = key.c_str();
+                parameter.key = key.c_str();
+                parameter.min = -0.f;
+                parameter.max = 3.40282347e38f;
+                parameter.step = 1e-7f;
+                writer.beginParameter(parameter);
+                writer.option("first");
+                writer.option("se\"cond\n");
+                writer.endParameter();
+            }
+            writer.endScene(scene.nPersistentParameters, scene.nLevelParameters);
+        }
+        writer.endSchemas();
+        return writer.text();
+    }
+
+    bool sameScenes(const std::vector<Scene>& expected, const std::vector<Scene>& read)
+    {
+        if (expected.size() != read.size())
+            return false;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            if (expected[i].name != read[i].name || expected[i].keys != read[i].keys ||
+                expected[i].nPersistentParameters != read[i].nPersistentParameters || expected[i].nLevelParameters != read[i].nLevelParameters)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool sameScenes(const std::vector<Scene>& expected, const CompiledSchema& compiled)
+    {
+        if (expected.size() != compiled.scenes.size())
+            return false;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            const CompiledSchema::Scene& scene = compiled.scenes[i];
+            if (expected[i].name != scene.name || expected[i].keys.size() != scene.keyCount() ||
+                expected[i].nPersistentParameters != scene.nPersistentParameters || expected[i].nLevelParameters != scene.nLevelParameters)
+            {
+                return false;
+            }
+            for (size_t k = 0; k < scene.keyCount(); ++k)
+            {
+                if (!scene.keyEquals(k, expected[i].keys[k]))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool sameCompiled(const CompiledSchema& a, const CompiledSchema& b)
+    {
+        if (a.sourceSize != b.sourceSize || a.sourceHash != b.sourceHash || a.scenes.size() != b.scenes.size())
+            return false;
+        for (size_t i = 0; i < a.scenes.size(); ++i)
+        {
+            const CompiledSchema::Scene& x = a.scenes[i];
+            const CompiledSchema::Scene& y = b.scenes[i];
+            if (x.name != y.name || x.nPersistentParameters != y.nPersistentParameters || x.nLevelParameters != y.nLevelParameters ||
+                x.hash != y.hash || x.keyData != y.keyData || x.keyEnds != y.keyEnds)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Scene> escapedScenes()
+    {
+        std::vector<Scene> scenes(3);
+        scenes[0].name = "Sc\xc3\xa8ne \"one\"";
+        scenes[0].keys = {
+            "plain_x",
+            "quote\"d",
+            "back\\slash",
+            "control\n\t\r\b\f\x01\x1f",
+            "Gr\xc3\xb6\xc3\x9f" "e_x",                // Two-byte UTF-8
+            "\xe6\xb8\xb2\xe6\x9f\x93",                // Three-byte
+            "camera_\xf0\x9f\x8e\xa5",                 // Four-byte, a surrogate pair when escaped
+            "",
+            "slash/",
+        };
+        scenes[0].nPersistentParameters = 2;
+        scenes[0].nLevelParameters = 7;
+        scenes[1].name = "";
+        scenes[1].nPersistentParameters = 0;
+        scenes[1].nLevelParameters = 0;
+        scenes[2].name = "\xe2\x82\xac";
+        scenes[2].keys = { "plain_x", "quote\"d" };
+        scenes[2].nPersistentParameters = 2;
+        scenes[2].nLevelParameters = 0;
+        return scenes;
+    }
+
+    void testRoundTrip()
+    {
+        const std::vector<Scene> scenes = escapedScenes();
+        const std::string text = writeSchema(scenes);
+
+        SchemaReader reader;
+        RecordingHandler handler;
+        const bool read = reader.read(text.data(), text.size(), handler);
+        check(read, std::string("round trip reads: ") + (reader.error() ? reader.error() : ""));
+        check(sameScenes(scenes, handler.scenes), "round trip keeps names, keys and counts");
+
+        CompiledSchema compiled;
+        std::string error;
+        check(compiled.parse(text.data(), text.size(), error), "round trip compiles: " + error);
+        check(sameScenes(scenes, compiled), "round trip compiles names, keys and counts");
+
+        // The same keys as d3 or a text editor might escape them, with whitespace, a BOM and members the reader skips.
+        const std::string escaped =
+            "\xef\xbb\xbf [ {\n"
+            "  \"extra\": {\"nested\": [1, -2.5e-3, true, false, null, {\"a\": \"\\u0041\"}]},\n"
+            "  \"name\": \"Sc\\u00e8ne \\\"one\\\"\",\n"
+            "  \"parameters\": [\n"
+            "    {\"key\": \"plain_x\", \"min\": -1E+2},\n"
+            "    {\"options\": [\"a\", \"b\"], \"key\": \"quote\\\"d\"},\n"
+            "    {\"key\": \"back\\\\slash\"},\n"
+            "    {\"key\": \"control\\n\\t\\r\\b\\f\\u0001\\u001F\"},\n"
+            "    {\"key\": \"Gr\\u00f6\\u00DFe_x\"},\n"
+            "    {\"key\": \"\\u6e32\\u67d3\"},\n"
+            "    {\"key\": \"camera_\\ud83c\\udfa5\"},\n"
+            "    {\"key\": \"\"},\n"
+            "    {\"key\": \"slash\\/\"}\n"
+            "  ],\n"
+            "  \"nPersistentParameters\": 2, \"nLevelParameters\": 7.0\n"
+            "}, {\"parameters\": [], \"nLevelParameters\": 0, \"nPersistentParameters\": 0e5},\n"
+            "{\"name\": \"\xe2\x82\xac\", \"parameters\": [{\"key\": \"plain_x\"}, {\"key\": \"quote\\u0022d\"}], "
+            "\"nPersistentParameters\": 2, \"nLevelParameters\": 0} ]\r\n";
+        RecordingHandler escapedHandler;
+        check(reader.read(escaped.data(), escaped.size(), escapedHandler), std::string("escaped schema reads: ") + (reader.error() ? reader.error() : ""));
+        check(sameScenes(scenes, escapedHandler.scenes), "escaped schema reads the same names, keys and counts");
+        for (size_t i = 0; i < scenes.size() && i < escapedHandler.scenes.size() && i < handler.scenes.size(); ++i)
+            check(escapedHandler.scenes[i].hash == handler.scenes[i].hash, "escaped scene " + std::to_string(i) + " hashes the unescaped keys");
+
+        // Written again from what was read, the text is the same.
+        check(writeSchema(handler.scenes) == text, "writing what was read gives the same text");
+    }
+
+    void testMalformed()
+    {
+        const std::string valid = writeSchema(escapedScenes());
+        size_t accepted = 0;
+        for (size_t size = 0; size < valid.size(); ++size)
+        {
+            SchemaReader reader;
+            RecordingHandler handler;
+            if (reader.read(valid.data(), size, handler) || !reader.error() || reader.errorOffset() > size)
+                ++accepted;
+        }
+        check(accepted == 0, "every truncation of a " + std::to_string(valid.size()) + " byte schema is rejected (" + std::to_string(accepted) + " accepted)");
+
+        const char* const Malformed[] = {
+            "",
+            "   ",
+            "{}",
+            "[",
+            "[,]",
+            "[{}]",
+            "[1]",
+            "[] x",
+            "[][]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0,}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\",}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\"},], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"min\": 0}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [\"k\"], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": {}, \"nPersistentParameters\": 0, \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": 1}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\q\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\u12g4\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\u12\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\ud83c\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\ud83c\\u0041\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k\\ud83c\\n\"}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [{\"key\": \"k}], \"nPersistentParameters\": 0, \"nLevelParameters\": 1}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": -1, \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 1.5, \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 4294967296, \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": \"1\", \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 1., \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 1e, \"nLevelParameters\": 0}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": tru}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [1 2]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": ]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [1,,2]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [1,]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [,1]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [}}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": {\"a\" 1}}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": {\"a\": 1,}}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": {1: 2}}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": {\"a\": 1 \"b\": 2}}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [[[]]}]",
+            "[{\"name\": \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0, \"x\": [{\"a\": [1]]}}]",
+            "[{\"name\": \"a\" \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0}]",
+            "[{name: \"a\", \"parameters\": [], \"nPersistentParameters\": 0, \"nLevelParameters\": 0}]",
+        };
+        for (const char* text : Malformed)
+        {
+            SchemaReader reader;
+            RecordingHandler handler;
+            const size_t size = std::strlen(text);
+            check(!reader.read(text, size, handler) && reader.error() && reader.errorOffset() <= size, std::string("rejects ") + text);
+        }
+
+        // Nested past any recursion limit, and unterminated.
+        const std::string deep = "[{\"name\": \"a\", \"x\": " + std::string(1000000, '[');
+        SchemaReader reader;
+        RecordingHandler handler;
+        check(!reader.read(deep.data(), deep.size(), handler), "rejects a million unterminated nested arrays");
+
+        // A failed parse leaves the compiled schema as it was.
+        CompiledSchema compiled;
+        std::string error;
+        compiled.parse(valid.data(), valid.size(), error);
+        const CompiledSchema before = compiled;
+        check(!compiled.parse(valid.data(), valid.size() - 1, error) && !error.empty() && sameCompiled(before, compiled),
+            "a failed parse sets the error and keeps the schema");
+    }
+
+    std::string randomAsciiKey(std::mt19937& rng)
+    {
+        // Printable ASCII, quotes and backslashes included, as property names with suffixes and underscores.
+        std::string key;
+        const int length = std::uniform_int_distribution<int>(1, 40)(rng);
+        for (int i = 0; i < length; ++i)
+            key += char(std::uniform_int_distribution<int>(0x20, 0x7e)(rng));
+        if (std::uniform_int_distribution<int>(0, 3)(rng) == 0)
+            key += "_x";
+        return key;
+    }
+
+    void testHash()
+    {
+        std::mt19937 rng(20240702);
+        for (int round = 0; round < 50; ++round)
+        {
+            std::vector<Scene> scenes(size_t(std::uniform_int_distribution<int>(1, 6)(rng)));
+            for (size_t i = 0; i < scenes.size(); ++i)
+            {
+                Scene& scene = scenes[i];
+                scene.name = "Scene " + std::to_string(i);
+                scene.nPersistentParameters = uint32_t(std::uniform_int_distribution<int>(0, 20)(rng));
+                scene.nLevelParameters = uint32_t(std::uniform_int_distribution<int>(0, 60)(rng));
+                for (uint32_t k = 0; k < scene.nPersistentParameters + scene.nLevelParameters; ++k)
+                    scene.keys.push_back(randomAsciiKey(rng));
+            }
+            const std::string text = writeSchema(scenes);
+
+            SchemaReader reader;
+            RecordingHandler handler;
+            CompiledSchema compiled;
+            std::string error;
+            if (!check(reader.read(text.data(), text.size(), handler) && compiled.parse(text.data(), text.size(), error), "random ASCII schema " + std::to_string(round) + " reads"))
+                continue;
+            for (size_t i = 0; i < scenes.size(); ++i)
+            {
+                const std::string name = "random ASCII schema " + std::to_string(round) + " scene " + std::to_string(i);
+                const uint64_t expected = ansiHash(scenes[i].keys, scenes[i].keys.size());
+                check(handler.scenes[i].hash == expected, name + ": reader hash is StreamFNV over the ANSI keys");
+                check(compiled.scenes[i].hash == expected, name + ": compiled hash is StreamFNV over the ANSI keys");
+                bool prefixes = true;
+                for (size_t count = 0; count <= scenes[i].keys.size() + 1; ++count)
+                    prefixes = prefixes && compiled.scenes[i].keysHash(count) == ansiHash(scenes[i].keys, std::min(count, scenes[i].keys.size()));
+                check(prefixes, name + ": keysHash of every prefix is StreamFNV over those ANSI keys");
+            }
+        }
+    }
+
+    void testDeserialise()
+    {
+        const std::string text = writeSchema(escapedScenes());
+        CompiledSchema compiled;
+        std::string error;
+        compiled.parse(text.data(), text.size(), error);
+        compiled.sourceSize = text.size();
+        compiled.sourceHash = fnvHash(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        const std::vector<uint8_t> binary = compiled.serialise();
+
+        CompiledSchema loaded;
+        check(loaded.deserialise(binary.data(), binary.size()) && sameCompiled(compiled, loaded), "deserialise gives back the serialised schema");
+
+        // Something to compare against, so that each rejection can be seen to leave the schema unchanged.
+        CompiledSchema sentinel;
+        sentinel.sourceSize = 1;
+        sentinel.scenes.resize(1);
+        sentinel.scenes[0].name = "sentinel";
+        sentinel.scenes[0].addKey("k", 1);
+
+        size_t accepted = 0;
+        for (size_t size = 0; size < binary.size(); ++size)
+        {
+            // A copy exactly this size, so that reading past it shows up under a sanitiser.
+            const std::vector<uint8_t> shortened(binary.begin(), binary.begin() + ptrdiff_t(size));
+            CompiledSchema schema = sentinel;
+            if (schema.deserialise(shortened.data(), shortened.size()) || !sameCompiled(sentinel, schema))
+                ++accepted;
+        }
+        check(accepted == 0, "every truncation of a " + std::to_string(binary.size()) + " byte compiled schema is rejected (" + std::to_string(accepted) + " accepted)");
+
+        accepted = 0;
+        for (size_t bit = 0; bit < binary.size() * 8; ++bit)
+        {
+            std::vector<uint8_t> flipped = binary;
+            flipped[bit / 8] ^= uint8_t(1u << (bit % 8));
+            CompiledSchema schema = sentinel;
+            if (schema.deserialise(flipped.data(), flipped.size()) || !sameCompiled(sentinel, schema))
+                ++accepted;
+        }
+        check(accepted == 0, "every single bit flip of the compiled schema is rejected (" + std::to_string(accepted) + " accepted)");
+
+        std::vector<uint8_t> extended = binary;
+        extended.push_back(0);
+        CompiledSchema schema = sentinel;
+        check(!schema.deserialise(extended.data(), extended.size()) && sameCompiled(sentinel, schema), "a trailing byte is rejected");
+
+        // Damage that the checksum is recomputed over, as a file from a broken writer would have.
+        const size_t payload = binary.size() - sizeof(uint64_t);
+        const auto resign = [payload](std::vector<uint8_t>& data)
+        {
+            const uint64_t checksum = fnvHash(data.data(), payload);
+            std::memcpy(data.data() + payload, &checksum, sizeof(checksum));
+        };
+        const auto rejects = [&](std::vector<uint8_t> data, const char* what)
+        {
+            resign(data);
+            CompiledSchema damaged = sentinel;
+            check(!damaged.deserialise(data.data(), data.size()) && sameCompiled(sentinel, damaged), std::string("rejects ") + what);
+        };
+        const auto setU32 = [](std::vector<uint8_t>& data, size_t offset, uint32_t value) { std::memcpy(data.data() + offset, &value, sizeof(value)); };
+        const auto getU32 = [](const std::vector<uint8_t>& data, size_t offset) { uint32_t value; std::memcpy(&value, data.data() + offset, sizeof(value)); return value; };
+
+        std::vector<uint8_t> damaged = binary;
+        damaged[7] = '1';
+        rejects(damaged, "another version");
+
+        const size_t sceneCount = 24;   // After the magic, source size and source hash
+        damaged = binary;
+        setU32(damaged, sceneCount, 0xffffffffu);
+        rejects(damaged, "a scene count beyond the file");
+        damaged = binary;
+        setU32(damaged, sceneCount, getU32(binary, sceneCount) + 1);
+        rejects(damaged, "one scene more than the file holds");
+        damaged = binary;
+        setU32(damaged, sceneCount, getU32(binary, sceneCount) - 1);
+        rejects(damaged, "one scene fewer than the file holds");
+
+        const size_t nameLength = sceneCount + 4;
+        damaged = binary;
+        setU32(damaged, nameLength, 0xffffffffu);
+        rejects(damaged, "a name longer than the file");
+
+        // The last scene's key ends run up to the checksum.
+        const CompiledSchema::Scene& last = compiled.scenes.back();
+        const size_t keyEnds = payload - last.keyEnds.size() * 4;
+        const size_t keyCount = keyEnds - 4;
+        damaged = binary;
+        setU32(damaged, keyCount, 0xffffffffu);
+        rejects(damaged, "a key count beyond the file");
+        damaged = binary;
+        setU32(damaged, keyEnds + 4 * (last.keyEnds.size() - 1), uint32_t(last.keyData.size() + 1));
+        rejects(damaged, "a key ending past the scene's key data");
+        damaged = binary;
+        setU32(damaged, keyEnds, last.keyEnds.back());
+        setU32(damaged, keyEnds + 4 * (last.keyEnds.size() - 1), last.keyEnds.front());
+        rejects(damaged, "key ends out of order");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    g_verbose = argc > 1 && std::string(argv[1]) == "--verbose";
+
+    testRoundTrip();
+    testMalformed();
+    testHash();
+    testDeserialise();
+
+    std::printf("%llu cases, %llu failed\n", (unsigned long long)g_cases, (unsigned long long)g_failures);
+    return g_failures == 0 ? 0 : 1;
+}